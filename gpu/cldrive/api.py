@@ -16,7 +16,11 @@
 """Public API for cldrive."""
 import csv
 import io
+import itertools
+import socket
 import subprocess
+import threading
+import typing
 
 import numpy as np
 import pandas as pd
@@ -63,6 +67,172 @@ def Drive(
   return instances
 
 
+def _EncodeVarint(value: int) -> bytes:
+  """Encode a non-negative integer as a base 128 varint."""
+  data = b""
+  while value > 0x7F:
+    data += bytes([(value & 0x7F) | 0x80])
+    value >>= 7
+  return data + bytes([value])
+
+
+def _ReadVarint(stream: typing.BinaryIO) -> typing.Optional[int]:
+  """Read a base 128 varint from a stream, or None at end of stream."""
+  result = 0
+  shift = 0
+  while True:
+    byte = stream.read(1)
+    if not byte:
+      if shift:
+        raise CldriveCrash("Truncated record length")
+      return None
+    result |= (byte[0] & 0x7F) << shift
+    if not byte[0] & 0x80:
+      return result
+    shift += 7
+    if shift >= 64:
+      raise CldriveCrash("Malformed record length")
+
+
+def WriteDelimited(stream: typing.BinaryIO, message) -> None:
+  """Write a message to a stream, prefixed with its size as a varint."""
+  serialized = message.SerializeToString()
+  stream.write(_EncodeVarint(len(serialized)) + serialized)
+
+
+def ReadLogRecords(
+  stream: typing.BinaryIO,
+) -> typing.Iterable[cldrive_pb2.CldriveLogRecord]:
+  """Read length-delimited log records from a stream as they are written.
+
+  This is the reader for the output of `native_driver --stream` and
+  `cldrive --output_format=pbstream`.
+  """
+  while True:
+    size = _ReadVarint(stream)
+    if size is None:
+      return
+    data = stream.read(size)
+    if len(data) != size:
+      raise CldriveCrash("Truncated record")
+    record = cldrive_pb2.CldriveLogRecord()
+    record.ParseFromString(data)
+    yield record
+
+
+def _WriteInstances(
+  stream: typing.BinaryIO,
+  instances: typing.Iterable[cldrive_pb2.CldriveInstance],
+) -> None:
+  """Write instances to the driver's input stream, then close it."""
+  try:
+    for instance in instances:
+      WriteDelimited(stream, instance)
+      stream.flush()
+  except BrokenPipeError:
+    # The driver has terminated. The reader reports the error.
+    pass
+  finally:
+    try:
+      stream.close()
+    except BrokenPipeError:
+      pass
+
+
+def DriveStream(
+  instances: typing.Iterable[cldrive_pb2.CldriveInstance],
+  timeout_seconds: typing.Optional[int] = 300,
+) -> typing.Iterable[cldrive_pb2.CldriveLogRecord]:
+  """Run cldrive on a stream of instances and yield results as they complete.
+
+  Instances are passed to the driver one at a time as they are produced, so
+  `instances` may be a generator of unbounded length, and the first results
+  are available as soon as the first instance has run. Unlike Drive(), the
+  records produced before a timeout or crash are not lost. CldriveCrash is
+  raised once the driver fails. A timeout of None disables the timeout.
+  """
+  instances = iter(instances)
+  first = next(instances, None)
+  if first is None:
+    return
+  instances = itertools.chain([first], instances)
+
+  process = subprocess.Popen(
+    _GetCommand(
+      _NATIVE_DRIVER, cldrive_pb2.CldriveInstances(instance=[first])
+    )
+    + ["--stream"],
+    stdin=subprocess.PIPE,
+    stdout=subprocess.PIPE,
+  )
+  writer = threading.Thread(
+    target=_WriteInstances, args=(process.stdin, instances), daemon=True
+  )
+  writer.start()
+  timer = None
+  if timeout_seconds is not None:
+    timer = threading.Timer(timeout_seconds, process.kill)
+    timer.start()
+  try:
+    yield from ReadLogRecords(process.stdout)
+    process.wait()
+  finally:
+    if timer:
+      timer.cancel()
+    if process.poll() is None:
+      process.kill()
+      process.wait()
+  if process.returncode:
+    raise CldriveCrash(
+      f"Driver terminated with returncode {process.returncode}"
+    )
+
+
+class ServerConnection(object):
+  """A connection to a server started with `cldrive --serve=<socket>`.
+
+  Requests on a connection are run one at a time. Use one connection per
+  thread to run requests concurrently.
+  """
+
+  def __init__(
+    self, socket_path: str, timeout_seconds: typing.Optional[int] = 300
+  ):
+    self._socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    self._socket.settimeout(timeout_seconds)
+    self._socket.connect(socket_path)
+    self._stream = self._socket.makefile("rwb")
+
+  def Drive(
+    self, instance: cldrive_pb2.CldriveInstance
+  ) -> typing.List[cldrive_pb2.CldriveLogRecord]:
+    """Run an instance on the server and return its log records.
+
+    The last record has its instance field set.
+    """
+    WriteDelimited(self._stream, instance)
+    self._stream.flush()
+    records = []
+    try:
+      for record in ReadLogRecords(self._stream):
+        records.append(record)
+        if record.HasField("instance"):
+          return records
+    except socket.timeout:
+      raise CldriveCrash("Timeout waiting for server")
+    raise CldriveCrash("Server closed the connection")
+
+  def close(self) -> None:
+    self._stream.close()
+    self._socket.close()
+
+  def __enter__(self) -> "ServerConnection":
+    return self
+
+  def __exit__(self, *args) -> None:
+    self.close()
+
+
 def DriveToDataFrame(
   instances: cldrive_pb2.CldriveInstances, timeout_seconds: int = 300
 ) -> pd.DataFrame:
@@ -93,6 +263,7 @@ def DriveToDataFrame(
         "transferred_bytes": "Int64",
         "transfer_time_ns": "Int64",
         "kernel_time_ns": "Int64",
+        "host_allocated_bytes": "Int64",
       },
     )
   except subprocess.CalledProcessError as e:
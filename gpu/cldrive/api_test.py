@@ -14,6 +14,8 @@
 # You should have received a copy of the GNU General Public License
 # along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 """Unit tests for //gpu/cldrive:api."""
+import io
+
 import numpy as np
 import pytest
 
@@ -65,6 +67,7 @@ def test_DriveToDataFrame_columns(device: clinfo_pb2.OpenClDevice):
     "transferred_bytes",
     "transfer_time_ns",
     "kernel_time_ns",
+    "host_allocated_bytes",
   ]
 
 
@@ -168,5 +171,66 @@ def test_DriveToDataFrame_device_not_found(device: env.OpenCLEnvironment):
     )
 
 
+def _Delimited(*records) -> bytes:
+  """Encode records in the length-delimited stream format."""
+  stream = io.BytesIO()
+  for record in records:
+    api.WriteDelimited(stream, record)
+  return stream.getvalue()
+
+
+def test_ReadLogRecords_empty_stream():
+  assert list(api.ReadLogRecords(io.BytesIO(b""))) == []
+
+
+def test_ReadLogRecords_records():
+  records = [
+    cldrive_pb2.CldriveLogRecord(
+      instance_num=0,
+      kernel_name="A",
+      run=cldrive_pb2.CldriveKernelRun(
+        outcome=cldrive_pb2.CldriveKernelRun.PASS
+      ),
+    ),
+    cldrive_pb2.CldriveLogRecord(instance_num=1, device_name="x" * 200),
+  ]
+  assert list(api.ReadLogRecords(io.BytesIO(_Delimited(*records)))) == records
+
+
+def test_ReadLogRecords_truncated_record():
+  data = _Delimited(cldrive_pb2.CldriveLogRecord(kernel_name="A"))
+  records = api.ReadLogRecords(io.BytesIO(data + data[:-1]))
+  assert next(records).kernel_name == "A"
+  with test.Raises(api.CldriveCrash):
+    next(records)
+
+
+def test_DriveStream_records(device: clinfo_pb2.OpenClDevice):
+  records = list(
+    api.DriveStream(
+      _MakeInstance(
+        device, "kernel void A(global int* a) { a[get_global_id(0)] *= 2; }"
+      ).instance
+    )
+  )
+  runs = [r for r in records if r.HasField("run")]
+  assert len(runs) == 3  # 3 runs to validate behaviour
+  for record in runs:
+    assert record.kernel_name == "A"
+    assert record.run.outcome == cldrive_pb2.CldriveKernelRun.PASS
+  assert records[-1].HasField("instance")
+
+
+def test_DriveStream_generator(device: clinfo_pb2.OpenClDevice):
+  def Instances():
+    for i in range(3):
+      yield _MakeInstance(
+        device, f"kernel void A{i}(global int* a) {{ a[0] = {i}; }}"
+      ).instance[0]
+
+  records = [r for r in api.DriveStream(Instances()) if r.HasField("instance")]
+  assert [r.instance_num for r in records] == [0, 1, 2]
+
+
 if __name__ == "__main__":
   test.Main()
@@ -0,0 +1,283 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/batch_runner.h"
+
+#include "gpu/cldrive/libcldrive.h"
+#include "gpu/cldrive/mem_analysis_util.h"
+#include "gpu/cldrive/shard_util.h"
+
+#include "labm8/cpp/logging.h"
+
+#include "absl/strings/str_format.h"
+#include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <sstream>
+#include <thread>
+#include <json/json.h>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// Read the contents of a file. Returns false if the file cannot be read.
+bool ReadFile(const string& path, string* contents) {
+  boost::filesystem::ifstream istream{boost::filesystem::path(path)};
+  if (!istream.is_open()) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << istream.rdbuf();
+  *contents = buffer.str();
+  return static_cast<bool>(istream);
+}
+
+}  // anonymous namespace
+
+labm8::StatusOr<std::vector<BatchJob>> ParseBatchJobs(std::istream& istream) {
+  std::vector<BatchJob> jobs;
+  Json::Reader reader;
+  string line;
+  for (int line_num = 1; std::getline(istream, line); ++line_num) {
+    if (line.find_first_not_of(" \t\r") == string::npos) {
+      continue;
+    }
+
+    Json::Value root;
+    if (!reader.parse(line, root, /*collectComments=*/false) ||
+        !root.isObject() || !root["kernel_path"].isString() ||
+        !root["gsize"].isInt() || !root["lsize"].isInt()) {
+      return labm8::Status(
+          labm8::error::Code::INVALID_ARGUMENT,
+          absl::StrFormat("Line %d: expected an object with kernel_path, "
+                          "gsize, and lsize",
+                          line_num));
+    }
+
+    BatchJob job;
+    job.kernel_path = root["kernel_path"].asString();
+    job.global_size = root["gsize"].asInt();
+    job.local_size = root["lsize"].asInt();
+    if (job.global_size <= 0 || job.local_size <= 0 ||
+        job.local_size > job.global_size) {
+      return labm8::Status(
+          labm8::error::Code::INVALID_ARGUMENT,
+          absl::StrFormat("Line %d: must satisfy 0 < lsize <= gsize",
+                          line_num));
+    }
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+BatchRunner::BatchRunner(const BatchRunnerOptions& options,
+                         std::ostream& ostream)
+    : options_(options), ostream_(ostream), num_jobs_(0) {
+  CHECK(!options_.devices.empty()) << "BatchRunner requires a device";
+  CHECK(options_.make_logger) << "BatchRunner requires a logger";
+  for (size_t i = 0; i < options_.devices.size(); ++i) {
+    counters_.push_back(std::make_unique<BatchDeviceCounters>());
+  }
+}
+
+void BatchRunner::RunOrDie(const std::vector<BatchJob>& jobs) {
+  const std::vector<size_t> job_nums = GetShardJobNums(jobs);
+  num_jobs_ = job_nums.size();
+  start_time_ = std::chrono::steady_clock::now();
+  WorkStealingScheduler scheduler(job_nums.size(), options_.devices.size());
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < options_.devices.size(); ++i) {
+    workers.emplace_back(&BatchRunner::RunWorker, this, i, std::cref(jobs),
+                         std::cref(job_nums), &scheduler);
+  }
+
+  // Report progress until the workers are done.
+  std::mutex mutex;
+  std::condition_variable done_condition;
+  bool done = false;
+  std::thread reporter;
+  if (options_.report_interval_seconds > 0) {
+    reporter = std::thread([&]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!done_condition.wait_for(
+          lock, std::chrono::seconds(options_.report_interval_seconds),
+          [&] { return done; })) {
+        LOG(INFO) << ProgressReport();
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (reporter.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+    }
+    done_condition.notify_all();
+    reporter.join();
+  }
+  LOG(INFO) << ProgressReport();
+}
+
+const BatchDeviceCounters& BatchRunner::counters(size_t device) const {
+  return *counters_[device];
+}
+
+string BatchRunner::ProgressReport() const {
+  const double elapsed_s =
+      std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start_time_)
+                   .count(),
+               1e-3);
+
+  int num_done = 0;
+  for (const auto& counters : counters_) {
+    num_done += counters->num_jobs;
+  }
+
+  string report = absl::StrFormat("Completed %d of %d jobs (%.2f jobs/s)",
+                                  num_done, num_jobs_, num_done / elapsed_s);
+  for (size_t i = 0; i < options_.devices.size(); ++i) {
+    const BatchDeviceCounters& counters = *counters_[i];
+    absl::StrAppendFormat(
+        &report,
+        "\n  %s: %d jobs (%d stolen, %d failed, %d skipped), %.2f jobs/s, "
+        "%.0f%% busy",
+        options_.devices[i].name(), counters.num_jobs.load(),
+        counters.num_stolen_jobs.load(), counters.num_failed_jobs.load(),
+        counters.num_skipped_jobs.load(),
+        counters.num_jobs / elapsed_s,
+        100 * counters.busy_time_ms / (1000 * elapsed_s));
+  }
+  return report;
+}
+
+std::vector<size_t> BatchRunner::GetShardJobNums(
+    const std::vector<BatchJob>& jobs) const {
+  std::vector<size_t> job_nums;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    // Jobs whose source cannot be read are kept in every shard, so that the
+    // failure is reported.
+    string opencl_src;
+    if (options_.num_shards == 1 ||
+        !ReadFile(jobs[i].kernel_path, &opencl_src) ||
+        util::GetShard(opencl_src, jobs[i].global_size, jobs[i].local_size,
+                       options_.num_shards) == options_.shard_index) {
+      job_nums.push_back(i);
+    }
+  }
+  return job_nums;
+}
+
+void BatchRunner::RunWorker(size_t device, const std::vector<BatchJob>& jobs,
+                            const std::vector<size_t>& job_nums,
+                            WorkStealingScheduler* scheduler) {
+  BatchDeviceCounters& counters = *counters_[device];
+  size_t i;
+  bool stolen;
+  while (scheduler->Next(device, &i, &stolen)) {
+    const size_t job_num = job_nums[i];
+    auto start = std::chrono::steady_clock::now();
+    if (!RunJob(device, job_num, jobs[job_num])) {
+      ++counters.num_failed_jobs;
+    }
+    counters.busy_time_ms +=
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+    counters.num_stolen_jobs += stolen;
+    ++counters.num_jobs;
+  }
+}
+
+bool BatchRunner::RunJob(size_t device, size_t job_num, const BatchJob& job) {
+  CldriveInstance instance = options_.instance_template;
+  *instance.mutable_device() = options_.devices[device];
+  instance.clear_dynamic_params();
+  DynamicParams* dynamic_params = instance.add_dynamic_params();
+  dynamic_params->set_global_size_x(job.global_size);
+  dynamic_params->set_local_size_x(job.local_size);
+  if (options_.num_shards > 1) {
+    instance.set_shard_index(options_.shard_index);
+  }
+
+  if (!ReadFile(job.kernel_path, instance.mutable_opencl_src())) {
+    LOG(ERROR) << "Failed to read kernel of job " << job_num << ": '"
+               << job.kernel_path << "'";
+    return false;
+  }
+
+  if (options_.results_store && options_.results_store->IsComplete(instance)) {
+    ++counters_[device]->num_skipped_jobs;
+    return true;
+  }
+
+  bool found_mem_analysis;
+  if (options_.mem_analysis_db) {
+    found_mem_analysis =
+        options_.mem_analysis_db->Lookup(instance.opencl_src(), &instance);
+  } else {
+    found_mem_analysis = mem_analysis::setMemAnalysisInfo(
+        job.kernel_path, options_.mem_analysis_dir, &instance);
+  }
+  if (!found_mem_analysis) {
+    LOG(WARNING) << "Memory analysis not found for source file: "
+                 << job.kernel_path
+                 << ". Using default memory analysis setting.";
+  }
+
+  std::stringstream output;
+  {
+    CldriveInstances instances;
+    std::unique_ptr<Logger> logger = options_.make_logger(output, &instances);
+    if (options_.results_store) {
+      // The output is buffered, so the job is marked complete below, once
+      // it has been written.
+      logger = std::make_unique<ResultsStoreLogger>(
+          output, &instances, std::move(logger), options_.results_store,
+          /*mark_complete=*/false);
+    }
+    logger->StartNewInstance(job_num);
+    Cldrive(&instance, job_num, options_.program_cache).RunOrDie(*logger);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ostream_mutex_);
+    ostream_ << output.str();
+    if (!ostream_.flush()) {
+      LOG(ERROR) << "Failed to write the output of job " << job_num;
+      return false;
+    }
+  }
+
+  if (options_.results_store) {
+    auto status = options_.results_store->MarkComplete(instance);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+      return false;
+    }
+  }
+  return instance.outcome() == CldriveInstance::PASS;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
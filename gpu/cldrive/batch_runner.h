@@ -0,0 +1,143 @@
+// Run a batch of kernel jobs over a set of devices.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/mem_analysis_db.h"
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/cldrive/results_store.h"
+#include "gpu/cldrive/work_stealing_scheduler.h"
+#include "gpu/clinfo/proto/clinfo.pb.h"
+
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// A job of a batch: a kernel source file, and the launch config to drive it
+// with.
+struct BatchJob {
+  string kernel_path;
+  int global_size;
+  int local_size;
+};
+
+// Parse a list of jobs in JSON lines format: one object per line, with the
+// keys "kernel_path", "gsize", and "lsize", e.g.
+//     {"kernel_path": "kernels/a.cl", "gsize": 1024, "lsize": 128}
+// Other keys are ignored, and blank lines are skipped.
+labm8::StatusOr<std::vector<BatchJob>> ParseBatchJobs(std::istream& istream);
+
+struct BatchRunnerOptions {
+  // The devices to run the jobs on. Each device has one worker thread.
+  std::vector<::gpu::clinfo::OpenClDevice> devices;
+  // The instance which is run for each job, after setting its source,
+  // device, and dynamic params from the job.
+  CldriveInstance instance_template;
+  // Create the logger for a job. The loggers of jobs are independent, and
+  // their output is written as a whole once the job is complete, so the
+  // logger must not require a header or footer.
+  std::function<std::unique_ptr<Logger>(std::ostream&,
+                                        const CldriveInstances* const)>
+      make_logger;
+  // Optional. If set, the compiled programs are loaded from and stored in
+  // this cache.
+  const ProgramCache* program_cache = nullptr;
+  // The memory analysis of a job's source is looked up in the database if
+  // set, else read from the directory.
+  const MemAnalysisDatabase* mem_analysis_db = nullptr;
+  string mem_analysis_dir;
+  // Optional. If set, the runs of each job are recorded in this store, and
+  // jobs which are already complete in the store are skipped.
+  ResultsStore* results_store = nullptr;
+  // Run only the jobs in this shard of the list, as assigned by
+  // util::GetShard(). Jobs keep their index in the full list.
+  int shard_index = 0;
+  int num_shards = 1;
+  // The interval between progress reports, or zero for none.
+  int report_interval_seconds = 10;
+};
+
+// Live counters of a device's worker.
+struct BatchDeviceCounters {
+  // The number of jobs completed, of which the number stolen from other
+  // devices, the number which failed, i.e. whose source could not be read,
+  // whose instance did not pass, or whose output or completion could not be
+  // recorded, and the number skipped as already complete in the results
+  // store.
+  std::atomic<int> num_jobs{0};
+  std::atomic<int> num_stolen_jobs{0};
+  std::atomic<int> num_failed_jobs{0};
+  std::atomic<int> num_skipped_jobs{0};
+  // The total time spent running jobs.
+  std::atomic<long long> busy_time_ms{0};
+};
+
+// Runs a batch of jobs over a set of devices, with one worker thread per
+// device. Jobs are distributed by a WorkStealingScheduler, so that fast
+// devices take the remaining jobs of slow devices rather than becoming idle.
+// Every job runs on exactly one device. The output of each job is an
+// instance numbered by its index in the list of jobs, and the jobs are
+// written in the order in which they complete.
+class BatchRunner {
+ public:
+  BatchRunner(const BatchRunnerOptions& options, std::ostream& ostream);
+
+  // Run the jobs, and return once every job is complete.
+  void RunOrDie(const std::vector<BatchJob>& jobs);
+
+  // Return the counters of a device. These may be read while jobs are
+  // running.
+  const BatchDeviceCounters& counters(size_t device) const;
+
+  // Return a report of the progress and throughput of each device.
+  string ProgressReport() const;
+
+ private:
+  // Return the indices of the jobs in the shard.
+  std::vector<size_t> GetShardJobNums(const std::vector<BatchJob>& jobs) const;
+
+  void RunWorker(size_t device, const std::vector<BatchJob>& jobs,
+                 const std::vector<size_t>& job_nums,
+                 WorkStealingScheduler* scheduler);
+
+  // Run a job and write its output, then mark it complete in the results
+  // store. Returns false if the job could not be started, its instance did
+  // not pass, or its output or completion could not be recorded.
+  bool RunJob(size_t device, size_t job_num, const BatchJob& job);
+
+  const BatchRunnerOptions options_;
+  std::ostream& ostream_;
+  std::mutex ostream_mutex_;
+  std::vector<std::unique_ptr<BatchDeviceCounters>> counters_;
+  size_t num_jobs_;
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
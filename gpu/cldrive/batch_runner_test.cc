@@ -0,0 +1,74 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/batch_runner.h"
+
+#include "labm8/cpp/test.h"
+
+#include <sstream>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+TEST(ParseBatchJobs, EmptyInput) {
+  std::stringstream input;
+  auto jobs = ParseBatchJobs(input);
+  ASSERT_TRUE(jobs.ok());
+  EXPECT_TRUE(jobs.ValueOrDie().empty());
+}
+
+TEST(ParseBatchJobs, JobsInOrder) {
+  std::stringstream input(
+      "{\"kernel_path\": \"a.cl\", \"gsize\": 1024, \"lsize\": 128}\n"
+      "\n"
+      "{\"kernel_path\": \"b.cl\", \"gsize\": 64, \"lsize\": 64, \"x\": 1}\n");
+  auto jobs = ParseBatchJobs(input);
+  ASSERT_TRUE(jobs.ok());
+  ASSERT_EQ(jobs.ValueOrDie().size(), 2);
+  EXPECT_EQ(jobs.ValueOrDie()[0].kernel_path, "a.cl");
+  EXPECT_EQ(jobs.ValueOrDie()[0].global_size, 1024);
+  EXPECT_EQ(jobs.ValueOrDie()[0].local_size, 128);
+  EXPECT_EQ(jobs.ValueOrDie()[1].kernel_path, "b.cl");
+  EXPECT_EQ(jobs.ValueOrDie()[1].global_size, 64);
+  EXPECT_EQ(jobs.ValueOrDie()[1].local_size, 64);
+}
+
+TEST(ParseBatchJobs, MalformedLine) {
+  std::stringstream input(
+      "{\"kernel_path\": \"a.cl\", \"gsize\": 1024, \"lsize\": 128}\n"
+      "{\"kernel_path\": \"b.cl\"\n");
+  auto jobs = ParseBatchJobs(input);
+  ASSERT_FALSE(jobs.ok());
+  EXPECT_EQ(jobs.status().code(), labm8::error::Code::INVALID_ARGUMENT);
+  EXPECT_NE(jobs.status().ToString().find("Line 2"), string::npos);
+}
+
+TEST(ParseBatchJobs, MissingKey) {
+  std::stringstream input("{\"kernel_path\": \"a.cl\", \"gsize\": 1024}\n");
+  EXPECT_FALSE(ParseBatchJobs(input).ok());
+}
+
+TEST(ParseBatchJobs, LocalSizeLargerThanGlobalSize) {
+  std::stringstream input(
+      "{\"kernel_path\": \"a.cl\", \"gsize\": 64, \"lsize\": 128}\n");
+  EXPECT_FALSE(ParseBatchJobs(input).ok());
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,127 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/bounded_queue.h"
+
+#include "labm8/cpp/test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+TEST(BoundedQueue, PopsInFifoOrder) {
+  BoundedQueue<int> queue(3);
+  ASSERT_TRUE(queue.Push(1));
+  ASSERT_TRUE(queue.Push(2));
+  ASSERT_TRUE(queue.Push(3));
+  EXPECT_EQ(queue.size(), 3);
+
+  int value;
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(value, 1);
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(value, 2);
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(value, 3);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(BoundedQueue, PushBlocksWhileFull) {
+  BoundedQueue<int> queue(1);
+  ASSERT_TRUE(queue.Push(1));
+
+  std::atomic<bool> pushed(false);
+  std::thread producer([&]() {
+    queue.Push(2);
+    pushed = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pushed);
+
+  int value;
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(value, 1);
+  producer.join();
+  EXPECT_TRUE(pushed);
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(value, 2);
+}
+
+TEST(BoundedQueue, CloseDrainsRemainingElements) {
+  BoundedQueue<int> queue(2);
+  ASSERT_TRUE(queue.Push(1));
+  queue.Close();
+  EXPECT_FALSE(queue.Push(2));
+
+  int value;
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(value, 1);
+  EXPECT_FALSE(queue.Pop(&value));
+}
+
+TEST(BoundedQueue, CloseWakesBlockedConsumers) {
+  BoundedQueue<int> queue(1);
+  std::thread consumer([&]() {
+    int value;
+    EXPECT_FALSE(queue.Pop(&value));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.Close();
+  consumer.join();
+}
+
+TEST(BoundedQueue, ManyProducersAndConsumers) {
+  BoundedQueue<int> queue(4);
+  std::atomic<int> sum(0);
+
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < 4; ++i) {
+    consumers.emplace_back([&]() {
+      int value;
+      while (queue.Pop(&value)) {
+        sum += value;
+      }
+    });
+  }
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; ++i) {
+    producers.emplace_back([&]() {
+      for (int j = 1; j <= 1000; ++j) {
+        queue.Push(j);
+      }
+    });
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  queue.Close();
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  EXPECT_EQ(sum, 4 * 500500);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,79 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+// Convert a directory of per-source memory analysis JSON files into a
+// single memory analysis database for cldrive --mem_analysis_db.
+#include "gpu/cldrive/mem_analysis_db.h"
+#include "gpu/cldrive/mem_analysis_util.h"
+
+#include "labm8/cpp/app.h"
+#include "labm8/cpp/logging.h"
+
+#include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
+#include "gflags/gflags.h"
+
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+DEFINE_string(srcs_dir, "",
+              "The directory of OpenCL sources. Every '.cl' file is added to "
+              "the database, keyed by the hash of its content.");
+DEFINE_string(mem_analysis_dir, "mem_analysis_info",
+              "The directory of memory analysis JSON files. The bounds of "
+              "/path/to/file.cl are read from "
+              "/path/to/mem_analysis_info/file.json.");
+DEFINE_string(db, "", "The path of the database to write.");
+
+int main(int argc, char** argv) {
+  labm8::InitApp(&argc, &argv,
+                 "Build a memory analysis database from a directory of "
+                 "memory analysis JSON files.");
+
+  if (FLAGS_srcs_dir.empty() || FLAGS_db.empty()) {
+    LOG(FATAL) << "Flags --srcs_dir and --db must be set";
+  }
+
+  gpu::cldrive::MemAnalysisDatabaseBuilder builder;
+  int num_missing = 0;
+  for (const auto& entry : fs::directory_iterator(FLAGS_srcs_dir)) {
+    const fs::path& path = entry.path();
+    if (!fs::is_regular_file(path) || path.extension() != ".cl") {
+      continue;
+    }
+
+    gpu::cldrive::CldriveInstance instance;
+    if (!gpu::cldrive::mem_analysis::setMemAnalysisInfo(
+            path.string(), FLAGS_mem_analysis_dir, &instance)) {
+      ++num_missing;
+      continue;
+    }
+
+    fs::ifstream istream(path);
+    CHECK(istream.is_open()) << "Failed to open: '" << path.string() << "'";
+    std::stringstream buffer;
+    buffer << istream.rdbuf();
+    builder.Add(buffer.str(), instance.arg_bound());
+  }
+
+  auto status = builder.Write(FLAGS_db);
+  CHECK(status.ok()) << status.ToString();
+  LOG(INFO) << "Wrote " << builder.size() << " sources to " << FLAGS_db
+            << ", skipped " << num_missing
+            << " sources without memory analysis";
+
+  return 0;
+}
@@ -2,7 +2,12 @@
 //
 // Usage summary:
 //   cldrive --srcs=<opencl_sources> --envs=<opencl_devices>
-//       --gsize=<gsize> --lsize=<lsize> --output_format=(txt|pb|pbtxt)
+//       --gsize=<gsize> --lsize=<lsize>
+//       --output_format=(csv|summary|pb|pbtxt|pbstream)
+//
+// To sweep many launch configs in a single process:
+//   cldrive --srcs=<opencl_sources> --dynamic_params=<gsize>:<lsize>,...
+//   cldrive --srcs=<opencl_sources> --sample_dynamic_params=<n>
 //
 // Run with `--help` argument to see full usage options.
 //
@@ -21,8 +26,19 @@
 //
 // You should have received a copy of the GNU General Public License
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/batch_runner.h"
+#include "gpu/cldrive/compile_ahead.h"
+#include "gpu/cldrive/csv_log.h"
+#include "gpu/cldrive/dynamic_params_util.h"
+#include "gpu/cldrive/fork_server.h"
 #include "gpu/cldrive/libcldrive.h"
+#include "gpu/cldrive/mem_analysis_db.h"
 #include "gpu/cldrive/mem_analysis_util.h"
+#include "gpu/cldrive/opencl_context_pool.h"
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/cldrive/results_store.h"
+#include "gpu/cldrive/server.h"
+#include "gpu/cldrive/shard_util.h"
 
 #include "gpu/cldrive/logger.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
@@ -31,11 +47,13 @@
 #include "labm8/cpp/app.h"
 #include "labm8/cpp/logging.h"
 
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_split.h"
 #include "boost/filesystem.hpp"
 #include "boost/filesystem/fstream.hpp"
 #include "gflags/gflags.h"
 
+#include <signal.h>
 #include <sstream>
 #include <json/json.h>
 
@@ -85,17 +103,11 @@ DEFINE_string(mem_analysis_dir, "mem_analysis_info", "The directory to store the
                                                       "each source file corresponds to a json file with same name in this directory. "
                                                       "Example: if the source file is /path/to/file.cl, "
                                                       "then the memory analysis file is /path/to/mem_analysis_info/file.json");
-static bool ValidateMemAnalysis(const char* flagname, const string& value) {
-  for (auto str_path : SplitCommaSeparated(FLAGS_srcs)) {
-    if (!gpu::cldrive::mem_analysis::isMemAnalysisFileExists(str_path, value)) {
-      LOG(WARNING) << "Memory analysis file not found for source file: " << str_path << ". Using default memory analysis setting."
-                   << ". Please run clmem first to generate the memory analysis file, then put it in " << value << " directory.";
-    }
-  }
-
-  return true;
-}
-DEFINE_validator(mem_analysis_dir, &ValidateMemAnalysis);
+DEFINE_string(mem_analysis_db, "",
+              "A memory analysis database built by build_mem_analysis_db. If "
+              "set, the memory analysis of each source is looked up in the "
+              "database by the hash of its content, and --mem_analysis_dir "
+              "is ignored.");
 
 DEFINE_string(envs, "",
               "A comma separated list of OpenCL devices to use. Use "
@@ -119,11 +131,17 @@ static bool ValidateEnvs(const char* flagname, const string& value) {
 DEFINE_validator(envs, &ValidateEnvs);
 
 DEFINE_string(output_format, "csv",
-              "The output format. One of: {csv,pb,pbtxt}.");
+              "The output format. One of: {csv,summary,pb,pbtxt,pbstream}. "
+              "summary writes one CSV row per kernel and launch config, with "
+              "statistics of the kernel and transfer times of its runs. "
+              "pbstream writes a stream of length-delimited CldriveLogRecord "
+              "messages as results are produced.");
 static bool ValidateOutputFormat(const char* flagname, const string& value) {
-  if (value.compare("csv") && value.compare("pb") && value.compare("pbtxt")) {
+  if (value.compare("csv") && value.compare("summary") &&
+      value.compare("pb") && value.compare("pbtxt") &&
+      value.compare("pbstream")) {
     LOG(FATAL) << "Illegal value for --" << flagname << ". Must be one of: "
-               << "{csv,pb,pbtxt}";
+               << "{csv,summary,pb,pbtxt,pbstream}";
   }
   return true;
 }
@@ -134,9 +152,133 @@ DEFINE_int32(gsize, 1024,
              "are allocated and transferred for array arguments, and this many "
              "work items are instantiated.");
 DEFINE_int32(lsize, 128, "The local (work group) size. Must be <= gsize.");
+DEFINE_string(dynamic_params, "",
+              "A comma separated list of <gsize>:<lsize> launch configs, e.g. "
+              "'1024:128,4096:256'. If set, --gsize and --lsize are ignored. "
+              "All launch configs of a kernel are run against a single "
+              "compiled program, with buffers allocated once for the largest "
+              "config.");
+static bool ValidateDynamicParams(const char* flagname, const string& value) {
+  auto dynamic_params = gpu::cldrive::util::ParseDynamicParamsList(value);
+  if (!dynamic_params.ok()) {
+    LOG(FATAL) << "Illegal value for --" << flagname << ": "
+               << dynamic_params.status().error_message();
+  }
+  return true;
+}
+DEFINE_validator(dynamic_params, &ValidateDynamicParams);
+DEFINE_int32(sample_dynamic_params, 0,
+             "If > 0, sample a sweep of launch configs in the same manner as "
+             "run_cldrive.py, using this many work group counts per sampled "
+             "local size. If set, --gsize, --lsize, and --dynamic_params are "
+             "ignored.");
+DEFINE_string(sample_lsizes, "",
+              "A comma separated list of candidate local sizes for "
+              "--sample_dynamic_params. If not provided, the multiples of 32 "
+              "in [32, 992] are used.");
+DEFINE_int32(sample_num_lsizes, 4,
+             "The number of local sizes to sample for "
+             "--sample_dynamic_params.");
+DEFINE_int32(sample_num_compute_units, 72,
+             "The number of compute units of the target device, used to pick "
+             "the ranges of work group counts for --sample_dynamic_params.");
+DEFINE_int32(sample_max_gsize, 9999999,
+             "The largest global size sampled by --sample_dynamic_params.");
+DEFINE_int32(sample_seed, 2610,
+             "The random seed for --sample_dynamic_params.");
+DEFINE_uint64(seed, 0,
+              "The seed for the random values of global memory arguments. "
+              "Runs with the same seed use the same inputs.");
+DEFINE_bool(device_init, false,
+            "Initialize global memory arguments on the device rather than "
+            "uploading them from the host. Values are identical to those "
+            "generated on the host for the same --seed.");
 DEFINE_string(cl_build_opt, "", "Build options passed to clBuildProgram().");
 DEFINE_int32(num_runs, 30, "The number of runs per kernel.");
+DEFINE_string(program_cache_dir, "",
+              "If set, compiled program binaries and compilation failures are "
+              "cached in this directory, which may be shared by concurrent "
+              "cldrive processes.");
+DEFINE_double(warmup_tolerance, 0.05,
+              "Before the timed runs, each kernel is run until the kernel "
+              "times of two successive runs differ by no more than this "
+              "fraction.");
+DEFINE_int32(max_warmup_runs, 10,
+             "The maximum number of warmup runs per kernel.");
+DEFINE_double(target_ci_width, 0,
+              "If greater than zero, continue running each kernel beyond "
+              "--num_runs until the 95% confidence interval of the median "
+              "kernel time is narrower than this fraction of the median, "
+              "bounded by --max_num_runs and --max_run_time_ms.");
+DEFINE_int32(max_num_runs, 1000,
+             "The maximum number of runs per kernel when --target_ci_width "
+             "is set.");
+DEFINE_int64(max_run_time_ms, 0,
+             "The time budget in milliseconds for the runs of each launch "
+             "config when --target_ci_width is set, or zero for no limit.");
 DEFINE_bool(clinfo, false, "List the available devices and exit.");
+DEFINE_bool(pipelined, false,
+            "Enqueue the transfers and kernel of each run without blocking, "
+            "synchronizing once at the end of the run.");
+DEFINE_bool(isolate, false,
+            "Run each source on each device in a child process forked from "
+            "cldrive, so that a kernel which crashes or hangs is recorded with "
+            "a CRASH or TIMEOUT outcome, and the remaining sources are run.");
+DEFINE_int32(compile_ahead_threads, 0,
+             "The number of threads which read and build the next sources "
+             "while the current source runs, so that compilation overlaps "
+             "execution. If zero, each source is built before it is run. "
+             "Cannot be combined with --isolate.");
+DEFINE_int32(compile_ahead_depth, 4,
+             "With --compile_ahead_threads, the maximum number of sources "
+             "which are built ahead of the source which is running.");
+DEFINE_int32(timeout_seconds, 0,
+             "With --isolate, the time limit for building each program, and "
+             "for running each kernel, or zero for no limit.");
+DEFINE_string(serve, "",
+              "If set, run a server which listens on this Unix domain socket "
+              "for length-delimited CldriveInstance requests, and responds to "
+              "each with a stream of length-delimited CldriveLogRecord "
+              "messages. The contexts of the --envs devices, and the programs "
+              "built for requests, are kept for the lifetime of the server. "
+              "The server runs until interrupted. --srcs is not used.");
+DEFINE_int32(serve_workers, 1,
+             "The number of requests which --serve runs concurrently.");
+DEFINE_int32(serve_queue_size, 64,
+             "The maximum number of requests waiting for a --serve worker. "
+             "Once full, clients block until a worker is free.");
+DEFINE_int32(serve_program_pool_size, 256,
+             "The maximum number of built programs which --serve keeps in "
+             "memory.");
+DEFINE_string(results_db, "",
+              "If set, record the runs of each kernel in this SQLite "
+              "database, which is created if it does not exist. Sources "
+              "which have already been run on a device, with the same build "
+              "options, launch configs, and device driver version, are "
+              "skipped, so that an interrupted batch can be resumed by "
+              "running the same command again. The output format must be "
+              "csv, summary, or pbstream.");
+DEFINE_int32(num_shards, 1,
+             "Split the sources and launch configs into this many shards, "
+             "and run only the shard --shard_index. Shards are assigned by "
+             "a consistent hash of the source content and launch config, so "
+             "they are balanced, and a source keeps its shard as sources are "
+             "added to the corpus. Instances keep their numbering across "
+             "shards, so the outputs of the shards may be concatenated.");
+DEFINE_int32(shard_index, 0, "The shard to run, in [0, --num_shards).");
+DEFINE_string(jobs, "",
+              "If set, run the jobs listed in this file rather than --srcs. "
+              "The file is in JSON lines format, with one object per line of "
+              "the form {\"kernel_path\": <path>, \"gsize\": <int>, "
+              "\"lsize\": <int>}. Each job is run on one of the --envs "
+              "devices, with one worker per device. Devices which finish "
+              "their share of the jobs steal jobs from the others. The output "
+              "format must be csv, summary, or pbstream, and jobs are written "
+              "in the order in which they complete, numbered by their "
+              "position in the file.");
+DEFINE_int32(jobs_report_seconds, 10,
+             "The interval between progress reports of --jobs, or zero for "
+             "none.");
 
 // End flag definitions ------------------------------------
 
@@ -151,8 +293,13 @@ std::unique_ptr<Logger> MakeLoggerFromFlags(
   } else if (!FLAGS_output_format.compare("pbtxt")) {
     return std::make_unique<ProtocolBufferLogger>(std::cout, instances,
                                                   /*text_format=*/true);
+  } else if (!FLAGS_output_format.compare("pbstream")) {
+    return std::make_unique<StreamingProtocolBufferLogger>(std::cout,
+                                                           instances);
   } else if (!FLAGS_output_format.compare("csv")) {
     return std::make_unique<CsvLogger>(std::cout, instances);
+  } else if (!FLAGS_output_format.compare("summary")) {
+    return std::make_unique<SummaryLogger>(std::cout, instances);
   } else {
     CHECK(false) << "unreachable!";
     return nullptr;
@@ -185,6 +332,204 @@ std::vector<::gpu::clinfo::OpenClDevice> GetDevicesFromCommaSeparatedString(
   return devices;
 }
 
+// Construct the launch configs to drive each kernel with from the
+// --sample_dynamic_params, --dynamic_params, and --gsize/--lsize flags, in
+// that order of precedence.
+std::vector<gpu::cldrive::DynamicParams> GetDynamicParamsFromFlags() {
+  if (FLAGS_sample_dynamic_params > 0) {
+    gpu::cldrive::util::DynamicParamsSampleOptions options;
+    for (auto lsize_str : SplitCommaSeparated(FLAGS_sample_lsizes)) {
+      int lsize;
+      CHECK(absl::SimpleAtoi(lsize_str, &lsize))
+          << "Illegal value for --sample_lsizes: '" << lsize_str << "'";
+      options.local_sizes.push_back(lsize);
+    }
+    if (options.local_sizes.empty()) {
+      for (int i = 1; i < 32; ++i) {
+        options.local_sizes.push_back(32 * i);
+      }
+    }
+    options.num_local_sizes = FLAGS_sample_num_lsizes;
+    options.num_work_group_sizes = FLAGS_sample_dynamic_params;
+    options.num_compute_units = FLAGS_sample_num_compute_units;
+    options.max_global_size = FLAGS_sample_max_gsize;
+    options.seed = FLAGS_sample_seed;
+    return gpu::cldrive::util::SampleDynamicParams(options);
+  }
+
+  if (!FLAGS_dynamic_params.empty()) {
+    return gpu::cldrive::util::ParseDynamicParamsList(FLAGS_dynamic_params)
+        .ValueOrDie();
+  }
+
+  gpu::cldrive::DynamicParams dynamic_params;
+  dynamic_params.set_global_size_x(FLAGS_gsize);
+  dynamic_params.set_local_size_x(FLAGS_lsize);
+  return {dynamic_params};
+}
+
+// Set the options of an instance from flags.
+void SetInstanceOptionsFromFlags(gpu::cldrive::CldriveInstance* instance) {
+  instance->set_build_opts(FLAGS_cl_build_opt);
+  for (const auto& dynamic_params : GetDynamicParamsFromFlags()) {
+    *instance->add_dynamic_params() = dynamic_params;
+  }
+  instance->set_min_runs_per_kernel(FLAGS_num_runs);
+  instance->set_warmup_tolerance(FLAGS_warmup_tolerance);
+  instance->set_max_warmup_runs(FLAGS_max_warmup_runs);
+  instance->set_seed(FLAGS_seed);
+  instance->set_device_init(FLAGS_device_init);
+  instance->set_target_relative_ci_width(FLAGS_target_ci_width);
+  instance->set_max_runs_per_kernel(FLAGS_max_num_runs);
+  instance->set_max_run_time_ms_per_dynamic_params(FLAGS_max_run_time_ms);
+  instance->set_pipelined(FLAGS_pipelined);
+}
+
+// Open the --results_db store, or return nullptr if the flag is not set.
+std::unique_ptr<gpu::cldrive::ResultsStore> OpenResultsStoreFromFlags() {
+  std::unique_ptr<gpu::cldrive::ResultsStore> results_store;
+  if (!FLAGS_results_db.empty()) {
+    // Sources are marked complete once their output has been written, so the
+    // output must not be held until exit.
+    CHECK(FLAGS_output_format.compare("pb") &&
+          FLAGS_output_format.compare("pbtxt"))
+        << "--results_db requires --output_format=csv, "
+        << "--output_format=summary, or --output_format=pbstream";
+    auto status =
+        gpu::cldrive::ResultsStore::Open(FLAGS_results_db, &results_store);
+    CHECK(status.ok()) << status.ToString();
+  }
+  return results_store;
+}
+
+// Run the batch of jobs listed in the --jobs file.
+int RunJobsOrDie() {
+  CHECK(!FLAGS_output_format.compare("csv") ||
+        !FLAGS_output_format.compare("summary") ||
+        !FLAGS_output_format.compare("pbstream"))
+      << "--jobs requires --output_format=csv, --output_format=summary, or "
+      << "--output_format=pbstream";
+  CHECK(!FLAGS_isolate) << "--jobs cannot be combined with --isolate";
+
+  std::vector<gpu::cldrive::BatchJob> jobs;
+  {
+    boost::filesystem::ifstream istream{boost::filesystem::path(FLAGS_jobs)};
+    CHECK(istream.is_open()) << "Failed to open: '" << FLAGS_jobs << "'";
+    auto jobs_or = gpu::cldrive::ParseBatchJobs(istream);
+    CHECK(jobs_or.ok()) << "Failed to parse '" << FLAGS_jobs
+                        << "': " << jobs_or.status().error_message();
+    jobs = jobs_or.ValueOrDie();
+  }
+
+  std::unique_ptr<gpu::cldrive::ProgramCache> program_cache;
+  if (!FLAGS_program_cache_dir.empty()) {
+    program_cache =
+        std::make_unique<gpu::cldrive::ProgramCache>(FLAGS_program_cache_dir);
+  }
+
+  std::unique_ptr<gpu::cldrive::MemAnalysisDatabase> mem_analysis_db;
+  if (!FLAGS_mem_analysis_db.empty()) {
+    auto status = gpu::cldrive::MemAnalysisDatabase::Open(
+        FLAGS_mem_analysis_db, &mem_analysis_db);
+    CHECK(status.ok()) << status.ToString();
+  }
+
+  std::unique_ptr<gpu::cldrive::ResultsStore> results_store =
+      OpenResultsStoreFromFlags();
+
+  gpu::cldrive::BatchRunnerOptions options;
+  options.devices = GetDevicesFromCommaSeparatedString(FLAGS_envs);
+  SetInstanceOptionsFromFlags(&options.instance_template);
+  options.program_cache = program_cache.get();
+  options.mem_analysis_db = mem_analysis_db.get();
+  options.mem_analysis_dir = FLAGS_mem_analysis_dir;
+  options.results_store = results_store.get();
+  options.shard_index = FLAGS_shard_index;
+  options.num_shards = FLAGS_num_shards;
+  options.report_interval_seconds = FLAGS_jobs_report_seconds;
+  if (!FLAGS_output_format.compare("csv")) {
+    std::cout << gpu::cldrive::CsvLogHeader();
+    options.make_logger =
+        [](std::ostream& ostream,
+           const gpu::cldrive::CldriveInstances* const instances) {
+          return std::unique_ptr<gpu::cldrive::Logger>(
+              new gpu::cldrive::CsvLogger(ostream, instances,
+                                          /*print_header=*/false));
+        };
+  } else if (!FLAGS_output_format.compare("summary")) {
+    std::cout << gpu::cldrive::CsvSummaryLogHeader();
+    options.make_logger =
+        [](std::ostream& ostream,
+           const gpu::cldrive::CldriveInstances* const instances) {
+          return std::unique_ptr<gpu::cldrive::Logger>(
+              new gpu::cldrive::SummaryLogger(ostream, instances,
+                                              /*print_header=*/false));
+        };
+  } else {
+    options.make_logger =
+        [](std::ostream& ostream,
+           const gpu::cldrive::CldriveInstances* const instances) {
+          return std::unique_ptr<gpu::cldrive::Logger>(
+              new gpu::cldrive::StreamingProtocolBufferLogger(ostream,
+                                                              instances));
+        };
+  }
+
+  gpu::cldrive::BatchRunner(options, std::cout).RunOrDie(jobs);
+
+  gpu::cldrive::OpenClContextPool::Get().Clear();
+  return 0;
+}
+
+// Run a server until SIGINT or SIGTERM is received.
+int ServeOrDie() {
+  // Block the signals before starting the server threads, so that they are
+  // delivered to the main thread's sigwait().
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  CHECK(!pthread_sigmask(SIG_BLOCK, &signals, nullptr));
+
+  std::unique_ptr<gpu::cldrive::ProgramCache> program_cache;
+  if (!FLAGS_program_cache_dir.empty()) {
+    program_cache =
+        std::make_unique<gpu::cldrive::ProgramCache>(FLAGS_program_cache_dir);
+  }
+
+  std::unique_ptr<gpu::cldrive::MemAnalysisDatabase> mem_analysis_db;
+  if (!FLAGS_mem_analysis_db.empty()) {
+    auto status = gpu::cldrive::MemAnalysisDatabase::Open(
+        FLAGS_mem_analysis_db, &mem_analysis_db);
+    CHECK(status.ok()) << status.ToString();
+  }
+
+  gpu::cldrive::CldriveServerOptions options;
+  options.socket_path = FLAGS_serve;
+  options.num_workers = FLAGS_serve_workers;
+  options.max_queue_size = FLAGS_serve_queue_size;
+  options.program_pool_size = FLAGS_serve_program_pool_size;
+  options.devices = GetDevicesFromCommaSeparatedString(FLAGS_envs);
+  options.program_cache = program_cache.get();
+  options.mem_analysis_db = mem_analysis_db.get();
+
+  {
+    // The server must be destroyed before the contexts are released, as it
+    // owns the pool of programs built in them.
+    gpu::cldrive::CldriveServer server(options);
+    auto status = server.Start();
+    CHECK(status.ok()) << status.ToString();
+
+    int signal;
+    sigwait(&signals, &signal);
+    LOG(INFO) << "Received signal " << signal << ", shutting down";
+    server.Shutdown();
+  }
+
+  gpu::cldrive::OpenClContextPool::Get().Clear();
+  return 0;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -200,6 +545,18 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (!FLAGS_serve.empty()) {
+    return ServeOrDie();
+  }
+
+  const auto shard_status =
+      gpu::cldrive::util::ValidateShard(FLAGS_shard_index, FLAGS_num_shards);
+  CHECK(shard_status.ok()) << shard_status.error_message();
+
+  if (!FLAGS_jobs.empty()) {
+    return RunJobsOrDie();
+  }
+
   // Check that required flags are set. We can't check this in the flag
   // validator functions as they are only required if the early-exit flags
   // above are not set.
@@ -212,36 +569,111 @@ int main(int argc, char** argv) {
   // Create instances proto.
   gpu::cldrive::CldriveInstances instances;
   gpu::cldrive::CldriveInstance* instance = instances.add_instance();
-  instance->set_build_opts(FLAGS_cl_build_opt);
-  auto dp = instance->add_dynamic_params();
-  dp->set_global_size_x(FLAGS_gsize);
-  dp->set_local_size_x(FLAGS_lsize);
-  instance->set_min_runs_per_kernel(FLAGS_num_runs);
+  SetInstanceOptionsFromFlags(instance);
 
   // Parse logger flag.
   std::unique_ptr<gpu::cldrive::Logger> logger =
       gpu::cldrive::MakeLoggerFromFlags(std::cout, &instances);
 
-  int instance_num = 0;
-  for (auto path : SplitCommaSeparated(FLAGS_srcs)) {
-    std::map<int,int> memAnalysis = gpu::cldrive::mem_analysis::getMemAnalysisInfo(path, FLAGS_mem_analysis_dir, FLAGS_gsize, FLAGS_lsize);
-    
-    logger->StartNewInstance();
-    instance->set_opencl_src(ReadFileOrDie(path));
-    instance->set_mem_filepath(gpu::cldrive::mem_analysis::getMemAnalysisFilePath(path, FLAGS_mem_analysis_dir).string());
+  std::unique_ptr<gpu::cldrive::ResultsStore> results_store =
+      OpenResultsStoreFromFlags();
+  if (results_store) {
+    logger = std::make_unique<gpu::cldrive::ResultsStoreLogger>(
+        std::cout, &instances, std::move(logger), results_store.get());
+  }
 
-    for (size_t i = 0; i < devices.size(); ++i) {
-      // Reset fields from previous loop iterations.
-      instance->clear_outcome();
-      instance->clear_kernel();
+  std::unique_ptr<gpu::cldrive::ProgramCache> program_cache;
+  if (!FLAGS_program_cache_dir.empty()) {
+    program_cache =
+        std::make_unique<gpu::cldrive::ProgramCache>(FLAGS_program_cache_dir);
+  }
 
-      *instance->mutable_device() = devices[i];
+  std::unique_ptr<gpu::cldrive::MemAnalysisDatabase> mem_analysis_db;
+  if (!FLAGS_mem_analysis_db.empty()) {
+    auto status = gpu::cldrive::MemAnalysisDatabase::Open(
+        FLAGS_mem_analysis_db, &mem_analysis_db);
+    CHECK(status.ok()) << status.ToString();
+  }
 
-      gpu::cldrive::Cldrive(instance, instance_num).RunOrDie(*logger);
+  std::unique_ptr<gpu::cldrive::ForkServer> fork_server;
+  if (FLAGS_isolate) {
+    gpu::cldrive::ForkServerOptions options;
+    options.timeout_seconds = FLAGS_timeout_seconds;
+    options.program_cache = program_cache.get();
+    fork_server = std::make_unique<gpu::cldrive::ForkServer>(options);
+  }
+
+  // Prepare each source on each device, reading the source and its memory
+  // analysis, and skipping those which are not in the shard or are complete.
+  const std::vector<string> paths = SplitCommaSeparated(FLAGS_srcs);
+  const gpu::cldrive::CldriveInstance instance_options = *instance;
+  auto prepare = [&](int instance_num, size_t device_num,
+                     gpu::cldrive::CldriveInstance* prepared) {
+    const string& path = paths[instance_num];
+    *prepared = instance_options;
+    prepared->set_opencl_src(ReadFileOrDie(path));
+    if (!gpu::cldrive::util::ShardDynamicParams(FLAGS_shard_index,
+                                                FLAGS_num_shards, prepared)) {
+      return false;
     }
 
-    ++instance_num;
+    bool found_mem_analysis;
+    if (mem_analysis_db) {
+      found_mem_analysis =
+          mem_analysis_db->Lookup(prepared->opencl_src(), prepared);
+    } else {
+      found_mem_analysis = gpu::cldrive::mem_analysis::setMemAnalysisInfo(
+          path, FLAGS_mem_analysis_dir, prepared);
+    }
+    if (!found_mem_analysis && !device_num) {
+      LOG(WARNING) << "Memory analysis not found for source file: " << path
+                   << ". Using default memory analysis setting. Please run "
+                   << "clmem first to generate the memory analysis file.";
+    }
+
+    *prepared->mutable_device() = devices[device_num];
+
+    if (results_store && results_store->IsComplete(*prepared)) {
+      LOG(INFO) << "Skipping completed source " << path << " on device "
+                << devices[device_num].name();
+      return false;
+    }
+    return true;
+  };
+
+  // A child process builds its own program, and must not be forked while
+  // other threads are running.
+  CHECK(!FLAGS_isolate || !FLAGS_compile_ahead_threads)
+      << "--compile_ahead_threads cannot be combined with --isolate";
+  gpu::cldrive::CompileAheadOptions compile_ahead_options;
+  compile_ahead_options.num_threads = FLAGS_compile_ahead_threads;
+  compile_ahead_options.max_prepared = FLAGS_compile_ahead_depth;
+  compile_ahead_options.build_programs = !fork_server;
+  compile_ahead_options.program_cache = program_cache.get();
+
+  {
+    gpu::cldrive::CompileAheadPipeline pipeline(
+        compile_ahead_options, paths.size(), devices.size(), prepare);
+
+    gpu::cldrive::PreparedInstance prepared;
+    int instance_num = -1;
+    while (pipeline.Next(&prepared)) {
+      if (prepared.instance_num != instance_num) {
+        instance_num = prepared.instance_num;
+        logger->StartNewInstance(instance_num);
+      }
+      *instance = std::move(prepared.instance);
+
+      if (fork_server) {
+        fork_server->RunOrDie(instance, instance_num, *logger);
+      } else {
+        gpu::cldrive::Cldrive(instance, instance_num, program_cache.get())
+            .RunOrDie(*logger, prepared.program);
+      }
+    }
   }
 
+  gpu::cldrive::OpenClContextPool::Get().Clear();
+
   return 0;
 }
@@ -0,0 +1,125 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/compile_ahead.h"
+
+#include "gpu/cldrive/libcldrive.h"
+
+#include "labm8/cpp/logging.h"
+
+#include <algorithm>
+
+namespace gpu {
+namespace cldrive {
+
+CompileAheadPipeline::CompileAheadPipeline(const CompileAheadOptions& options,
+                                           int num_instances,
+                                           size_t num_devices,
+                                           PrepareFunction prepare)
+    : options_(options),
+      num_devices_(num_devices),
+      num_items_(std::max(num_instances, 0) * num_devices),
+      prepare_(prepare),
+      stopped_(false),
+      next_item_(0),
+      next_taken_(0) {
+  CHECK(options_.num_threads >= 0) << "Number of threads must be >= 0";
+  CHECK(options_.max_prepared > 0) << "Max prepared instances must be > 0";
+  for (int i = 0; i < options_.num_threads; ++i) {
+    workers_.emplace_back(&CompileAheadPipeline::RunWorker, this);
+  }
+}
+
+CompileAheadPipeline::~CompileAheadPipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  item_taken_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+bool CompileAheadPipeline::Next(PreparedInstance* prepared) {
+  while (true) {
+    Item item;
+    if (workers_.empty()) {
+      if (next_taken_ == num_items_) {
+        return false;
+      }
+      item = Prepare(next_taken_++);
+    } else {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (next_taken_ == num_items_) {
+        return false;
+      }
+      item_ready_.wait(lock, [this] { return ready_.count(next_taken_); });
+      auto it = ready_.find(next_taken_);
+      item = std::move(it->second);
+      ready_.erase(it);
+      ++next_taken_;
+      lock.unlock();
+      item_taken_.notify_all();
+    }
+
+    if (item.run) {
+      *prepared = std::move(item.prepared);
+      return true;
+    }
+  }
+}
+
+CompileAheadPipeline::Item CompileAheadPipeline::Prepare(
+    size_t item_num) const {
+  Item item;
+  item.prepared.instance_num = item_num / num_devices_;
+  item.run = prepare_(item.prepared.instance_num, item_num % num_devices_,
+                      &item.prepared.instance);
+  if (item.run && options_.build_programs) {
+    item.prepared.program =
+        BuildProgram(item.prepared.instance, options_.program_cache);
+  }
+  return item;
+}
+
+void CompileAheadPipeline::RunWorker() {
+  while (true) {
+    size_t item_num;
+    {
+      // Wait until the item is within max_prepared of the consumer.
+      std::unique_lock<std::mutex> lock(mutex_);
+      item_taken_.wait(lock, [this] {
+        return stopped_ ||
+               next_item_ < next_taken_ + options_.max_prepared;
+      });
+      if (stopped_ || next_item_ == num_items_) {
+        return;
+      }
+      item_num = next_item_++;
+    }
+
+    Item item = Prepare(item_num);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_.emplace(item_num, std::move(item));
+    }
+    item_ready_.notify_all();
+  }
+}
+
+}  // namespace cldrive
+}  // namespace gpu
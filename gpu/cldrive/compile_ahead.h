@@ -0,0 +1,111 @@
+// A pipeline which reads and builds sources ahead of running them.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/statusor.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// A source on a device, ready to be run.
+struct PreparedInstance {
+  int instance_num = 0;
+  CldriveInstance instance;
+  // The program of the instance, if the pipeline builds programs.
+  labm8::StatusOr<cl::Program> program;
+};
+
+struct CompileAheadOptions {
+  // The number of threads which prepare instances. If zero, each instance is
+  // prepared by the thread which calls Next().
+  int num_threads = 0;
+  // The maximum number of instances which are prepared ahead of the instance
+  // returned by Next().
+  int max_prepared = 4;
+  // Whether to build the program of each instance once it is prepared.
+  bool build_programs = true;
+  const ProgramCache* program_cache = nullptr;
+};
+
+// A bounded producer/consumer pipeline over every source on every device.
+// Worker threads prepare instances ahead of the consumer, e.g. reading the
+// source and its memory analysis, and build their programs, so that the
+// compilation of the next sources overlaps the execution of the current one.
+// The consumer receives the instances in order, so the output of a run does
+// not depend on the number of workers.
+class CompileAheadPipeline {
+ public:
+  // Set the source and device of an instance from its instance and device
+  // numbers. Returns false if the instance should not be run. This is called
+  // concurrently from the workers, so it must be thread-safe.
+  using PrepareFunction =
+      std::function<bool(int instance_num, size_t device_num,
+                         CldriveInstance* instance)>;
+
+  CompileAheadPipeline(const CompileAheadOptions& options, int num_instances,
+                       size_t num_devices, PrepareFunction prepare);
+
+  // Stop and join the workers. Instances which have not been returned by
+  // Next() are discarded.
+  ~CompileAheadPipeline();
+
+  // Get the next instance to run, in order of instance and device number,
+  // blocking until it is prepared. Instances which should not be run are
+  // skipped. Returns false once every instance has been returned.
+  bool Next(PreparedInstance* prepared);
+
+ private:
+  struct Item {
+    bool run;
+    PreparedInstance prepared;
+  };
+
+  Item Prepare(size_t item_num) const;
+  void RunWorker();
+
+  const CompileAheadOptions options_;
+  const size_t num_devices_;
+  const size_t num_items_;
+  const PrepareFunction prepare_;
+
+  std::mutex mutex_;
+  std::condition_variable item_ready_;
+  std::condition_variable item_taken_;
+  bool stopped_;
+  // The next item to prepare, and the next item to return from Next().
+  size_t next_item_;
+  size_t next_taken_;
+  std::map<size_t, Item> ready_;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
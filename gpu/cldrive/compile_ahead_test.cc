@@ -0,0 +1,130 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/compile_ahead.h"
+
+#include "labm8/cpp/test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+// Options which prepare instances without building programs, so that no
+// OpenCL device is needed.
+CompileAheadOptions PrepareOnlyOptions(int num_threads, int max_prepared) {
+  CompileAheadOptions options;
+  options.num_threads = num_threads;
+  options.max_prepared = max_prepared;
+  options.build_programs = false;
+  return options;
+}
+
+// Record the instance and device numbers in the instance.
+bool SetSource(int instance_num, size_t device_num,
+               CldriveInstance* instance) {
+  instance->set_opencl_src(std::to_string(instance_num) + ":" +
+                           std::to_string(device_num));
+  return true;
+}
+
+std::vector<string> TakeAll(CompileAheadPipeline* pipeline) {
+  std::vector<string> sources;
+  PreparedInstance prepared;
+  while (pipeline->Next(&prepared)) {
+    sources.push_back(prepared.instance.opencl_src());
+  }
+  return sources;
+}
+
+TEST(CompileAheadPipeline, PreparesInOrderWithoutThreads) {
+  CompileAheadPipeline pipeline(PrepareOnlyOptions(0, 1), 2, 2, SetSource);
+  EXPECT_EQ(TakeAll(&pipeline),
+            std::vector<string>({"0:0", "0:1", "1:0", "1:1"}));
+}
+
+TEST(CompileAheadPipeline, ReturnsInOrderWithThreads) {
+  // Later instances are prepared faster, so they finish out of order.
+  auto prepare = [](int instance_num, size_t device_num,
+                    CldriveInstance* instance) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 - instance_num));
+    return SetSource(instance_num, device_num, instance);
+  };
+  CompileAheadPipeline pipeline(PrepareOnlyOptions(4, 8), 10, 1, prepare);
+
+  std::vector<string> expected;
+  for (int i = 0; i < 10; ++i) {
+    expected.push_back(std::to_string(i) + ":0");
+  }
+  EXPECT_EQ(TakeAll(&pipeline), expected);
+}
+
+TEST(CompileAheadPipeline, SkipsInstancesWhichShouldNotRun) {
+  auto prepare = [](int instance_num, size_t device_num,
+                    CldriveInstance* instance) {
+    SetSource(instance_num, device_num, instance);
+    return instance_num != 1 && device_num != 0;
+  };
+  CompileAheadPipeline pipeline(PrepareOnlyOptions(2, 2), 3, 2, prepare);
+
+  PreparedInstance prepared;
+  ASSERT_TRUE(pipeline.Next(&prepared));
+  EXPECT_EQ(prepared.instance_num, 0);
+  EXPECT_EQ(prepared.instance.opencl_src(), "0:1");
+  ASSERT_TRUE(pipeline.Next(&prepared));
+  EXPECT_EQ(prepared.instance_num, 2);
+  EXPECT_EQ(prepared.instance.opencl_src(), "2:1");
+  EXPECT_FALSE(pipeline.Next(&prepared));
+}
+
+TEST(CompileAheadPipeline, PreparesAtMostMaxPreparedAhead) {
+  std::atomic<int> num_prepared(0);
+  auto prepare = [&num_prepared](int instance_num, size_t device_num,
+                                 CldriveInstance* instance) {
+    ++num_prepared;
+    return SetSource(instance_num, device_num, instance);
+  };
+  CompileAheadPipeline pipeline(PrepareOnlyOptions(4, 3), 100, 1, prepare);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(num_prepared, 3);
+
+  PreparedInstance prepared;
+  ASSERT_TRUE(pipeline.Next(&prepared));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(num_prepared, 4);
+}
+
+TEST(CompileAheadPipeline, StopsWithInstancesRemaining) {
+  CompileAheadPipeline pipeline(PrepareOnlyOptions(2, 2), 100, 4, SetSource);
+  PreparedInstance prepared;
+  ASSERT_TRUE(pipeline.Next(&prepared));
+}
+
+TEST(CompileAheadPipeline, NoInstances) {
+  CompileAheadPipeline pipeline(PrepareOnlyOptions(2, 2), 0, 4, SetSource);
+  PreparedInstance prepared;
+  EXPECT_FALSE(pipeline.Next(&prepared));
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -17,6 +17,8 @@
 
 #include "labm8/cpp/logging.h"
 
+#include "absl/strings/str_format.h"
+
 #include <iostream>
 
 namespace gpu {
@@ -52,7 +54,8 @@ std::ostream& NullIfNegative(std::ostream& stream, const T& value) {
 std::ostream& operator<<(std::ostream& stream, const CsvLogHeader& header) {
   stream << "instance,device,build_opts,kernel,work_item_local_mem_size,"
          << "work_item_private_mem_size,global_size,local_size,outcome,"
-         << "transferred_bytes,transfer_time_ns,kernel_time_ns,args_info\n";
+         << "transferred_bytes,transfer_time_ns,kernel_time_ns,"
+         << "host_allocated_bytes,args_info\n";
   return stream;
 }
 
@@ -64,7 +67,8 @@ CsvLog::CsvLog(int instance_id)
       local_size_(-1),
       transferred_bytes_(-1),
       transfer_time_ns_(-1),
-      kernel_time_ns_(-1) {
+      kernel_time_ns_(-1),
+      host_allocated_bytes_(-1) {
   CHECK(instance_id >= 0) << "Negative instance ID not allowed";
 }
 
@@ -79,6 +83,7 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
   NullIfNegative(stream, log.transferred_bytes_) << ",";
   NullIfNegative(stream, log.transfer_time_ns_) << ",";
   NullIfNegative(stream, log.kernel_time_ns_) << ",";
+  NullIfNegative(stream, log.host_allocated_bytes_) << ",";
   stream << "\""; NullIfEmpty(stream, log.args_) << "\"" << std::endl;
   return stream;
 }
@@ -95,7 +100,9 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
   csv.build_opts_ = instance->build_opts();
 
   csv.outcome_ = CldriveInstance::InstanceOutcome_Name(instance->outcome());
-  csv.args_ = log->args_info();
+  if (log) {
+    csv.args_ = log->args_info();
+  }
   if (kernel_instance) {
     csv.kernel_ = kernel_instance->name();
     csv.work_item_local_mem_size_ =
@@ -115,7 +122,120 @@ std::ostream& operator<<(std::ostream& stream, const CsvLog& log) {
           csv.kernel_time_ns_ = log->kernel_time_ns();
           csv.transfer_time_ns_ = log->transfer_time_ns();
           csv.transferred_bytes_ = log->transferred_bytes();
+          if (log->has_host_allocated_bytes()) {
+            csv.host_allocated_bytes_ = log->host_allocated_bytes();
+          }
+        }
+      }
+    }
+  }
+
+  return csv;
+}
+
+namespace {
+
+// The columns of a SummaryStatistics, with the given prefix.
+void PrintSummaryStatisticsHeader(std::ostream& stream, const string& prefix) {
+  for (const char* column :
+       {"min", "max", "mean", "median", "p5", "p95", "stddev", "mad"}) {
+    stream << "," << prefix << "_" << column;
+  }
+}
+
+void PrintSummaryStatistics(std::ostream& stream,
+                            const util::SummaryStatistics& stats,
+                            bool has_stats) {
+  if (!has_stats) {
+    stream << ",,,,,,,,";
+    return;
+  }
+  // Print in fixed point, as times in nanoseconds may exceed the default
+  // precision of the stream.
+  for (double value : {stats.min, stats.max, stats.mean, stats.median,
+                       stats.p5, stats.p95, stats.stddev, stats.mad}) {
+    stream << absl::StrFormat(",%.1f", value);
+  }
+}
+
+}  // anonymous namespace
+
+std::ostream& operator<<(std::ostream& stream,
+                         const CsvSummaryLogHeader& header) {
+  stream << "instance,device,build_opts,kernel,work_item_local_mem_size,"
+         << "work_item_private_mem_size,global_size,local_size,outcome,"
+         << "num_runs,transferred_bytes";
+  PrintSummaryStatisticsHeader(stream, "kernel_time_ns");
+  PrintSummaryStatisticsHeader(stream, "transfer_time_ns");
+  stream << "\n";
+  return stream;
+}
+
+CsvSummaryLog::CsvSummaryLog(int instance_id)
+    : instance_id_(instance_id),
+      work_item_local_mem_size_(-1),
+      work_item_private_mem_size_(-1),
+      global_size_(-1),
+      local_size_(-1),
+      num_runs_(-1),
+      transferred_bytes_(-1) {
+  CHECK(instance_id >= 0) << "Negative instance ID not allowed";
+}
+
+std::ostream& operator<<(std::ostream& stream, const CsvSummaryLog& log) {
+  stream << log.instance_id_ << "," << log.device_ << "," << log.build_opts_
+         << ",";
+  NullIfEmpty(stream, log.kernel_) << ",";
+  NullIfNegative(stream, log.work_item_local_mem_size_) << ",";
+  NullIfNegative(stream, log.work_item_private_mem_size_) << ",";
+  NullIfNegative(stream, log.global_size_) << ",";
+  NullIfNegative(stream, log.local_size_) << "," << log.outcome_ << ",";
+  NullIfNegative(stream, log.num_runs_) << ",";
+  NullIfNegative(stream, log.transferred_bytes_);
+  const bool has_stats = log.num_runs_ > 0;
+  PrintSummaryStatistics(stream, log.kernel_time_ns_, has_stats);
+  PrintSummaryStatistics(stream, log.transfer_time_ns_, has_stats);
+  stream << std::endl;
+  return stream;
+}
+
+/*static*/ CsvSummaryLog CsvSummaryLog::FromProtos(
+    int instance_id, const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  CsvSummaryLog csv(instance_id);
+
+  CHECK(instance) << "CldriveInstance pointer cannot be null";
+  csv.device_ = instance->device().name();
+  csv.build_opts_ = instance->build_opts();
+
+  csv.outcome_ = CldriveInstance::InstanceOutcome_Name(instance->outcome());
+  if (kernel_instance) {
+    csv.kernel_ = kernel_instance->name();
+    csv.work_item_local_mem_size_ =
+        kernel_instance->work_item_local_mem_size_in_bytes();
+    csv.work_item_private_mem_size_ =
+        kernel_instance->work_item_private_mem_size_in_bytes();
+
+    csv.outcome_ = CldriveKernelInstance::KernelInstanceOutcome_Name(
+        kernel_instance->outcome());
+    if (run) {
+      csv.outcome_ = CldriveKernelRun::KernelRunOutcome_Name(run->outcome());
+      if (run->has_dynamic_params()) {
+        csv.global_size_ = run->dynamic_params().global_size_x();
+        csv.local_size_ = run->dynamic_params().local_size_x();
+      }
+      if (run->outcome() == CldriveKernelRun::PASS && run->log_size()) {
+        std::vector<labm8::int64> kernel_times;
+        std::vector<labm8::int64> transfer_times;
+        for (const auto& log : run->log()) {
+          kernel_times.push_back(log.kernel_time_ns());
+          transfer_times.push_back(log.transfer_time_ns());
         }
+        csv.num_runs_ = run->log_size();
+        csv.transferred_bytes_ = run->log(0).transferred_bytes();
+        csv.kernel_time_ns_ = util::GetSummaryStatistics(kernel_times);
+        csv.transfer_time_ns_ = util::GetSummaryStatistics(transfer_times);
       }
     }
   }
@@ -16,6 +16,7 @@
 #pragma once
 
 #include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/cldrive/statistics.h"
 #include "labm8/cpp/port.h"
 #include "labm8/cpp/string.h"
 
@@ -97,6 +98,61 @@ class CsvLog {
   labm8::int64 transferred_bytes_;
   labm8::int64 transfer_time_ns_;
   labm8::int64 kernel_time_ns_;
+  labm8::int64 host_allocated_bytes_;
+
+  // End CSV columns (in order) -----------------------------------
+};
+
+// A class which prints the header values for a summary CSV row.
+//
+// Usage:
+//    std::cout << CsvSummaryLogHeader();
+class CsvSummaryLogHeader {
+  // Format CSV header to output stream.
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const CsvSummaryLogHeader& log);
+};
+
+// A class which formats a CSV row summarizing the runs of a kernel with one
+// dynamic params, in place of one CsvLog row per run.
+//
+// Usage:
+//    CsvSummaryLog::FromProtos log(...);
+//    std::cout << log;
+class CsvSummaryLog {
+ public:
+  CsvSummaryLog(int instance_id);
+
+  // Create a log from proto messages. The kernel instance and run may be
+  // null, in which case the outcome is that of the instance or kernel.
+  static CsvSummaryLog FromProtos(
+      int instance_id, const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run);
+
+  // Format CSV to output stream.
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const CsvSummaryLog& log);
+
+ private:
+  // Begin CSV columns (in order) -----------------------------------
+
+  // As for CsvLog.
+  int instance_id_;
+  string device_;
+  string build_opts_;
+  string kernel_;
+  int work_item_local_mem_size_;
+  int work_item_private_mem_size_;
+  int global_size_;
+  int local_size_;
+  string outcome_;
+
+  // From CldriveKernelRun.log. If outcome != PASS, these will be empty.
+  labm8::int64 num_runs_;
+  labm8::int64 transferred_bytes_;
+  util::SummaryStatistics kernel_time_ns_;
+  util::SummaryStatistics transfer_time_ns_;
 
   // End CSV columns (in order) -----------------------------------
 };
@@ -104,6 +160,8 @@ class CsvLog {
 //
 std::ostream& operator<<(std::ostream& stream, const CsvLogHeader& log);
 std::ostream& operator<<(std::ostream& stream, const CsvLog& log);
+std::ostream& operator<<(std::ostream& stream, const CsvSummaryLogHeader& log);
+std::ostream& operator<<(std::ostream& stream, const CsvSummaryLog& log);
 
 }  // namespace cldrive
 }  // namespace gpu
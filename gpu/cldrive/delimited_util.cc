@@ -0,0 +1,79 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/delimited_util.h"
+
+#include "google/protobuf/io/coded_stream.h"
+
+#include <string>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+bool WriteDelimited(const google::protobuf::MessageLite& message,
+                    std::ostream* ostream) {
+  std::string buffer;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&buffer);
+    google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    coded_stream.WriteVarint32(message.ByteSizeLong());
+    if (!message.SerializeToCodedStream(&coded_stream)) {
+      return false;
+    }
+  }
+  ostream->write(buffer.data(), buffer.size());
+  return static_cast<bool>(*ostream);
+}
+
+DelimitedReader::DelimitedReader(std::istream* istream)
+    : input_(new google::protobuf::io::IstreamInputStream(istream)),
+      error_(false) {}
+
+DelimitedReader::DelimitedReader(int fd)
+    : input_(new google::protobuf::io::FileInputStream(fd)), error_(false) {}
+
+bool DelimitedReader::Next(google::protobuf::MessageLite* message) {
+  if (error_) {
+    return false;
+  }
+
+  // A new coded stream per message, so that the total bytes limit of a coded
+  // stream does not bound the length of the stream.
+  google::protobuf::io::CodedInputStream coded_stream(input_.get());
+
+  google::protobuf::uint32 size;
+  if (!coded_stream.ReadVarint32(&size)) {
+    // A clean end of stream leaves no bytes behind the last message.
+    error_ = coded_stream.CurrentPosition() != 0;
+    return false;
+  }
+
+  auto limit = coded_stream.PushLimit(size);
+  if (!message->ParseFromCodedStream(&coded_stream) ||
+      !coded_stream.ConsumedEntireMessage() ||
+      coded_stream.BytesUntilLimit()) {
+    error_ = true;
+    return false;
+  }
+  coded_stream.PopLimit(limit);
+  return true;
+}
+
+bool DelimitedReader::error() const { return error_; }
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
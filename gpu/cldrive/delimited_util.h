@@ -0,0 +1,64 @@
+// Utility code for streams of length-delimited protocol buffers.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/message_lite.h"
+
+#include <iostream>
+#include <memory>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// Write a message to a stream, prefixed with its size in bytes as a varint.
+// This is the format of Java's writeDelimitedTo() and Python's
+// _VarintBytes(size) + SerializeToString(). Returns false on error.
+bool WriteDelimited(const google::protobuf::MessageLite& message,
+                    std::ostream* ostream);
+
+// Reads a stream of length-delimited messages, as written by
+// WriteDelimited(). Messages are read on demand, so a reader may consume a
+// stream as it is produced.
+class DelimitedReader {
+ public:
+  // Read from a stream. The stream is read in blocks, so a message is not
+  // returned until a full block has arrived or the stream has ended. Read
+  // pipes which are written incrementally using the file descriptor
+  // constructor.
+  explicit DelimitedReader(std::istream* istream);
+
+  // Read from a file descriptor, such as a pipe or socket. The descriptor is
+  // not closed by the reader.
+  explicit DelimitedReader(int fd);
+
+  // Read the next message. Returns false at the end of the stream, or if the
+  // stream is truncated or malformed, in which case error() is true.
+  bool Next(google::protobuf::MessageLite* message);
+
+  bool error() const;
+
+ private:
+  std::unique_ptr<google::protobuf::io::ZeroCopyInputStream> input_;
+  bool error_;
+};
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,149 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/delimited_util.h"
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/test.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <future>
+#include <sstream>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+namespace {
+
+DynamicParams MakeDynamicParams(int global_size, int local_size) {
+  DynamicParams params;
+  params.set_global_size_x(global_size);
+  params.set_local_size_x(local_size);
+  return params;
+}
+
+TEST(DelimitedReader, EmptyStream) {
+  std::stringstream stream;
+  DelimitedReader reader(&stream);
+  DynamicParams params;
+  EXPECT_FALSE(reader.Next(&params));
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(DelimitedReader, ReadsWrittenMessages) {
+  std::stringstream stream;
+  ASSERT_TRUE(WriteDelimited(MakeDynamicParams(1024, 128), &stream));
+  ASSERT_TRUE(WriteDelimited(DynamicParams(), &stream));
+  ASSERT_TRUE(WriteDelimited(MakeDynamicParams(4096, 256), &stream));
+
+  DelimitedReader reader(&stream);
+  DynamicParams params;
+  ASSERT_TRUE(reader.Next(&params));
+  EXPECT_EQ(params.global_size_x(), 1024);
+  EXPECT_EQ(params.local_size_x(), 128);
+  ASSERT_TRUE(reader.Next(&params));
+  EXPECT_FALSE(params.has_global_size_x());
+  ASSERT_TRUE(reader.Next(&params));
+  EXPECT_EQ(params.global_size_x(), 4096);
+  EXPECT_EQ(params.local_size_x(), 256);
+  EXPECT_FALSE(reader.Next(&params));
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(DelimitedReader, TruncatedMessageIsError) {
+  std::stringstream written;
+  ASSERT_TRUE(WriteDelimited(MakeDynamicParams(1024, 128), &written));
+  ASSERT_TRUE(WriteDelimited(MakeDynamicParams(4096, 256), &written));
+  const std::string bytes = written.str();
+  std::stringstream stream(bytes.substr(0, bytes.size() - 1));
+
+  DelimitedReader reader(&stream);
+  DynamicParams params;
+  ASSERT_TRUE(reader.Next(&params));
+  EXPECT_FALSE(reader.Next(&params));
+  EXPECT_TRUE(reader.error());
+}
+
+TEST(DelimitedReader, ReadsFromFileDescriptor) {
+  std::stringstream written;
+  ASSERT_TRUE(WriteDelimited(MakeDynamicParams(1024, 128), &written));
+  ASSERT_TRUE(WriteDelimited(MakeDynamicParams(4096, 256), &written));
+  const std::string bytes = written.str();
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], bytes.data(), bytes.size()), bytes.size());
+  close(fds[1]);
+
+  DelimitedReader reader(fds[0]);
+  DynamicParams params;
+  ASSERT_TRUE(reader.Next(&params));
+  EXPECT_EQ(params.global_size_x(), 1024);
+  ASSERT_TRUE(reader.Next(&params));
+  EXPECT_EQ(params.global_size_x(), 4096);
+  EXPECT_FALSE(reader.Next(&params));
+  EXPECT_FALSE(reader.error());
+  close(fds[0]);
+}
+
+TEST(DelimitedReader, ReadsFromFileDescriptorWhichIsStillOpen) {
+  std::stringstream written;
+  ASSERT_TRUE(WriteDelimited(MakeDynamicParams(1024, 128), &written));
+  const std::string bytes = written.str();
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], bytes.data(), bytes.size()), bytes.size());
+
+  // The message must be returned without waiting for more input, or for the
+  // writer to close the pipe.
+  DelimitedReader reader(fds[0]);
+  DynamicParams params;
+  auto next = std::async(std::launch::async,
+                         [&reader, &params] { return reader.Next(&params); });
+  const auto status = next.wait_for(std::chrono::seconds(10));
+  close(fds[1]);
+  ASSERT_EQ(status, std::future_status::ready);
+  ASSERT_TRUE(next.get());
+  EXPECT_EQ(params.global_size_x(), 1024);
+  EXPECT_FALSE(reader.Next(&params));
+  EXPECT_FALSE(reader.error());
+  close(fds[0]);
+}
+
+TEST(DelimitedReader, ManyMessages) {
+  std::stringstream stream;
+  for (int i = 1; i <= 100000; ++i) {
+    ASSERT_TRUE(WriteDelimited(MakeDynamicParams(i, 1), &stream));
+  }
+
+  DelimitedReader reader(&stream);
+  DynamicParams params;
+  int num_messages = 0;
+  while (reader.Next(&params)) {
+    EXPECT_EQ(params.global_size_x(), ++num_messages);
+  }
+  EXPECT_EQ(num_messages, 100000);
+  EXPECT_FALSE(reader.error());
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
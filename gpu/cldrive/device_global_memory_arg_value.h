@@ -0,0 +1,189 @@
+// Global memory argument values which are initialized on the device.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/device_random_fill.h"
+#include "gpu/cldrive/global_memory_arg_value.h"
+#include "gpu/cldrive/kernel_arg_value.h"
+#include "gpu/cldrive/opencl_type.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace cldrive {
+
+// An array value which has only a device-side buffer. Instead of uploading
+// host values, CopyToDevice() re-initializes the buffer on the device, either
+// by filling it with a single value, or by generating random values with a
+// kernel. A host-side copy is only made when reading the value back from the
+// device.
+template <typename T>
+class DeviceGlobalMemoryArgValue : public KernelArgValue {
+ public:
+  // Create a value with every element set to value.
+  DeviceGlobalMemoryArgValue(const cl::Context &context, size_t size,
+                             const T &value)
+      : buffer_(context, /*flags=*/CL_MEM_READ_WRITE,
+                /*size=*/sizeof(T) * size),
+        size_(size),
+        active_size_(size),
+        value_(value),
+        rand_values_(false),
+        seed_(0),
+        stream_(0) {}
+
+  // Create a value with random elements generated by a kernel returned by
+  // util::CreateRandomFillKernel().
+  DeviceGlobalMemoryArgValue(const cl::Context &context, size_t size,
+                             const cl::Kernel &random_fill_kernel,
+                             labm8::uint64 seed, labm8::uint32 stream)
+      : buffer_(context, /*flags=*/CL_MEM_READ_WRITE,
+                /*size=*/sizeof(T) * size),
+        size_(size),
+        active_size_(size),
+        value_(),
+        rand_values_(true),
+        random_fill_kernel_(random_fill_kernel),
+        seed_(seed),
+        stream_(stream) {}
+
+  cl::Buffer &buffer() { return buffer_; }
+
+  // Two values are equal if they initialize the same number of elements in
+  // the same way.
+  virtual bool operator==(const KernelArgValue *const rhs) const override {
+    auto other = dynamic_cast<const DeviceGlobalMemoryArgValue *const>(rhs);
+    if (!other || Size() != other->Size() ||
+        rand_values_ != other->rand_values_) {
+      return false;
+    }
+    if (rand_values_) {
+      return seed_ == other->seed_ && stream_ == other->stream_;
+    }
+    return opencl_type::Equal(value_, other->value_);
+  }
+
+  virtual bool operator!=(const KernelArgValue *const rhs) const override {
+    return !(*this == rhs);
+  }
+
+  virtual size_t Size() const override { return active_size_; }
+
+  virtual void SetActiveSize(size_t size) override {
+    CHECK(size <= size_) << "Active size " << size
+                         << " exceeds allocated size " << size_;
+    active_size_ = size;
+  }
+
+  virtual void SetAsArg(cl::Kernel *kernel, size_t arg_index) override {
+    kernel->setArg(arg_index, buffer());
+  }
+
+  // Initialization replaces the upload, so its time is counted as transfer
+  // time, but no bytes are transferred.
+  virtual void CopyToDevice(const cl::CommandQueue &queue,
+                            ProfilingData *profiling) override {
+    cl::Event event;
+    EnqueueInit(queue, &event);
+    profiling->transfer_nanoseconds += GetElapsedNanoseconds(event);
+  }
+
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) override {
+    cl::Event event;
+    EnqueueInit(queue, &event);
+    profiling->transfer_events.push_back(event);
+  }
+
+  virtual std::unique_ptr<KernelArgValue> CopyFromDevice(
+      const cl::CommandQueue &queue, ProfilingData *profiling) override {
+    auto new_arg = std::make_unique<GlobalMemoryArgValue<T>>(size_);
+    profiling->host_allocated_bytes += sizeof(T) * size_;
+    CopyFromDeviceInto(queue, new_arg.get(), profiling);
+    return std::move(new_arg);
+  }
+
+  virtual void CopyFromDeviceInto(const cl::CommandQueue &queue,
+                                  KernelArgValue *value,
+                                  ProfilingData *profiling) override {
+    auto output = PrepareOutput(value, profiling);
+    util::CopyDeviceToHost(queue, buffer(), output->vector().data(),
+                           SizeInBytes(), profiling);
+  }
+
+  virtual void EnqueueCopyFromDeviceInto(const cl::CommandQueue &queue,
+                                         const std::vector<cl::Event> &events,
+                                         KernelArgValue *value,
+                                         ProfilingData *profiling) override {
+    auto output = PrepareOutput(value, profiling);
+    util::EnqueueCopyDeviceToHost(queue, buffer(), output->vector().data(),
+                                  SizeInBytes(), events, profiling);
+  }
+
+  virtual string ToString() const override {
+    if (rand_values_) {
+      return absl::StrCat("<", Size(), " random elements, seed ", seed_,
+                          ", stream ", stream_, ">");
+    }
+    return absl::StrCat("<", Size(), " elements of ",
+                        opencl_type::ToString(value_), ">");
+  }
+
+  virtual size_t SizeInBytes() const override { return sizeof(T) * Size(); }
+
+ private:
+  void EnqueueInit(const cl::CommandQueue &queue, cl::Event *event) {
+    if (rand_values_) {
+      util::EnqueueRandomFill(queue, &random_fill_kernel_, buffer(), Size(),
+                              seed_, stream_, event);
+    } else {
+      queue.enqueueFillBuffer(buffer(), value_, /*offset=*/0, SizeInBytes(),
+                              /*events=*/nullptr, event);
+    }
+  }
+
+  // Size the host storage of an output value to hold the active elements.
+  GlobalMemoryArgValue<T> *PrepareOutput(KernelArgValue *value,
+                                         ProfilingData *profiling) {
+    auto output = dynamic_cast<GlobalMemoryArgValue<T> *>(value);
+    CHECK(output) << "Cannot copy global memory into a different value type";
+
+    if (output->vector().size() < Size()) {
+      output->vector().resize(Size());
+      profiling->host_allocated_bytes += SizeInBytes();
+    }
+    output->SetActiveSize(Size());
+    return output;
+  }
+
+  cl::Buffer buffer_;
+  size_t size_;
+  size_t active_size_;
+  T value_;
+  bool rand_values_;
+  cl::Kernel random_fill_kernel_;
+  labm8::uint64 seed_;
+  labm8::uint32 stream_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,115 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/device_global_memory_arg_value.h"
+
+#include "gpu/cldrive/device_random_fill.h"
+#include "gpu/cldrive/global_memory_arg_value.h"
+#include "gpu/cldrive/opencl_type_util.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+class DeviceGlobalMemoryArgValueTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    try {
+      context_ = cl::Context::getDefault();
+      queue_ = cl::CommandQueue(context_,
+                                /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+    } catch (cl::Error err) {
+      CHECK(false)
+          << "OpenCL exception in DeviceGlobalMemoryArgValueTest::SetUp: "
+          << err.what() << "(" << err.err() << ")";
+    }
+  }
+
+  cl::Context context_;
+  cl::CommandQueue queue_;
+};
+
+TEST_F(DeviceGlobalMemoryArgValueTest, FillIsCopiedFromDevice) {
+  DeviceGlobalMemoryArgValue<labm8::int32> value(context_, 10, 3);
+  ProfilingData profiling;
+  value.CopyToDevice(queue_, &profiling);
+  EXPECT_EQ(profiling.transferred_bytes, 0);
+
+  auto output = value.CopyFromDevice(queue_, &profiling);
+  GlobalMemoryArgValue<labm8::int32> expected(10, 3);
+  EXPECT_EQ(expected, output.get());
+}
+
+TEST_F(DeviceGlobalMemoryArgValueTest, RandomFillMatchesHostValues) {
+  auto kernel_or = util::CreateRandomFillKernel(context_, OpenClType::INT);
+  ASSERT_TRUE(kernel_or.ok());
+  DeviceGlobalMemoryArgValue<labm8::int32> value(
+      context_, 1000, kernel_or.ValueOrDie(), /*seed=*/7, /*stream=*/2);
+  ProfilingData profiling;
+  value.CopyToDevice(queue_, &profiling);
+  auto output = value.CopyFromDevice(queue_, &profiling);
+
+  auto host = util::CreateGlobalMemoryArgValue(
+      OpenClType::INT, context_, 1000, /*value=*/1, /*rand_values=*/true,
+      /*seed=*/7, /*stream=*/2);
+  EXPECT_EQ(*host, output.get());
+}
+
+TEST_F(DeviceGlobalMemoryArgValueTest, RandomFillMatchesHostVectorValues) {
+  auto kernel_or = util::CreateRandomFillKernel(context_, OpenClType::FLOAT3);
+  ASSERT_TRUE(kernel_or.ok());
+  DeviceGlobalMemoryArgValue<cl_float3> value(
+      context_, 99, kernel_or.ValueOrDie(), /*seed=*/1, /*stream=*/0);
+  ProfilingData profiling;
+  value.CopyToDevice(queue_, &profiling);
+  auto output = value.CopyFromDevice(queue_, &profiling);
+
+  auto host = util::CreateGlobalMemoryArgValue(
+      OpenClType::FLOAT3, context_, 99, /*value=*/1, /*rand_values=*/true,
+      /*seed=*/1, /*stream=*/0);
+  EXPECT_EQ(*host, output.get());
+}
+
+TEST_F(DeviceGlobalMemoryArgValueTest, SetActiveSizeLimitsCopy) {
+  DeviceGlobalMemoryArgValue<labm8::int32> value(context_, 10, 3);
+  value.SetActiveSize(4);
+  ProfilingData profiling;
+  value.CopyToDevice(queue_, &profiling);
+  auto output = value.CopyFromDevice(queue_, &profiling);
+  EXPECT_EQ(output->Size(), 4);
+}
+
+TEST(GetDeviceStorageTypeName, Types) {
+  EXPECT_EQ(util::GetDeviceStorageTypeName(OpenClType::BOOL), "uint");
+  EXPECT_EQ(util::GetDeviceStorageTypeName(OpenClType::CHAR), "char");
+  EXPECT_EQ(util::GetDeviceStorageTypeName(OpenClType::HALF), "ushort");
+  EXPECT_EQ(util::GetDeviceStorageTypeName(OpenClType::UINT2), "uint2");
+  EXPECT_EQ(util::GetDeviceStorageTypeName(OpenClType::FLOAT3), "float4");
+  EXPECT_EQ(util::GetDeviceStorageTypeName(OpenClType::DOUBLE16),
+            "double16");
+  EXPECT_EQ(util::GetDeviceStorageTypeName(OpenClType::HALF8), "ushort8");
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,183 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/device_random_fill.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/mutex.h"
+
+#include "absl/strings/str_cat.h"
+
+#include <map>
+#include <utility>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+namespace {
+
+// A device implementation of GeneratePhilox4x32() and FillRandom() in
+// random_util.cc and opencl_type_util.cc. Each work item generates one block
+// of four words and converts each word to an element exactly as the host
+// does, so both produce identical buffers.
+const char* const kRandomFillSource = R"(
+#ifdef CLDRIVE_FP64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+kernel void cldrive_random_fill(global CLDRIVE_TYPE* data, ulong size,
+                                uint k0, uint k1, uint stream) {
+  const ulong block = get_global_id(0);
+  uint c0 = (uint)block;
+  uint c1 = (uint)(block >> 32);
+  uint c2 = stream;
+  uint c3 = 0;
+  for (int round = 0; round < 10; ++round) {
+    const uint hi0 = mul_hi(0xD2511F53u, c0);
+    const uint lo0 = 0xD2511F53u * c0;
+    const uint hi1 = mul_hi(0xCD9E8D57u, c2);
+    const uint lo1 = 0xCD9E8D57u * c2;
+    c0 = hi1 ^ c1 ^ k0;
+    c1 = lo1;
+    c2 = hi0 ^ c3 ^ k1;
+    c3 = lo0;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+
+  const uint words[4] = {c0, c1, c2, c3};
+  for (int i = 0; i < 4; ++i) {
+    const ulong index = 4 * block + i;
+    if (index < size) {
+      data[index] = (CLDRIVE_TYPE)((int)(words[i] >> 1));
+    }
+  }
+}
+)";
+
+// The programs built by CreateRandomFillKernel(), keyed by context and type.
+// The contexts are retained so that their handles are not re-used while
+// cached.
+class RandomFillProgramCache {
+ public:
+  static RandomFillProgramCache& Get() {
+    // Leaked so that programs are never released after the OpenCL
+    // implementation has been unloaded at exit.
+    static RandomFillProgramCache* cache = new RandomFillProgramCache;
+    return *cache;
+  }
+
+  labm8::StatusOr<cl::Program> GetOrBuild(const cl::Context& context,
+                                          const string& type_name) {
+    labm8::MutexLock lock(&mutex_);
+    auto key = std::make_pair(context(), type_name);
+    auto it = programs_.find(key);
+    if (it == programs_.end()) {
+      it = programs_.emplace(key, Build(context, type_name)).first;
+    }
+    if (!it->second.status.ok()) {
+      return it->second.status;
+    }
+    return it->second.program;
+  }
+
+ private:
+  struct Entry {
+    cl::Context context;
+    cl::Program program;
+    labm8::Status status;
+  };
+
+  static Entry Build(const cl::Context& context, const string& type_name) {
+    Entry entry;
+    entry.context = context;
+    string build_opts = absl::StrCat("-DCLDRIVE_TYPE=", type_name);
+    if (type_name.find("double") == 0) {
+      absl::StrAppend(&build_opts, " -DCLDRIVE_FP64");
+    }
+    try {
+      entry.program = cl::Program(context, kRandomFillSource);
+      entry.program.build(build_opts.c_str());
+    } catch (cl::Error error) {
+      LOG(WARNING) << "Unable to build device random fill kernel for type "
+                   << type_name << ", values will be generated on the host";
+      entry.status = labm8::Status(labm8::error::Code::UNIMPLEMENTED,
+                                   "Unable to build random fill kernel");
+    }
+    return entry;
+  }
+
+  labm8::Mutex mutex_;
+  std::map<std::pair<cl_context, string>, Entry> programs_;
+};
+
+}  // anonymous namespace
+
+string GetDeviceStorageTypeName(const OpenClType& type) {
+  // The element types, in the order of the OpenClType enum. Vector types are
+  // enumerated as 2, 3, 4, 8, and 16 element vectors of each element type.
+  static const char* const kElementTypes[] = {
+      "char", "uchar", "short", "ushort", "int",   "uint",
+      "long", "ulong", "float", "double", "ushort"};
+  static const char* const kVectorWidths[] = {"2", "4", "4", "8", "16"};
+  static_assert(OpenClType::HALF - OpenClType::CHAR == 10,
+                "Unexpected scalar type order");
+  static_assert(OpenClType::HALF16 - OpenClType::CHAR2 == 54,
+                "Unexpected vector type order");
+
+  if (type == OpenClType::BOOL) {
+    return "uint";
+  } else if (type >= OpenClType::CHAR && type <= OpenClType::HALF) {
+    return kElementTypes[type - OpenClType::CHAR];
+  } else if (type >= OpenClType::CHAR2 && type <= OpenClType::HALF16) {
+    const int i = type - OpenClType::CHAR2;
+    return absl::StrCat(kElementTypes[i / 5], kVectorWidths[i % 5]);
+  }
+  LOG(FATAL) << "GetDeviceStorageTypeName() called with type " << type;
+  return "";
+}
+
+labm8::StatusOr<cl::Kernel> CreateRandomFillKernel(const cl::Context& context,
+                                                   const OpenClType& type) {
+  auto program_or = RandomFillProgramCache::Get().GetOrBuild(
+      context, GetDeviceStorageTypeName(type));
+  if (!program_or.ok()) {
+    return program_or.status();
+  }
+  return cl::Kernel(program_or.ValueOrDie(), "cldrive_random_fill");
+}
+
+void EnqueueRandomFill(const cl::CommandQueue& queue, cl::Kernel* kernel,
+                       const cl::Buffer& buffer, size_t size,
+                       labm8::uint64 seed, labm8::uint32 stream,
+                       cl::Event* event) {
+  kernel->setArg(0, buffer);
+  kernel->setArg(1, static_cast<cl_ulong>(size));
+  kernel->setArg(2, static_cast<cl_uint>(seed));
+  kernel->setArg(3, static_cast<cl_uint>(seed >> 32));
+  kernel->setArg(4, static_cast<cl_uint>(stream));
+
+  // One work item per block of four elements.
+  const size_t num_blocks = (size + 3) / 4;
+  queue.enqueueNDRangeKernel(*kernel, /*offset=*/cl::NullRange,
+                             /*global=*/cl::NDRange(num_blocks),
+                             /*local=*/cl::NullRange,
+                             /*events=*/nullptr, event);
+}
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,54 @@
+// Generation of random argument values on the device.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/opencl_type.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// Return the OpenCL C type which matches the host-side representation of a
+// buffer element of the given type. Booleans are stored as cl_bool, halfs as
+// cl_half, and 3-element vectors as 4-element vectors.
+string GetDeviceStorageTypeName(const OpenClType& type);
+
+// Create a kernel which fills a buffer of the given type with the same values
+// that CreateGlobalMemoryArgValue() generates on the host for a seed and
+// stream. The program is built once per context and type. Returns an error
+// if the program cannot be built, e.g. for double types on devices without
+// cl_khr_fp64.
+labm8::StatusOr<cl::Kernel> CreateRandomFillKernel(const cl::Context& context,
+                                                   const OpenClType& type);
+
+// Enqueue a kernel created by CreateRandomFillKernel() to fill the first size
+// elements of a buffer.
+void EnqueueRandomFill(const cl::CommandQueue& queue, cl::Kernel* kernel,
+                       const cl::Buffer& buffer, size_t size,
+                       labm8::uint64 seed, labm8::uint32 stream,
+                       cl::Event* event);
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
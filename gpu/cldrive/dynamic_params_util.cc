@@ -0,0 +1,137 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/dynamic_params_util.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/port.h"
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+namespace {
+
+// Sample up to k distinct integers from the range [low, high) using Floyd's
+// algorithm, so that large ranges need not be materialized.
+std::vector<int> SampleRange(int low, int high, int k, std::mt19937* rng) {
+  std::vector<int> samples;
+  if (high <= low || k <= 0) {
+    return samples;
+  }
+  const int n = high - low;
+  k = std::min(k, n);
+
+  std::set<int> chosen;
+  for (int j = n - k; j < n; ++j) {
+    std::uniform_int_distribution<int> distribution(0, j);
+    int t = distribution(*rng);
+    if (!chosen.insert(t).second) {
+      chosen.insert(j);
+    }
+  }
+
+  for (auto i : chosen) {
+    samples.push_back(low + i);
+  }
+  return samples;
+}
+
+}  // anonymous namespace
+
+labm8::StatusOr<std::vector<DynamicParams>> ParseDynamicParamsList(
+    const string& str) {
+  std::vector<DynamicParams> dynamic_params;
+
+  for (absl::string_view pair : absl::StrSplit(str, ',', absl::SkipEmpty())) {
+    std::vector<absl::string_view> sizes = absl::StrSplit(pair, ':');
+    int global_size, local_size;
+    if (sizes.size() != 2 || !absl::SimpleAtoi(sizes[0], &global_size) ||
+        !absl::SimpleAtoi(sizes[1], &local_size)) {
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Dynamic params must be <gsize>:<lsize> pairs");
+    }
+    if (global_size <= 0 || local_size <= 0 || local_size > global_size) {
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Dynamic params must satisfy 0 < lsize <= gsize");
+    }
+
+    DynamicParams params;
+    params.set_global_size_x(global_size);
+    params.set_local_size_x(local_size);
+    dynamic_params.push_back(params);
+  }
+
+  return dynamic_params;
+}
+
+std::vector<DynamicParams> SampleDynamicParams(
+    const DynamicParamsSampleOptions& options) {
+  std::mt19937 rng(options.seed);
+
+  // Sample local sizes.
+  std::vector<int> local_sizes;
+  for (auto i : SampleRange(0, options.local_sizes.size(),
+                            options.num_local_sizes, &rng)) {
+    local_sizes.push_back(options.local_sizes[i]);
+  }
+
+  // Sample work group counts from the small, medium, and large ranges.
+  const int num_small = options.num_work_group_sizes * 15 / 100;
+  const int num_medium = options.num_work_group_sizes * 70 / 100;
+  const int num_large = options.num_work_group_sizes - num_small - num_medium;
+  const int cu = options.num_compute_units;
+
+  std::vector<int> work_group_sizes;
+  for (auto range : std::vector<std::pair<std::pair<int, int>, int>>{
+           {{1, cu}, num_small},
+           {{cu, cu * 20}, num_medium},
+           {{cu * 20, cu * 1000}, num_large}}) {
+    auto samples =
+        SampleRange(range.first.first, range.first.second, range.second, &rng);
+    work_group_sizes.insert(work_group_sizes.end(), samples.begin(),
+                            samples.end());
+  }
+
+  std::vector<DynamicParams> dynamic_params;
+  for (auto local_size : local_sizes) {
+    CHECK(local_size > 0) << "Local size must be positive";
+    for (auto work_group_size : work_group_sizes) {
+      labm8::int64 global_size =
+          static_cast<labm8::int64>(local_size) * work_group_size;
+      if (global_size > options.max_global_size) {
+        global_size = local_size * (options.max_global_size / local_size);
+      }
+
+      DynamicParams params;
+      params.set_global_size_x(global_size);
+      params.set_local_size_x(local_size);
+      dynamic_params.push_back(params);
+    }
+  }
+
+  return dynamic_params;
+}
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
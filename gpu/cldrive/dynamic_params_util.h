@@ -0,0 +1,62 @@
+// Utility code for constructing sweeps of dynamic params.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// Parse a comma separated list of <gsize>:<lsize> pairs, e.g.
+//     '1024:128,4096:256' -> {1024, 128}, {4096, 256}
+labm8::StatusOr<std::vector<DynamicParams>> ParseDynamicParamsList(
+    const string& str);
+
+// Options for SampleDynamicParams(). The defaults mirror the launch config
+// sampling used by run_cldrive.py.
+struct DynamicParamsSampleOptions {
+  // The candidate local sizes, and the number of them to sample.
+  std::vector<int> local_sizes;
+  int num_local_sizes = 4;
+  // The number of work group counts to sample per local size. 15% are drawn
+  // from [1, num_compute_units), 70% from [num_compute_units,
+  // 20 * num_compute_units) and 15% from [20 * num_compute_units,
+  // 1000 * num_compute_units).
+  int num_work_group_sizes = 50;
+  int num_compute_units = 72;
+  // Global sizes are clamped to the largest multiple of the local size that
+  // does not exceed this value.
+  int max_global_size = 9999999;
+  unsigned int seed = 2610;
+};
+
+// Sample a sweep of dynamic params. Every sampled local size is paired with
+// every sampled work group count, so the result has
+// num_local_sizes * num_work_group_sizes elements.
+std::vector<DynamicParams> SampleDynamicParams(
+    const DynamicParamsSampleOptions& options);
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
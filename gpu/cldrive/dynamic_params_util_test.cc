@@ -0,0 +1,84 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/dynamic_params_util.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+namespace {
+
+TEST(ParseDynamicParamsList, SinglePair) {
+  auto params = ParseDynamicParamsList("1024:128");
+  ASSERT_TRUE(params.ok());
+  ASSERT_EQ(params.ValueOrDie().size(), 1);
+  EXPECT_EQ(params.ValueOrDie()[0].global_size_x(), 1024);
+  EXPECT_EQ(params.ValueOrDie()[0].local_size_x(), 128);
+}
+
+TEST(ParseDynamicParamsList, MultiplePairs) {
+  auto params = ParseDynamicParamsList("1024:128,4096:256,");
+  ASSERT_TRUE(params.ok());
+  ASSERT_EQ(params.ValueOrDie().size(), 2);
+  EXPECT_EQ(params.ValueOrDie()[1].global_size_x(), 4096);
+  EXPECT_EQ(params.ValueOrDie()[1].local_size_x(), 256);
+}
+
+TEST(ParseDynamicParamsList, MissingLocalSize) {
+  EXPECT_FALSE(ParseDynamicParamsList("1024").ok());
+}
+
+TEST(ParseDynamicParamsList, LocalSizeExceedsGlobalSize) {
+  EXPECT_FALSE(ParseDynamicParamsList("128:1024").ok());
+}
+
+TEST(SampleDynamicParams, NumberOfSamples) {
+  DynamicParamsSampleOptions options;
+  options.local_sizes = {32, 64, 96, 128, 160};
+  options.num_local_sizes = 2;
+  options.num_work_group_sizes = 20;
+  EXPECT_EQ(SampleDynamicParams(options).size(), 40);
+}
+
+TEST(SampleDynamicParams, GlobalSizeIsMultipleOfLocalSize) {
+  DynamicParamsSampleOptions options;
+  options.local_sizes = {32, 96};
+  options.max_global_size = 100000;
+  for (const auto& params : SampleDynamicParams(options)) {
+    EXPECT_EQ(params.global_size_x() % params.local_size_x(), 0);
+    EXPECT_LE(params.global_size_x(), 100000);
+  }
+}
+
+TEST(SampleDynamicParams, SameSeedIsDeterministic) {
+  DynamicParamsSampleOptions options;
+  options.local_sizes = {32, 64, 96, 128, 160};
+  auto a = SampleDynamicParams(options);
+  auto b = SampleDynamicParams(options);
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].global_size_x(), b[i].global_size_x());
+    EXPECT_EQ(a[i].local_size_x(), b[i].local_size_x());
+  }
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
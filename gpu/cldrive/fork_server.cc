@@ -0,0 +1,320 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/fork_server.h"
+
+#include "gpu/cldrive/delimited_util.h"
+#include "gpu/cldrive/libcldrive.h"
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <iostream>
+#include <streambuf>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// An unbuffered stream buffer which writes to a file descriptor, so that
+// nothing which has been written is lost if the process crashes.
+class FileDescriptorStreamBuffer : public std::streambuf {
+ public:
+  explicit FileDescriptorStreamBuffer(int fd) : fd_(fd) {}
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+      return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+  }
+
+  std::streamsize xsputn(const char* data, std::streamsize size) override {
+    std::streamsize written = 0;
+    while (written < size) {
+      ssize_t n = ::write(fd_, data + written, size - written);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        break;
+      }
+      written += n;
+    }
+    return written;
+  }
+
+ private:
+  int fd_;
+};
+
+// A logger which forwards its calls as length-delimited CldriveLoggerCall
+// messages. Logs which are not flushed are buffered, and forwarded by
+// PrintAndClearBuffer(), as for any other logger.
+//
+// The time limit is enforced with alarm(), which is reset at the start of
+// each kernel instance. The default action of SIGALRM terminates the process.
+class ForwardingLogger : public Logger {
+ public:
+  ForwardingLogger(std::ostream& ostream,
+                   const CldriveInstances* const instances,
+                   int timeout_seconds)
+      : Logger(ostream, instances), timeout_seconds_(timeout_seconds) {
+    ::alarm(timeout_seconds_);
+  }
+
+  virtual labm8::Status RecordLog(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override {
+    CldriveLoggerCall call = NewCall(CldriveLoggerCall::RECORD_LOG, instance);
+    if (kernel_instance) {
+      *call.mutable_kernel_instance() = *kernel_instance;
+    }
+    if (run) {
+      *call.mutable_run() = *run;
+    }
+    if (log) {
+      *call.mutable_log() = *log;
+    }
+    return Forward(call, flush);
+  }
+
+  virtual labm8::Status StartKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance) override {
+    ::alarm(timeout_seconds_);
+    CldriveLoggerCall call =
+        NewCall(CldriveLoggerCall::START_KERNEL_INSTANCE, instance);
+    *call.mutable_kernel_instance() = *kernel_instance;
+    return Forward(call);
+  }
+
+  virtual labm8::Status RecordRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run) override {
+    CldriveLoggerCall call = NewCall(CldriveLoggerCall::RECORD_RUN, instance);
+    *call.mutable_kernel_instance() = *kernel_instance;
+    *call.mutable_run() = *run;
+    return Forward(call);
+  }
+
+  virtual labm8::Status RecordKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance) override {
+    CldriveLoggerCall call =
+        NewCall(CldriveLoggerCall::RECORD_KERNEL_INSTANCE, instance);
+    *call.mutable_kernel_instance() = *kernel_instance;
+    return Forward(call);
+  }
+
+  virtual labm8::Status RecordInstance(
+      const CldriveInstance* const instance) override {
+    return Forward(NewCall(CldriveLoggerCall::RECORD_INSTANCE, instance));
+  }
+
+  // The runs are forwarded as they complete, so the kernel instances
+  // forwarded never include runs.
+  virtual bool RetainsRuns() const override { return false; }
+
+ private:
+  CldriveLoggerCall NewCall(CldriveLoggerCall::Method method,
+                            const CldriveInstance* const instance) {
+    CldriveLoggerCall call;
+    call.set_method(method);
+    call.set_instance_outcome(instance->outcome());
+    return call;
+  }
+
+  labm8::Status Forward(const CldriveLoggerCall& call, bool flush = true) {
+    if (!util::WriteDelimited(call, &ostream(flush))) {
+      return labm8::Status(labm8::error::Code::INTERNAL,
+                           "Failed to forward logger call");
+    }
+    return labm8::Status::OK;
+  }
+
+  const int timeout_seconds_;
+};
+
+}  // anonymous namespace
+
+ForkServer::ForkServer(const ForkServerOptions& options) : options_(options) {
+  // Enumerate the devices before forking, so that the children inherit them.
+  labm8::gpu::clinfo::GetOpenClDevices();
+}
+
+void ForkServer::RunOrDie(CldriveInstance* instance, int instance_num,
+                          Logger& logger) {
+  // A child is forked for the kernels which remain after each kernel which
+  // crashes or times out, so that such a kernel costs only itself. The
+  // outcome of the first is the outcome of the instance.
+  int num_kernels = 0;
+  bool kernel_failed = false;
+  CldriveInstance::InstanceOutcome kernel_failure_outcome =
+      CldriveInstance::CRASH;
+  while (true) {
+    int fds[2];
+    CHECK(!::pipe(fds)) << "pipe() failed";
+
+    // Flush the output streams so that their buffered contents are not
+    // inherited by the child.
+    std::cout.flush();
+    std::cerr.flush();
+
+    pid_t pid = ::fork();
+    CHECK(pid >= 0) << "fork() failed";
+    if (!pid) {
+      ::close(fds[0]);
+      RunChildAndExit(instance, instance_num, num_kernels, fds[1]);
+    }
+    ::close(fds[1]);
+
+    // Replay the calls of the child. The kernel instances are added to the
+    // instance once complete, and the runs of the running kernel instance
+    // are accumulated in the meantime.
+    CldriveKernelInstance running_kernel;
+    bool kernel_running = false;
+    bool instance_recorded = false;
+    util::DelimitedReader reader(fds[0]);
+    CldriveLoggerCall call;
+    while (reader.Next(&call)) {
+      instance->set_outcome(call.instance_outcome());
+      switch (call.method()) {
+        case CldriveLoggerCall::START_KERNEL_INSTANCE:
+          running_kernel = call.kernel_instance();
+          kernel_running = true;
+          logger.StartKernelInstance(instance, &running_kernel);
+          break;
+        case CldriveLoggerCall::RECORD_LOG:
+          logger.RecordLog(
+              instance,
+              call.has_kernel_instance() ? &call.kernel_instance() : nullptr,
+              call.has_run() ? &call.run() : nullptr,
+              call.has_log() ? &call.log() : nullptr);
+          break;
+        case CldriveLoggerCall::RECORD_RUN:
+          logger.RecordRun(instance, &call.kernel_instance(), &call.run());
+          if (logger.RetainsRuns()) {
+            *running_kernel.add_run() = call.run();
+          }
+          break;
+        case CldriveLoggerCall::RECORD_KERNEL_INSTANCE: {
+          CldriveKernelInstance* kernel = instance->add_kernel();
+          *kernel = call.kernel_instance();
+          // As in KernelDriver, only the kernel instances which pass keep
+          // their runs.
+          if (kernel->outcome() == CldriveKernelInstance::PASS) {
+            kernel->mutable_run()->Swap(running_kernel.mutable_run());
+          }
+          running_kernel.Clear();
+          kernel_running = false;
+          ++num_kernels;
+          logger.RecordKernelInstance(instance, kernel);
+          break;
+        }
+        case CldriveLoggerCall::RECORD_INSTANCE:
+          if (kernel_failed && instance->outcome() == CldriveInstance::PASS) {
+            instance->set_outcome(kernel_failure_outcome);
+          }
+          logger.RecordInstance(instance);
+          instance_recorded = true;
+          break;
+      }
+    }
+    ::close(fds[0]);
+
+    int status;
+    while (::waitpid(pid, &status, 0) < 0) {
+      CHECK(errno == EINTR) << "waitpid() failed";
+    }
+    if (instance_recorded) {
+      return;
+    }
+
+    const bool timeout = WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM;
+    if (timeout) {
+      LOG(WARNING) << "Instance " << instance_num << " exceeded time limit of "
+                   << options_.timeout_seconds << " seconds";
+    } else if (WIFSIGNALED(status)) {
+      LOG(WARNING) << "Instance " << instance_num << " terminated by signal "
+                   << WTERMSIG(status);
+    } else {
+      LOG(WARNING) << "Instance " << instance_num << " exited with status "
+                   << WEXITSTATUS(status);
+    }
+
+    if (!kernel_running) {
+      instance->set_outcome(timeout ? CldriveInstance::TIMEOUT
+                                    : CldriveInstance::CRASH);
+      logger.RecordLog(instance, /*kernel_instance=*/nullptr, /*run=*/nullptr,
+                       /*log=*/nullptr);
+      logger.RecordInstance(instance);
+      return;
+    }
+
+    running_kernel.set_outcome(timeout ? CldriveKernelInstance::TIMEOUT
+                                       : CldriveKernelInstance::CRASH);
+    logger.RecordLog(instance, &running_kernel, /*run=*/nullptr,
+                     /*log=*/nullptr);
+    CldriveKernelInstance* kernel = instance->add_kernel();
+    kernel->Swap(&running_kernel);
+    ++num_kernels;
+    logger.RecordKernelInstance(instance, kernel);
+
+    if (!kernel_failed) {
+      kernel_failed = true;
+      kernel_failure_outcome =
+          timeout ? CldriveInstance::TIMEOUT : CldriveInstance::CRASH;
+    }
+  }
+}
+
+void ForkServer::RunChildAndExit(CldriveInstance* instance, int instance_num,
+                                 int num_skipped_kernels, int fd) {
+  // The caller may have blocked or handled SIGALRM.
+  ::signal(SIGALRM, SIG_DFL);
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGALRM);
+  pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+
+  FileDescriptorStreamBuffer buffer(fd);
+  std::ostream ostream(&buffer);
+  CldriveInstances instances;
+  ForwardingLogger logger(ostream, &instances, options_.timeout_seconds);
+  logger.StartNewInstance();
+
+  Cldrive cldrive(instance, instance_num, options_.program_cache);
+  cldrive.SkipKernels(num_skipped_kernels);
+  cldrive.RunOrDie(logger);
+
+  // Exit without running the destructors of the caller's objects.
+  ::_exit(0);
+}
+
+}  // namespace cldrive
+}  // namespace gpu
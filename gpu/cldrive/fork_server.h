@@ -0,0 +1,71 @@
+// Run cldrive instances in forked child processes.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+namespace gpu {
+namespace cldrive {
+
+struct ForkServerOptions {
+  // The time limit in seconds for building the program of an instance, and
+  // for running each of its kernels, or zero for no limit.
+  int timeout_seconds = 0;
+  // Optional. If set, the compiled programs are loaded from and stored in
+  // this cache.
+  const ProgramCache* program_cache = nullptr;
+};
+
+// Runs each instance in a child process forked from the caller, so that a
+// kernel which crashes the OpenCL implementation, or which hangs, does not
+// terminate the caller. The OpenCL devices are enumerated once, by the
+// caller, and every child inherits them.
+//
+// The child forwards its calls to the logger over a pipe, and the parent
+// replays them on the caller's logger as they arrive, so the output is the
+// same as that of Cldrive::RunOrDie() for instances which complete. If the
+// child terminates abnormally or exceeds its time limit while running a
+// kernel, that kernel is recorded with a CRASH or TIMEOUT outcome, and a new
+// child is forked to run the remaining kernels of the instance, which is then
+// recorded with the same outcome. If no kernel was running, e.g. while the
+// program was being built, the instance is recorded with the outcome.
+//
+// Many OpenCL implementations do not survive a fork() once a context has
+// been created, so the caller must not create any contexts, e.g. by using
+// OpenClContextPool or Cldrive.
+class ForkServer {
+ public:
+  explicit ForkServer(const ForkServerOptions& options);
+
+  // Run an instance in a child process, recording it with the logger.
+  void RunOrDie(CldriveInstance* instance, int instance_num, Logger& logger);
+
+ private:
+  // Run an instance, skipping the kernels which have already been run,
+  // forwarding the logger calls to a file descriptor, and exit. Called in the
+  // child process.
+  void RunChildAndExit(CldriveInstance* instance, int instance_num,
+                       int num_skipped_kernels, int fd);
+
+  const ForkServerOptions options_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
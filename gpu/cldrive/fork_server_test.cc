@@ -0,0 +1,171 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/fork_server.h"
+
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/test.h"
+
+#include <sys/resource.h>
+
+#include <map>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+// A logger which records the outcomes of the instances and kernel instances
+// it is passed.
+class OutcomeLogger : public Logger {
+ public:
+  OutcomeLogger() : Logger(std::cout, /*instances=*/nullptr) {}
+
+  virtual labm8::Status RecordKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance) override {
+    kernel_outcomes[kernel_instance->name()].push_back(
+        kernel_instance->outcome());
+    return labm8::Status::OK;
+  }
+
+  virtual labm8::Status RecordInstance(
+      const CldriveInstance* const instance) override {
+    outcomes.push_back(instance->outcome());
+    return labm8::Status::OK;
+  }
+
+  std::map<string, std::vector<CldriveKernelInstance::KernelInstanceOutcome>>
+      kernel_outcomes;
+  std::vector<CldriveInstance::InstanceOutcome> outcomes;
+};
+
+// The order in which the kernels of a program are run is determined by the
+// OpenCL implementation, so the kernel which never terminates may be run
+// before or after the other.
+const char* kHangingKernelSrc =
+    "kernel void Hang(global int* a) { for (;;) { a[0] += 1; } }\n"
+    "kernel void B(global int* a) { a[get_global_id(0)] = 1; }";
+
+CldriveInstance MakeInstance(const string& opencl_src) {
+  CldriveInstance instance;
+  *instance.mutable_device() =
+      labm8::gpu::clinfo::GetOpenClDevices().device(0);
+  instance.set_opencl_src(opencl_src);
+  instance.set_min_runs_per_kernel(1);
+  auto dynamic_params = instance.add_dynamic_params();
+  dynamic_params->set_global_size_x(1);
+  dynamic_params->set_local_size_x(1);
+  return instance;
+}
+
+TEST(ForkServer, CrashIsRecordedAndServerContinues) {
+  ForkServer server(ForkServerOptions{});
+  OutcomeLogger logger;
+
+  // Cldrive aborts if the device is not found, which terminates the child.
+  CldriveInstance instance;
+  instance.mutable_device()->set_name("not a real device");
+  instance.set_opencl_src("kernel void A(global int* a) {}");
+
+  for (int i = 0; i < 2; ++i) {
+    logger.StartNewInstance();
+    server.RunOrDie(&instance, i, logger);
+  }
+
+  ASSERT_EQ(logger.outcomes.size(), 2);
+  EXPECT_EQ(logger.outcomes[0], CldriveInstance::CRASH);
+  EXPECT_EQ(logger.outcomes[1], CldriveInstance::CRASH);
+  EXPECT_EQ(instance.kernel_size(), 0);
+}
+
+TEST(ForkServer, KernelTimeoutIsRecordedAndRemainingKernelsAreRun) {
+  ForkServerOptions options;
+  options.timeout_seconds = 1;
+  ForkServer server(options);
+  OutcomeLogger logger;
+
+  CldriveInstance hanging = MakeInstance(kHangingKernelSrc);
+  logger.StartNewInstance();
+  server.RunOrDie(&hanging, 0, logger);
+
+  CldriveInstance passing = MakeInstance("kernel void C(global int* a) {}");
+  logger.StartNewInstance();
+  server.RunOrDie(&passing, 1, logger);
+
+  ASSERT_EQ(logger.outcomes.size(), 2);
+  EXPECT_EQ(logger.outcomes[0], CldriveInstance::TIMEOUT);
+  EXPECT_EQ(logger.outcomes[1], CldriveInstance::PASS);
+
+  // Each kernel is recorded once.
+  ASSERT_EQ(hanging.kernel_size(), 2);
+  EXPECT_EQ(logger.kernel_outcomes["Hang"],
+            std::vector<CldriveKernelInstance::KernelInstanceOutcome>(
+                {CldriveKernelInstance::TIMEOUT}));
+  EXPECT_EQ(logger.kernel_outcomes["B"],
+            std::vector<CldriveKernelInstance::KernelInstanceOutcome>(
+                {CldriveKernelInstance::PASS}));
+  EXPECT_EQ(logger.kernel_outcomes["C"],
+            std::vector<CldriveKernelInstance::KernelInstanceOutcome>(
+                {CldriveKernelInstance::PASS}));
+}
+
+TEST(ForkServer, KernelCrashIsRecordedAndRemainingKernelsAreRun) {
+  ForkServer server(ForkServerOptions{});
+  OutcomeLogger logger;
+
+  // The child inherits a CPU time limit, and is terminated by SIGXCPU while
+  // running the kernel which never terminates. The parent, which blocks
+  // while waiting for the child, does not reach the limit.
+  struct rlimit limit;
+  ASSERT_EQ(getrlimit(RLIMIT_CPU, &limit), 0);
+  const struct rlimit original_limit = limit;
+  struct rusage usage;
+  ASSERT_EQ(getrusage(RUSAGE_SELF, &usage), 0);
+  limit.rlim_cur = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 2;
+  ASSERT_EQ(setrlimit(RLIMIT_CPU, &limit), 0);
+
+  CldriveInstance crashing = MakeInstance(kHangingKernelSrc);
+  logger.StartNewInstance();
+  server.RunOrDie(&crashing, 0, logger);
+
+  ASSERT_EQ(setrlimit(RLIMIT_CPU, &original_limit), 0);
+
+  CldriveInstance passing = MakeInstance("kernel void C(global int* a) {}");
+  logger.StartNewInstance();
+  server.RunOrDie(&passing, 1, logger);
+
+  ASSERT_EQ(logger.outcomes.size(), 2);
+  EXPECT_EQ(logger.outcomes[0], CldriveInstance::CRASH);
+  EXPECT_EQ(logger.outcomes[1], CldriveInstance::PASS);
+
+  ASSERT_EQ(crashing.kernel_size(), 2);
+  EXPECT_EQ(logger.kernel_outcomes["Hang"],
+            std::vector<CldriveKernelInstance::KernelInstanceOutcome>(
+                {CldriveKernelInstance::CRASH}));
+  EXPECT_EQ(logger.kernel_outcomes["B"],
+            std::vector<CldriveKernelInstance::KernelInstanceOutcome>(
+                {CldriveKernelInstance::PASS}));
+  EXPECT_EQ(logger.kernel_outcomes["C"],
+            std::vector<CldriveKernelInstance::KernelInstanceOutcome>(
+                {CldriveKernelInstance::PASS}));
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
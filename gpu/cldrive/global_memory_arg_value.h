@@ -31,7 +31,8 @@ template <typename T>
 class GlobalMemoryArgValue : public KernelArgValue {
  public:
   template <typename... Args>
-  GlobalMemoryArgValue(size_t size, Args &&... args) : vector_(size, args...) {}
+  GlobalMemoryArgValue(size_t size, Args &&... args)
+      : vector_(size, args...), active_size_(size) {}
 
   virtual bool operator==(const KernelArgValue *const rhs) const override {
     auto array_ptr = dynamic_cast<const GlobalMemoryArgValue *const>(rhs);
@@ -39,11 +40,11 @@ class GlobalMemoryArgValue : public KernelArgValue {
       return false;
     }
 
-    if (vector().size() != array_ptr->vector().size()) {
+    if (Size() != array_ptr->Size()) {
       return false;
     }
 
-    for (size_t i = 0; i < vector().size(); ++i) {
+    for (size_t i = 0; i < Size(); ++i) {
       if (!opencl_type::Equal(vector()[i], array_ptr->vector()[i])) {
         return false;
       }
@@ -60,7 +61,14 @@ class GlobalMemoryArgValue : public KernelArgValue {
 
   const std::vector<T> &vector() const { return vector_; }
 
-  virtual size_t Size() const override { return vector_.size(); }
+  virtual size_t Size() const override { return active_size_; }
+
+  virtual void SetActiveSize(size_t size) override {
+    CHECK(size <= vector_.size())
+        << "Active size " << size << " exceeds allocated size "
+        << vector_.size();
+    active_size_ = size;
+  }
 
   virtual void CopyToDevice(const cl::CommandQueue &queue,
                             ProfilingData *profiling) override {
@@ -73,25 +81,44 @@ class GlobalMemoryArgValue : public KernelArgValue {
     return std::unique_ptr<KernelArgValue>(nullptr);
   }
 
+  virtual void CopyFromDeviceInto(const cl::CommandQueue &queue,
+                                  KernelArgValue *value,
+                                  ProfilingData *profiling) override {
+    CHECK(false);
+  }
+
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) override {
+    CHECK(false);
+  }
+
+  virtual void EnqueueCopyFromDeviceInto(const cl::CommandQueue &queue,
+                                         const std::vector<cl::Event> &events,
+                                         KernelArgValue *value,
+                                         ProfilingData *profiling) override {
+    CHECK(false);
+  }
+
   virtual void SetAsArg(cl::Kernel *kernel, size_t arg_index) override {
     CHECK(false);
   }
 
   virtual string ToString() const override {
     string s = "";
-    for (const auto &value : vector()) {
-      absl::StrAppend(&s, opencl_type::ToString(value));
+    for (size_t i = 0; i < Size(); ++i) {
+      absl::StrAppend(&s, opencl_type::ToString(vector()[i]));
       absl::StrAppend(&s, ",");
     }
     return s;
   };
 
   virtual size_t SizeInBytes() const override {
-    return sizeof(T) * vector_.size();
+    return sizeof(T) * Size();
   }
 
  protected:
   std::vector<T> vector_;
+  size_t active_size_;
 };
 
 // An array value with a device-side buffer.
@@ -113,20 +140,62 @@ class GlobalMemoryArgValueWithBuffer : public GlobalMemoryArgValue<T> {
 
   virtual void CopyToDevice(const cl::CommandQueue &queue,
                             ProfilingData *profiling) override {
-    size_t buffer_size = this->vector().size() * sizeof(T);
+    size_t buffer_size = this->SizeInBytes();
     util::CopyHostToDevice(queue, this->vector().data(), buffer(), buffer_size,
                            profiling);
   }
 
   virtual std::unique_ptr<KernelArgValue> CopyFromDevice(
       const cl::CommandQueue &queue, ProfilingData *profiling) override {
-    size_t buffer_size = this->vector().size() * sizeof(T);
-    auto new_arg = std::make_unique<GlobalMemoryArgValue<T>>(this->Size());
-    util::CopyDeviceToHost(queue, buffer(), new_arg->vector().data(),
-                           buffer_size, profiling);
+    // Allocate the full backing size rather than the active size, so that
+    // the new value can be re-used by CopyFromDeviceInto() for any active
+    // size.
+    auto new_arg =
+        std::make_unique<GlobalMemoryArgValue<T>>(this->vector().size());
+    profiling->host_allocated_bytes += sizeof(T) * this->vector().size();
+    CopyFromDeviceInto(queue, new_arg.get(), profiling);
     return std::move(new_arg);
   }
 
+  virtual void CopyFromDeviceInto(const cl::CommandQueue &queue,
+                                  KernelArgValue *value,
+                                  ProfilingData *profiling) override {
+    auto output = dynamic_cast<GlobalMemoryArgValue<T> *>(value);
+    CHECK(output) << "Cannot copy global memory into a different value type";
+
+    if (output->vector().size() < this->Size()) {
+      output->vector().resize(this->Size());
+      profiling->host_allocated_bytes += this->SizeInBytes();
+    }
+    output->SetActiveSize(this->Size());
+
+    util::CopyDeviceToHost(queue, buffer(), output->vector().data(),
+                           this->SizeInBytes(), profiling);
+  }
+
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) override {
+    util::EnqueueCopyHostToDevice(queue, this->vector().data(), buffer(),
+                                  this->SizeInBytes(), profiling);
+  }
+
+  virtual void EnqueueCopyFromDeviceInto(const cl::CommandQueue &queue,
+                                         const std::vector<cl::Event> &events,
+                                         KernelArgValue *value,
+                                         ProfilingData *profiling) override {
+    auto output = dynamic_cast<GlobalMemoryArgValue<T> *>(value);
+    CHECK(output) << "Cannot copy global memory into a different value type";
+
+    if (output->vector().size() < this->Size()) {
+      output->vector().resize(this->Size());
+      profiling->host_allocated_bytes += this->SizeInBytes();
+    }
+    output->SetActiveSize(this->Size());
+
+    util::EnqueueCopyDeviceToHost(queue, buffer(), output->vector().data(),
+                                  this->SizeInBytes(), events, profiling);
+  }
+
  private:
   cl::Buffer buffer_;
 };
@@ -0,0 +1,55 @@
+// Hashing utilities.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// 64-bit FNV-1a hash. The hash is stable across platforms and releases, so it
+// may be used for persistent keys.
+class Fnv1aHash {
+ public:
+  Fnv1aHash() : hash_(14695981039346656037ULL) {}
+
+  // Add a field to the hash. Fields are terminated so that the concatenation
+  // of two fields does not collide with a different split of the same bytes.
+  void AddField(const string& field) {
+    for (char c : field) {
+      AddByte(static_cast<unsigned char>(c));
+    }
+    AddByte(0);
+  }
+
+  labm8::uint64 hash() const { return hash_; }
+
+ private:
+  void AddByte(unsigned char byte) {
+    hash_ ^= byte;
+    hash_ *= 1099511628211ULL;
+  }
+
+  labm8::uint64 hash_;
+};
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
@@ -29,6 +29,7 @@ namespace gpu {
 namespace cldrive {
 
 labm8::Status KernelArg::Init(cl::Kernel* kernel, size_t arg_index) {
+  arg_index_ = arg_index;
   name_ = util::GetKernelArgName(*kernel, arg_index);
 
   address_ = kernel->getArgInfo<CL_KERNEL_ARG_ADDRESS_QUALIFIER>(arg_index);
@@ -84,15 +85,18 @@ const string& KernelArg::name() const { return name_; }
 const string& KernelArg::type_name() const { return type_name_; }
 
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateRandomValue(
-    const cl::Context& context, const DynamicParams& dynamic_params) const {
+    const cl::Context& context, const DynamicParams& dynamic_params,
+    labm8::uint64 seed, bool device_init) const {
   return TryToCreateKernelArgValue(context, dynamic_params,
-                                   /*rand_values=*/true);
+                                   /*rand_values=*/true, seed, device_init);
 }
 
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateOnesValue(
-    const cl::Context& context, const DynamicParams& dynamic_params) const {
+    const cl::Context& context, const DynamicParams& dynamic_params,
+    bool device_init) const {
   return TryToCreateKernelArgValue(context, dynamic_params,
-                                   /*rand_values=*/false);
+                                   /*rand_values=*/false, /*seed=*/0,
+                                   device_init);
 }
 
 bool KernelArg::IsGlobal() const {
@@ -115,14 +119,15 @@ bool KernelArg::IsPointer() const { return is_pointer_; }
 
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateKernelArgValue(
     const cl::Context& context, const DynamicParams& dynamic_params,
-    bool rand_values) const {
+    bool rand_values, labm8::uint64 seed, bool device_init) const {
   CHECK(type() != OpenClType::DEFAULT_UNKNOWN);
 
   if (IsPointer() && IsGlobal()) {
     return util::CreateGlobalMemoryArgValue(
         type(), context,
         /*size=*/dynamic_params.global_size_x(),
-        /*value=*/1, rand_values);
+        /*value=*/1, rand_values, seed,
+        /*stream=*/static_cast<labm8::uint32>(arg_index_), device_init);
   } else if (IsPointer() && IsLocal()) {
     return util::CreateLocalMemoryArgValue(
         type(),
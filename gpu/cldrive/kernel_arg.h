@@ -18,6 +18,7 @@
 #include "gpu/cldrive/kernel_arg_value.h"
 #include "gpu/cldrive/opencl_type.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
+#include "labm8/cpp/port.h"
 #include "labm8/cpp/status.h"
 #include "labm8/cpp/statusor.h"
 #include "opencl_type.h"
@@ -28,19 +29,23 @@ namespace cldrive {
 
 class KernelArg {
  public:
-  KernelArg() : type_(OpenClType::DEFAULT_UNKNOWN) {}
+  KernelArg() : type_(OpenClType::DEFAULT_UNKNOWN), arg_index_(0) {}
 
   labm8::Status Init(cl::Kernel *kernel, size_t arg_index);
 
-  // Create a random value for this argument. If the argument is not supported,
-  // returns nullptr.
+  // Create a random value for this argument. The values of global memory
+  // arguments are determined by the seed and the argument index. If
+  // device_init is true, global memory values are initialized on the device.
+  // If the argument is not supported, returns nullptr.
   std::unique_ptr<KernelArgValue> TryToCreateRandomValue(
-      const cl::Context &context, const DynamicParams &dynamic_params) const;
+      const cl::Context &context, const DynamicParams &dynamic_params,
+      labm8::uint64 seed = 0, bool device_init = false) const;
 
   // Create a "ones" value for this argument. If the argument is not supported,
   // returns nullptr.
   std::unique_ptr<KernelArgValue> TryToCreateOnesValue(
-      const cl::Context &context, const DynamicParams &dynamic_params) const;
+      const cl::Context &context, const DynamicParams &dynamic_params,
+      bool device_init = false) const;
 
   // Address qualifier accessors.
 
@@ -61,9 +66,10 @@ class KernelArg {
  private:
   std::unique_ptr<KernelArgValue> TryToCreateKernelArgValue(
       const cl::Context &context, const DynamicParams &dynamic_params,
-      bool rand_values) const;
+      bool rand_values, labm8::uint64 seed, bool device_init) const;
 
   OpenClType type_;
+  size_t arg_index_;
   cl_kernel_arg_address_qualifier address_;
   bool is_pointer_;
   string name_;
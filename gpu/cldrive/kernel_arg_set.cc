@@ -23,7 +23,9 @@
 namespace gpu {
 namespace cldrive {
 
-KernelArgSet::KernelArgSet(cl::Kernel* kernel) : kernel_(kernel) {}
+KernelArgSet::KernelArgSet(cl::Kernel* kernel, labm8::uint64 seed,
+                           bool device_init)
+    : kernel_(kernel), seed_(seed), device_init_(device_init) {}
 
 CldriveKernelInstance::KernelInstanceOutcome KernelArgSet::Init() {
   size_t num_args = kernel_->getInfo<CL_KERNEL_NUM_ARGS>();
@@ -62,7 +64,8 @@ labm8::Status KernelArgSet::SetRandom(const cl::Context& context,
                                       KernelArgValuesSet* values) {
   values->Clear();
   for (auto& arg : args_) {
-    auto value = arg.TryToCreateRandomValue(context, dynamic_params);
+    auto value = arg.TryToCreateRandomValue(context, dynamic_params, seed_,
+                                            device_init_);
     if (value) {
       values->AddKernelArgValue(std::move(value));
     } else {
@@ -83,7 +86,8 @@ labm8::Status KernelArgSet::SetRandom(const cl::Context& context,
   for (auto& arg : args_) {
     DynamicParams dynamic_params;
     dynamic_params.set_global_size_x(args_array_bound[i]);
-    auto value = arg.TryToCreateRandomValue(context, dynamic_params);
+    auto value = arg.TryToCreateRandomValue(context, dynamic_params, seed_,
+                                            device_init_);
     if (value) {
       values->AddKernelArgValue(std::move(value));
     } else {
@@ -102,7 +106,8 @@ labm8::Status KernelArgSet::SetOnes(const cl::Context& context,
                                     KernelArgValuesSet* values) {
   values->Clear();
   for (auto& arg : args_) {
-    auto value = arg.TryToCreateOnesValue(context, dynamic_params);
+    auto value =
+        arg.TryToCreateOnesValue(context, dynamic_params, device_init_);
     if (value) {
       values->AddKernelArgValue(std::move(value));
     } else {
@@ -115,6 +120,32 @@ labm8::Status KernelArgSet::SetOnes(const cl::Context& context,
   return labm8::Status::OK;
 }
 
+labm8::Status KernelArgSet::SetDynamicParams(
+    const cl::Context& context, const DynamicParams& dynamic_params,
+    const std::vector<long long>& args_array_bound,
+    KernelArgValuesSet* values) {
+  CHECK(values->values().size() == args_.size());
+  CHECK(args_array_bound.size() == args_.size());
+  for (size_t i = 0; i < args_.size(); ++i) {
+    if (args_[i].IsPointer()) {
+      values->values()[i]->SetActiveSize(args_array_bound[i]);
+    } else {
+      // Scalar values are derived from the dynamic params, and are cheap to
+      // re-create.
+      auto value = args_[i].TryToCreateRandomValue(context, dynamic_params,
+                                                 seed_);
+      if (!value) {
+        return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                             "Unsupported argument type.");
+      }
+      values->values()[i] = std::move(value);
+    }
+  }
+  return labm8::Status::OK;
+}
+
+const std::vector<KernelArg>& KernelArgSet::args() const { return args_; }
+
 string KernelArgSet::ToStringWithValue(const KernelArgValuesSet& arg_values) const {
   string s = "[";
   for (size_t i = 0; i < arg_values.values().size(); ++i) {
@@ -18,6 +18,7 @@
 #include "gpu/cldrive/kernel_arg.h"
 #include "gpu/cldrive/kernel_arg_values_set.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
+#include "labm8/cpp/port.h"
 #include "labm8/cpp/status.h"
 #include "third_party/opencl/cl.hpp"
 
@@ -26,7 +27,11 @@ namespace cldrive {
 
 class KernelArgSet {
  public:
-  KernelArgSet(cl::Kernel* kernel);
+  // Random values created by SetRandom() are determined by the seed. If
+  // device_init is true, global memory values are initialized on the device
+  // rather than uploaded from the host.
+  KernelArgSet(cl::Kernel* kernel, labm8::uint64 seed = 0,
+               bool device_init = false);
 
   CldriveKernelInstance::KernelInstanceOutcome LogErrorOutcome(
       const CldriveKernelInstance::KernelInstanceOutcome& outcome);
@@ -43,11 +48,23 @@ class KernelArgSet {
   labm8::Status SetOnes(const cl::Context& context,
                         const DynamicParams& dynamic_params,
                         KernelArgValuesSet* values);
+
+  // Update a set of values created by SetRandom() or SetOnes() for a new
+  // dynamic params, without re-allocating the global memory buffers. Pointer
+  // arguments use the number of elements given by args_array_bound, which
+  // must not exceed the number they were created with.
+  labm8::Status SetDynamicParams(const cl::Context& context,
+                                 const DynamicParams& dynamic_params,
+                                 const std::vector<long long>& args_array_bound,
+                                 KernelArgValuesSet* values);
+
   const std::vector<KernelArg>& args() const;
   string ToStringWithValue(const KernelArgValuesSet& values) const;
 
  private:
   cl::Kernel* kernel_;
+  labm8::uint64 seed_;
+  bool device_init_;
   std::vector<KernelArg> args_;
 };
 
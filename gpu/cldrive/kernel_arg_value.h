@@ -40,8 +40,31 @@ class KernelArgValue {
   virtual std::unique_ptr<KernelArgValue> CopyFromDevice(
       const cl::CommandQueue &queue, ProfilingData *profiling) = 0;
 
+  // Copy the device-side value into an existing value which was previously
+  // returned by CopyFromDevice(), re-using its host storage.
+  virtual void CopyFromDeviceInto(const cl::CommandQueue &queue,
+                                  KernelArgValue *value,
+                                  ProfilingData *profiling) = 0;
+
+  // Non-blocking variants of CopyToDevice() and CopyFromDeviceInto(). The
+  // transfers are complete once the transfer events appended to the profiling
+  // data have completed. The copy from the device begins once all of the
+  // given events have completed.
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) = 0;
+
+  virtual void EnqueueCopyFromDeviceInto(const cl::CommandQueue &queue,
+                                         const std::vector<cl::Event> &events,
+                                         KernelArgValue *value,
+                                         ProfilingData *profiling) = 0;
+
   virtual void SetAsArg(cl::Kernel *kernel, size_t arg_index) = 0;
 
+  // Set the number of elements used by the current dynamic params. Array
+  // values may be allocated once for the largest dynamic params of a sweep,
+  // in which case only this many leading elements are used and transferred.
+  virtual void SetActiveSize(size_t size) = 0;
+
   virtual bool operator==(const KernelArgValue *const rhs) const = 0;
 
   virtual bool operator!=(const KernelArgValue *const rhs) const = 0;
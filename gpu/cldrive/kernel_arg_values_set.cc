@@ -46,13 +46,50 @@ void KernelArgValuesSet::CopyToDevice(const cl::CommandQueue &queue,
 void KernelArgValuesSet::CopyFromDeviceToNewValueSet(
     const cl::CommandQueue &queue, KernelArgValuesSet *new_values,
     ProfilingData *profiling) const {
-  // TODO(cec): Refactor so this isn't causing mallocs() for every run.
   new_values->Clear();
   for (auto &value : values()) {
     new_values->AddKernelArgValue(value->CopyFromDevice(queue, profiling));
   }
 }
 
+void KernelArgValuesSet::CopyFromDevice(const cl::CommandQueue &queue,
+                                        KernelArgValuesSet *values,
+                                        ProfilingData *profiling) const {
+  if (values->values().size() != this->values().size()) {
+    CopyFromDeviceToNewValueSet(queue, values, profiling);
+    return;
+  }
+
+  for (size_t i = 0; i < this->values().size(); ++i) {
+    this->values()[i]->CopyFromDeviceInto(queue, values->values()[i].get(),
+                                          profiling);
+  }
+}
+
+void KernelArgValuesSet::EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                             ProfilingData *profiling) const {
+  for (auto &value : values()) {
+    value->EnqueueCopyToDevice(queue, profiling);
+  }
+}
+
+void KernelArgValuesSet::EnqueueCopyFromDevice(
+    const cl::CommandQueue &queue, const std::vector<cl::Event> &events,
+    KernelArgValuesSet *values, ProfilingData *profiling) const {
+  if (values->values().size() != this->values().size()) {
+    if (!events.empty()) {
+      cl::Event::waitForEvents(events);
+    }
+    CopyFromDeviceToNewValueSet(queue, values, profiling);
+    return;
+  }
+
+  for (size_t i = 0; i < this->values().size(); ++i) {
+    this->values()[i]->EnqueueCopyFromDeviceInto(
+        queue, events, values->values()[i].get(), profiling);
+  }
+}
+
 void KernelArgValuesSet::AddKernelArgValue(
     std::unique_ptr<KernelArgValue> value) {
   values().push_back(std::move(value));
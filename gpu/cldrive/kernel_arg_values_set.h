@@ -35,6 +35,26 @@ class KernelArgValuesSet {
                                    KernelArgValuesSet *new_values,
                                    ProfilingData *profiling) const;
 
+  // Copy the device-side values into an existing value set, re-using the
+  // host storage of its values. If the value set does not yet hold a value
+  // for every argument, new values are allocated as per
+  // CopyFromDeviceToNewValueSet().
+  void CopyFromDevice(const cl::CommandQueue &queue, KernelArgValuesSet *values,
+                      ProfilingData *profiling) const;
+
+  // Non-blocking variants of CopyToDevice() and CopyFromDevice(). The
+  // transfer events are appended to the profiling data. The copies from the
+  // device begin once all of the given events have completed. If the value
+  // set does not yet hold a value for every argument, the copy from the
+  // device is blocking.
+  void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                           ProfilingData *profiling) const;
+
+  void EnqueueCopyFromDevice(const cl::CommandQueue &queue,
+                             const std::vector<cl::Event> &events,
+                             KernelArgValuesSet *values,
+                             ProfilingData *profiling) const;
+
   void AddKernelArgValue(std::unique_ptr<KernelArgValue> value);
 
   void SetAsArgs(cl::Kernel *kernel);
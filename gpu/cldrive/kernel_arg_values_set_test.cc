@@ -15,13 +15,111 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/cldrive/kernel_arg_values_set.h"
 
+#include "gpu/cldrive/global_memory_arg_value.h"
+#include "gpu/cldrive/scalar_kernel_arg_value.h"
+
+#include "third_party/opencl/cl.hpp"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/port.h"
 #include "labm8/cpp/test.h"
 
 namespace gpu {
 namespace cldrive {
 namespace {
 
-TEST(TODO, TODO) { EXPECT_EQ(1, 1); }
+class KernelArgValuesSetTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    try {
+      context_ = cl::Context::getDefault();
+      queue_ = cl::CommandQueue(context_,
+                                /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+    } catch (cl::Error err) {
+      CHECK(false) << "OpenCL exception in KernelArgValuesSetTest::SetUp: "
+                   << err.what() << "(" << err.err() << ")";
+    }
+  }
+
+  // Create a value set of a ten element global int buffer and a scalar.
+  KernelArgValuesSet MakeInputs() {
+    KernelArgValuesSet inputs;
+    inputs.AddKernelArgValue(
+        std::make_unique<GlobalMemoryArgValueWithBuffer<labm8::int32>>(
+            context_, 10, 3));
+    inputs.AddKernelArgValue(
+        std::make_unique<ScalarKernelArgValue<labm8::int32>>(5));
+    return inputs;
+  }
+
+  cl::Context context_;
+  cl::CommandQueue queue_;
+};
+
+TEST_F(KernelArgValuesSetTest, CopyFromDeviceToNewValueSetIsEqual) {
+  KernelArgValuesSet inputs = MakeInputs();
+  ProfilingData profiling;
+  inputs.CopyToDevice(queue_, &profiling);
+
+  KernelArgValuesSet outputs;
+  inputs.CopyFromDeviceToNewValueSet(queue_, &outputs, &profiling);
+  EXPECT_EQ(inputs, outputs);
+}
+
+TEST_F(KernelArgValuesSetTest, CopyFromDeviceAllocatesOnFirstCopyOnly) {
+  KernelArgValuesSet inputs = MakeInputs();
+  ProfilingData profiling;
+  inputs.CopyToDevice(queue_, &profiling);
+
+  KernelArgValuesSet outputs;
+  ProfilingData first;
+  inputs.CopyFromDevice(queue_, &outputs, &first);
+  EXPECT_EQ(first.host_allocated_bytes,
+            sizeof(labm8::int32) * 10 + sizeof(labm8::int32));
+  EXPECT_EQ(inputs, outputs);
+
+  ProfilingData second;
+  inputs.CopyFromDevice(queue_, &outputs, &second);
+  EXPECT_EQ(second.host_allocated_bytes, 0);
+  EXPECT_EQ(inputs, outputs);
+}
+
+TEST_F(KernelArgValuesSetTest, CopyFromDeviceWithSmallerActiveSize) {
+  KernelArgValuesSet inputs = MakeInputs();
+  ProfilingData profiling;
+  inputs.CopyToDevice(queue_, &profiling);
+
+  KernelArgValuesSet outputs;
+  inputs.CopyFromDevice(queue_, &outputs, &profiling);
+
+  inputs.values()[0]->SetActiveSize(4);
+  ProfilingData second;
+  inputs.CopyFromDevice(queue_, &outputs, &second);
+  EXPECT_EQ(second.host_allocated_bytes, 0);
+  EXPECT_EQ(second.transferred_bytes, sizeof(labm8::int32) * 4);
+  EXPECT_EQ(outputs.values()[0]->Size(), 4);
+  EXPECT_EQ(inputs, outputs);
+}
+
+TEST_F(KernelArgValuesSetTest, EnqueueCopyFromDeviceIsEqual) {
+  KernelArgValuesSet inputs = MakeInputs();
+  KernelArgValuesSet outputs;
+  ProfilingData profiling;
+  inputs.CopyFromDevice(queue_, &outputs, &profiling);
+
+  ProfilingData pipelined;
+  inputs.EnqueueCopyToDevice(queue_, &pipelined);
+  const std::vector<cl::Event> uploads = pipelined.transfer_events;
+  inputs.EnqueueCopyFromDevice(queue_, uploads, &outputs, &pipelined);
+  EXPECT_EQ(pipelined.transfer_events.size(), 2);
+  queue_.finish();
+  pipelined.CollectTransferEvents();
+
+  EXPECT_TRUE(pipelined.transfer_events.empty());
+  EXPECT_EQ(pipelined.transferred_bytes, 2 * sizeof(labm8::int32) * 10);
+  EXPECT_EQ(pipelined.host_allocated_bytes, 0);
+  EXPECT_EQ(inputs, outputs);
+}
 
 }  // anonymous namespace
 }  // namespace cldrive
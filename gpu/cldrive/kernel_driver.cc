@@ -19,10 +19,15 @@
 #include "gpu/cldrive/opencl_util.h"
 #include "gpu/clinfo/libclinfo.h"
 #include "gpu/cldrive/mem_analysis_util.h"
+#include "gpu/cldrive/statistics.h"
 
 #include "labm8/cpp/logging.h"
 #include "labm8/cpp/status_macros.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
 namespace gpu {
 namespace cldrive {
 
@@ -38,7 +43,7 @@ KernelDriver::KernelDriver(const cl::Context& context,
       instance_num_(instance_num),
       kernel_instance_(instance->add_kernel()),
       name_(util::GetOpenClKernelName(kernel)),
-      args_set_(&kernel_) {}
+      args_set_(&kernel_, instance->seed(), instance->device_init()) {}
 
 void KernelDriver::RunOrDie(Logger& logger) {
   kernel_instance_->set_name(name_);
@@ -46,6 +51,7 @@ void KernelDriver::RunOrDie(Logger& logger) {
       kernel_.getWorkGroupInfo<CL_KERNEL_LOCAL_MEM_SIZE>(device_));
   kernel_instance_->set_work_item_private_mem_size_in_bytes(
       kernel_.getWorkGroupInfo<CL_KERNEL_PRIVATE_MEM_SIZE>(device_));
+  logger.StartKernelInstance(&instance_, kernel_instance_);
 
   kernel_instance_->set_outcome(args_set_.Init());
   if (kernel_instance_->outcome() != CldriveKernelInstance::PASS) {
@@ -56,10 +62,55 @@ void KernelDriver::RunOrDie(Logger& logger) {
     return;
   }
 
+  if (!instance_.dynamic_params_size()) {
+    return;
+  }
+
+  arg_bounds_.assign(args_set_.args().size(), nullptr);
+  for (const auto& bound : instance_.arg_bound()) {
+    if (bound.arg_index() >= 0 &&
+        static_cast<size_t>(bound.arg_index()) < arg_bounds_.size()) {
+      arg_bounds_[bound.arg_index()] = &bound;
+    }
+  }
+
+  // Allocate the argument values once, sized for the largest bound of each
+  // argument across the dynamic params. Every dynamic params then runs
+  // against the same buffers.
+  std::vector<long long> max_arg_array_bounds =
+      GetArgArrayBounds(instance_.dynamic_params(0));
+  for (int i = 1; i < instance_.dynamic_params_size(); ++i) {
+    auto bounds = GetArgArrayBounds(instance_.dynamic_params(i));
+    for (size_t j = 0; j < bounds.size(); ++j) {
+      max_arg_array_bounds[j] = std::max(max_arg_array_bounds[j], bounds[j]);
+    }
+  }
+  for (auto bound : max_arg_array_bounds) {
+    kernel_instance_->add_arg_array_bounds(bound);
+  }
+
+  try {
+    CHECK(args_set_.SetRandom(context_, max_arg_array_bounds, &inputs_).ok());
+  } catch (cl::Error error) {
+    LOG(WARNING) << "Error code " << error.err() << " ("
+                 << labm8::gpu::clinfo::OpenClErrorString(error.err()) << ") "
+                 << "raised by " << error.what()
+                 << "() while allocating arguments for kernel: '" << name_
+                 << "'";
+    for (int i = 0; i < instance_.dynamic_params_size(); ++i) {
+      CldriveKernelRun run;
+      *run.mutable_dynamic_params() = instance_.dynamic_params(i);
+      run.set_outcome(CldriveKernelRun::CL_ERROR);
+      logger.RecordLog(&instance_, kernel_instance_, &run, /*log=*/nullptr);
+      RecordRun(logger, run);
+    }
+    return;
+  }
+
   for (int i = 0; i < instance_.dynamic_params_size(); ++i) {
     auto run = RunDynamicParams(instance_.dynamic_params(i), logger);
     if (run.ok()) {
-      *kernel_instance_->add_run() = run.ValueOrDie();
+      RecordRun(logger, run.ValueOrDie());
     } else {
       kernel_instance_->clear_run();
       kernel_instance_->set_outcome(
@@ -68,9 +119,17 @@ void KernelDriver::RunOrDie(Logger& logger) {
   }
 }
 
+void KernelDriver::RecordRun(Logger& logger, const CldriveKernelRun& run) {
+  logger.RecordRun(&instance_, kernel_instance_, &run);
+  if (logger.RetainsRuns()) {
+    *kernel_instance_->add_run() = run;
+  }
+}
+
 labm8::StatusOr<CldriveKernelRun> KernelDriver::RunDynamicParams(
     const DynamicParams& dynamic_params, Logger& logger) {
   CldriveKernelRun run;
+  *run.mutable_dynamic_params() = dynamic_params;
 
   try {
     RunDynamicParams(dynamic_params, logger, &run);
@@ -97,6 +156,7 @@ gpu::libcecl::OpenClKernelInvocation DynamicParamsToLog(
   invocation.set_kernel_time_ns(-1);
   invocation.set_transfer_time_ns(-1);
   invocation.set_transferred_bytes(-1);
+  invocation.set_host_allocated_bytes(-1);
   return invocation;
 }
 
@@ -122,49 +182,120 @@ labm8::Status KernelDriver::RunDynamicParams(
                          "Unsupported dynamic params");
   }
 
-  // generate array bound based on dynamic params
-  std::map<int,int> memAnalysisInfo = gpu::cldrive::mem_analysis::getMemAnalysisInfo(instance_.mem_filepath(), 
-                                                                                      dynamic_params.global_size_x(), 
-                                                                                      dynamic_params.local_size_x());
-  std::vector<long long> arrayBoundArgs;
-  int nArgs = kernel_.getInfo<CL_KERNEL_NUM_ARGS>();
-  for (int i = 0; i < nArgs; ++i) {
-    // if mem analysis info is not found, then use global size as array bound
-    if (memAnalysisInfo.find(i) != memAnalysisInfo.end()) {
-      kernel_instance_->add_arg_array_bounds(dynamic_params.global_size_x());
-    }
-    else {
-      kernel_instance_->add_arg_array_bounds(memAnalysisInfo[i]);
-    }
+  const std::vector<long long> arg_array_bounds =
+      GetArgArrayBounds(dynamic_params);
+  for (auto bound : arg_array_bounds) {
+    run->add_arg_array_bounds(bound);
   }
 
-  // 2 warmup run
-  KernelArgValuesSet inputs;
-  KernelArgValuesSet output_a;
-  CHECK(args_set_.SetRandom(context_, dynamic_params, &inputs).ok());
-  inputs.SetAsArgs(&kernel_);
-  RunOnceOrDie(dynamic_params, inputs, &output_a);
-  RunOnceOrDie(dynamic_params, inputs, &output_a);
+  CHECK(args_set_
+            .SetDynamicParams(context_, dynamic_params, arg_array_bounds,
+                              &inputs_)
+            .ok());
+  inputs_.SetAsArgs(&kernel_);
+
+  // Warm up until the kernel times of successive runs have stabilized. The
+  // first run is the cold run, which includes any lazy compilation or device
+  // clock ramp-up.
+  const int max_warmup_runs = std::max(instance_.max_warmup_runs(), 1);
+  labm8::int64 previous_kernel_time = 0;
+  int num_warmup_runs = 0;
+  while (num_warmup_runs < max_warmup_runs) {
+    labm8::int64 kernel_time =
+        RunOnceOrDie(dynamic_params, inputs_, &outputs_).kernel_time_ns();
+    if (!num_warmup_runs++) {
+      run->set_cold_kernel_time_ns(kernel_time);
+    } else if (std::abs(kernel_time - previous_kernel_time) <=
+               instance_.warmup_tolerance() * previous_kernel_time) {
+      break;
+    }
+    previous_kernel_time = kernel_time;
+  }
+  run->set_num_warmup_runs(num_warmup_runs);
   // We've passed the point of rejecting the kernel. Flush the buffered logs
   // from the preliminary runs.
   logger.PrintAndClearBuffer();
 
-  for (int i = 0; i < instance_.min_runs_per_kernel(); ++i) {
+  // Run at least min_runs_per_kernel times. If a target confidence interval
+  // width is set, continue until the confidence interval of the median kernel
+  // time is narrow enough, or the run count or time budget is exhausted.
+  const int min_runs = instance_.min_runs_per_kernel();
+  const int max_runs = std::max(min_runs, instance_.max_runs_per_kernel());
+  const auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(instance_.max_run_time_ms_per_dynamic_params());
+  std::vector<labm8::int64> kernel_times;
+  for (int i = 0;; ++i) {
+    if (i >= min_runs) {
+      if (instance_.target_relative_ci_width() <= 0 || i >= max_runs ||
+          kernel_times.empty()) {
+        break;
+      }
+      if (util::GetMedianConfidenceInterval(kernel_times).RelativeWidth() <=
+          instance_.target_relative_ci_width()) {
+        break;
+      }
+      if (instance_.max_run_time_ms_per_dynamic_params() > 0 &&
+          std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+    }
+
     *run->add_log() =
-        RunOnceOrDie(dynamic_params, inputs, &output_a, run, logger);
+        RunOnceOrDie(dynamic_params, inputs_, &outputs_, run, logger);
+    kernel_times.push_back(run->log(run->log_size() - 1).kernel_time_ns());
+  }
+
+  run->set_num_runs(kernel_times.size());
+  if (!kernel_times.empty()) {
+    auto interval = util::GetMedianConfidenceInterval(kernel_times);
+    run->set_kernel_time_ns_median(interval.median);
+    run->set_kernel_time_ns_ci_lower(interval.lower);
+    run->set_kernel_time_ns_ci_upper(interval.upper);
   }
 
   run->set_outcome(CldriveKernelRun::PASS);
   return labm8::Status::OK;
 }
 
+std::vector<long long> KernelDriver::GetArgArrayBounds(
+    const DynamicParams& dynamic_params) const {
+  std::vector<long long> bounds;
+  for (size_t i = 0; i < args_set_.args().size(); ++i) {
+    const KernelArg& arg = args_set_.args()[i];
+    if (arg.IsPointer() && arg.IsGlobal() && i < arg_bounds_.size() &&
+        arg_bounds_[i]) {
+      // Buffers must have at least one element.
+      bounds.push_back(std::max(
+          mem_analysis::getArgArrayBound(*arg_bounds_[i],
+                                         dynamic_params.global_size_x(),
+                                         dynamic_params.local_size_x()),
+          1LL));
+    } else {
+      bounds.push_back(dynamic_params.global_size_x());
+    }
+  }
+  return bounds;
+}
+
 gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
     const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
     KernelArgValuesSet* outputs, const CldriveKernelRun* const run,
     Logger& logger, bool flush) {
+  gpu::libcecl::OpenClKernelInvocation log =
+      RunOnceOrDie(dynamic_params, inputs, outputs);
+  log.set_args_info(args_set_.ToStringWithValue(inputs));
+
+  logger.RecordLog(&instance_, kernel_instance_, run, &log, flush);
+
+  return log;
+}
+
+gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
+    const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
+    KernelArgValuesSet* outputs) {
   gpu::libcecl::OpenClKernelInvocation log;
   ProfilingData profiling;
-  cl::Event event;
 
   size_t global_size = dynamic_params.global_size_x();
   size_t local_size = dynamic_params.local_size_x();
@@ -173,59 +304,66 @@ gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
   log.set_local_size(local_size);
   log.set_kernel_name(name_);
 
-  inputs.CopyToDevice(queue_, &profiling);
-  inputs.SetAsArgs(&kernel_);
-
-  queue_.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
-                              /*global=*/cl::NDRange(global_size),
-                              /*local=*/cl::NDRange(local_size),
-                              /*events=*/nullptr, /*event=*/&event);
-  profiling.kernel_nanoseconds += GetElapsedNanoseconds(event);
-
-  inputs.CopyFromDeviceToNewValueSet(queue_, outputs, &profiling);
+  if (instance_.pipelined()) {
+    EnqueueRun(global_size, local_size, inputs, outputs, &profiling);
+  } else {
+    BlockingRun(global_size, local_size, inputs, outputs, &profiling);
+  }
 
   // Set run proto fields.
   log.set_kernel_time_ns(profiling.kernel_nanoseconds);
   log.set_transfer_time_ns(profiling.transfer_nanoseconds);
   log.set_transferred_bytes(profiling.transferred_bytes);
-  log.set_args_info(args_set_.ToStringWithValue(inputs));
-
-  logger.RecordLog(&instance_, kernel_instance_, run, &log, flush);
+  log.set_host_allocated_bytes(profiling.host_allocated_bytes);
 
   return log;
 }
 
-gpu::libcecl::OpenClKernelInvocation KernelDriver::RunOnceOrDie(
-    const DynamicParams& dynamic_params, KernelArgValuesSet& inputs,
-    KernelArgValuesSet* outputs) {
-  gpu::libcecl::OpenClKernelInvocation log;
-  ProfilingData profiling;
+void KernelDriver::BlockingRun(size_t global_size, size_t local_size,
+                               KernelArgValuesSet& inputs,
+                               KernelArgValuesSet* outputs,
+                               ProfilingData* profiling) {
   cl::Event event;
 
-  size_t global_size = dynamic_params.global_size_x();
-  size_t local_size = dynamic_params.local_size_x();
-
-  log.set_global_size(global_size);
-  log.set_local_size(local_size);
-  log.set_kernel_name(name_);
-
-  inputs.CopyToDevice(queue_, &profiling);
+  inputs.CopyToDevice(queue_, profiling);
   inputs.SetAsArgs(&kernel_);
 
   queue_.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
                               /*global=*/cl::NDRange(global_size),
                               /*local=*/cl::NDRange(local_size),
                               /*events=*/nullptr, /*event=*/&event);
-  profiling.kernel_nanoseconds += GetElapsedNanoseconds(event);
+  profiling->kernel_nanoseconds += GetElapsedNanoseconds(event);
 
-  inputs.CopyFromDeviceToNewValueSet(queue_, outputs, &profiling);
+  inputs.CopyFromDevice(queue_, outputs, profiling);
+}
 
-  // Set run proto fields.
-  log.set_kernel_time_ns(profiling.kernel_nanoseconds);
-  log.set_transfer_time_ns(profiling.transfer_nanoseconds);
-  log.set_transferred_bytes(profiling.transferred_bytes);
+void KernelDriver::EnqueueRun(size_t global_size, size_t local_size,
+                              KernelArgValuesSet& inputs,
+                              KernelArgValuesSet* outputs,
+                              ProfilingData* profiling) {
+  cl::Event event;
 
-  return log;
+  inputs.EnqueueCopyToDevice(queue_, profiling);
+  inputs.SetAsArgs(&kernel_);
+
+  // The kernel waits on the uploads, and the readbacks wait on the kernel.
+  // The queue is in-order, but chaining the events keeps the dependencies
+  // explicit.
+  const std::vector<cl::Event> uploads = profiling->transfer_events;
+  queue_.enqueueNDRangeKernel(kernel_, /*offset=*/cl::NullRange,
+                              /*global=*/cl::NDRange(global_size),
+                              /*local=*/cl::NDRange(local_size),
+                              /*events=*/uploads.empty() ? nullptr : &uploads,
+                              /*event=*/&event);
+
+  inputs.EnqueueCopyFromDevice(queue_, {event}, outputs, profiling);
+
+  // A single synchronization point per run. Every command has completed once
+  // the queue is finished, so the profiling info can be read from the
+  // retained events without further waiting.
+  queue_.finish();
+  profiling->kernel_nanoseconds += GetExecutionNanoseconds(event);
+  profiling->CollectTransferEvents();
 }
 
 }  // namespace cldrive
@@ -22,6 +22,8 @@
 #include "labm8/cpp/string.h"
 #include "third_party/opencl/cl.hpp"
 
+#include <vector>
+
 namespace gpu {
 namespace cldrive {
 
@@ -49,11 +51,33 @@ class KernelDriver {
     KernelArgValuesSet* outputs);
 
  private:
+  // Return the number of elements of each argument for the given dynamic
+  // params. Global memory arguments use the bound from the memory analysis
+  // of the kernel. Arguments without an analysed bound fall back to the
+  // global size.
+  std::vector<long long> GetArgArrayBounds(
+      const DynamicParams& dynamic_params) const;
+
+  // Pass a completed run to the logger, and add it to the kernel instance if
+  // the logger retains runs.
+  void RecordRun(Logger& logger, const CldriveKernelRun& run);
+
   // Private helper to public RunDynamicParams() method that doesn't catch
   // OpenCL exceptions.
   labm8::Status RunDynamicParams(const DynamicParams& dynamic_params,
                                  Logger& logger, CldriveKernelRun* run);
 
+  // Run the kernel once, blocking on each transfer and on the kernel.
+  void BlockingRun(size_t global_size, size_t local_size,
+                   KernelArgValuesSet& inputs, KernelArgValuesSet* outputs,
+                   ProfilingData* profiling);
+
+  // Run the kernel once, chaining non-blocking transfers and the kernel
+  // through event wait lists, and synchronizing once at the end of the run.
+  void EnqueueRun(size_t global_size, size_t local_size,
+                  KernelArgValuesSet& inputs, KernelArgValuesSet* outputs,
+                  ProfilingData* profiling);
+
   cl::Context context_;
   cl::CommandQueue queue_;
   cl::Device device_;
@@ -63,6 +87,14 @@ class KernelDriver {
   CldriveKernelInstance* kernel_instance_;
   string name_;
   KernelArgSet args_set_;
+  // The memory analysis bound of each argument of the kernel, indexed by
+  // argument, or nullptr if the argument has none. Points into instance_.
+  std::vector<const ArgBound*> arg_bounds_;
+  // The argument values are allocated once for the largest bound of each
+  // argument across the dynamic params of the instance, and reused for every
+  // dynamic params.
+  KernelArgValuesSet inputs_;
+  KernelArgValuesSet outputs_;
 };
 
 }  // namespace cldrive
@@ -17,6 +17,8 @@
 
 #include "gpu/cldrive/kernel_arg_value.h"
 #include "gpu/cldrive/kernel_driver.h"
+#include "gpu/cldrive/opencl_context_pool.h"
+#include "gpu/cldrive/opencl_util.h"
 #include "gpu/clinfo/libclinfo.h"
 
 #include "labm8/cpp/logging.h"
@@ -25,6 +27,7 @@
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/strip.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -38,18 +41,123 @@ namespace cldrive {
 
 namespace {
 
-// Attempt to build OpenCL program.
+// Return whether the kernels of a program provide argument info. Programs
+// created from binaries may not retain the info requested by
+// -cl-kernel-arg-info, which cldrive needs to read the kernel signatures.
+bool HasKernelArgInfo(const cl::Program& program) {
+  try {
+    const string kernel_names =
+        program.getInfo<CL_PROGRAM_KERNEL_NAMES>().c_str();
+    for (absl::string_view name :
+         absl::StrSplit(kernel_names, ';', absl::SkipEmpty())) {
+      cl::Kernel kernel(program, string(name).c_str());
+      if (kernel.getInfo<CL_KERNEL_NUM_ARGS>()) {
+        kernel.getArgInfo<CL_KERNEL_ARG_TYPE_NAME>(0);
+      }
+    }
+    return true;
+  } catch (cl::Error e) {
+    return false;
+  }
+}
+
+// Return the binary of a program built for a single device, or an empty
+// string if the binary is not available.
+string GetProgramBinary(const cl::Program& program) {
+  auto sizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>();
+  if (sizes.size() != 1 || !sizes[0]) {
+    return "";
+  }
+
+  string binary(sizes[0], '\0');
+  unsigned char* binary_ptr = reinterpret_cast<unsigned char*>(&binary[0]);
+  if (::clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(binary_ptr),
+                         &binary_ptr, nullptr) != CL_SUCCESS) {
+    return "";
+  }
+  return binary;
+}
+
+// Attempt to load a cached program binary.
+labm8::StatusOr<cl::Program> LoadOpenClProgram(const string& binary,
+                                               const cl::Context& context,
+                                               const string& all_build_opts) {
+  try {
+    cl::Program::Binaries binaries{{binary.data(), binary.size()}};
+    cl::Program program(context, context.getInfo<CL_CONTEXT_DEVICES>(),
+                        binaries);
+    program.build(context.getInfo<CL_CONTEXT_DEVICES>(),
+                  all_build_opts.c_str());
+    if (!HasKernelArgInfo(program)) {
+      return labm8::Status(labm8::error::Code::FAILED_PRECONDITION,
+                           "Program binary does not provide kernel arg info");
+    }
+    return program;
+  } catch (cl::Error e) {
+    LOG_CL_ERROR(WARNING, e);
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Failed to load program binary");
+  }
+}
+
+// Attempt to build OpenCL program. If a program pool is provided, a pooled
+// program is used in place of a build, and built programs are pooled. If a
+// program cache is provided, cached binaries and compilation failures are used
+// in place of a build, and the outcome of a build is cached.
 labm8::StatusOr<cl::Program> BuildOpenClProgram(
     const std::string& opencl_kernel, const cl::Context& context,
-    const string& cl_build_opts) {
+    const string& cl_build_opts, const ::gpu::clinfo::OpenClDevice& device,
+    const ProgramCache* program_cache, ProgramPool* program_pool) {
   auto start_time = absl::Now();
-  try {
-    // Assemble the build options. We need -cl-kernel-arg-info so that we can
-    // read the kernel signatures.
-    string all_build_opts = "-cl-kernel-arg-info ";
-    absl::StrAppend(&all_build_opts, cl_build_opts);
-    labm8::TrimRight(all_build_opts);
 
+  // Assemble the build options. We need -cl-kernel-arg-info so that we can
+  // read the kernel signatures.
+  string all_build_opts = "-cl-kernel-arg-info ";
+  absl::StrAppend(&all_build_opts, cl_build_opts);
+  labm8::TrimRight(all_build_opts);
+
+  string cache_key;
+  if (program_cache || program_pool) {
+    cache_key = ProgramCache::GetKey(opencl_kernel, all_build_opts, device);
+  }
+
+  if (program_pool) {
+    cl::Program program;
+    if (program_pool->Get(cache_key, &program)) {
+      LOG(INFO) << "Reusing built program with options '" << all_build_opts
+                << "'";
+      return program;
+    }
+  }
+
+  if (program_cache) {
+    if (program_cache->IsKnownFailure(cache_key)) {
+      LOG(INFO) << "clBuildProgram() with options '" << all_build_opts
+                << "' is known to fail, skipping build";
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "clBuildProgram failed");
+    }
+
+    auto binary = program_cache->LoadBinary(cache_key);
+    if (binary.ok()) {
+      auto program =
+          LoadOpenClProgram(binary.ValueOrDie(), context, all_build_opts);
+      if (program.ok()) {
+        if (program_pool) {
+          program_pool->Put(cache_key, program.ValueOrDie());
+        }
+        auto duration = (absl::Now() - start_time) / absl::Milliseconds(1);
+        LOG(INFO) << "Loaded cached program binary with options '"
+                  << all_build_opts << "' in " << duration << " ms";
+        return program;
+      }
+      LOG(INFO) << "Cached program binary not usable ("
+                << program.status().error_message()
+                << "), building from source";
+    }
+  }
+
+  try {
     cl::Program program(context, opencl_kernel);
     program.build(context.getInfo<CL_CONTEXT_DEVICES>(),
                   all_build_opts.c_str());
@@ -57,9 +165,24 @@ labm8::StatusOr<cl::Program> BuildOpenClProgram(
     auto duration = (end_time - start_time) / absl::Milliseconds(1);
     LOG(INFO) << "clBuildProgram() with options '" << all_build_opts
               << "' completed in " << duration << " ms";
+    if (program_cache) {
+      string binary = GetProgramBinary(program);
+      if (!binary.empty()) {
+        program_cache->StoreBinary(cache_key, binary);
+      }
+    }
+    if (program_pool) {
+      program_pool->Put(cache_key, program);
+    }
     return program;
   } catch (cl::Error e) {
     LOG_CL_ERROR(WARNING, e);
+    // Only cache errors which are determined by the program and options, not
+    // transient errors such as running out of resources.
+    if (program_cache && (e.err() == CL_BUILD_PROGRAM_FAILURE ||
+                          e.err() == CL_INVALID_BUILD_OPTIONS)) {
+      program_cache->StoreFailure(cache_key);
+    }
     return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
                          "clBuildProgram failed");
   }
@@ -67,14 +190,40 @@ labm8::StatusOr<cl::Program> BuildOpenClProgram(
 
 }  // namespace
 
-Cldrive::Cldrive(CldriveInstance* instance, int instance_num)
+labm8::StatusOr<cl::Program> BuildProgram(const CldriveInstance& instance,
+                                          const ProgramCache* program_cache,
+                                          ProgramPool* program_pool) {
+  const cl::Device device =
+      labm8::gpu::clinfo::GetOpenClDeviceOrDie(instance.device());
+  const cl::Context& context =
+      OpenClContextPool::Get().GetOrCreate(device).context;
+  return BuildOpenClProgram(string(instance.opencl_src()), context,
+                            instance.build_opts(), instance.device(),
+                            program_cache, program_pool);
+}
+
+Cldrive::Cldrive(CldriveInstance* instance, int instance_num,
+                 const ProgramCache* program_cache, ProgramPool* program_pool)
     : instance_(instance),
       instance_num_(instance_num),
-      device_(labm8::gpu::clinfo::GetOpenClDeviceOrDie(instance->device())) {}
+      program_cache_(program_cache),
+      program_pool_(program_pool),
+      device_(labm8::gpu::clinfo::GetOpenClDeviceOrDie(instance->device())),
+      num_skipped_kernels_(0) {}
 
 void Cldrive::RunOrDie(Logger& logger) {
+  TryRunOrDie(logger, /*prebuilt_program=*/nullptr);
+}
+
+void Cldrive::RunOrDie(Logger& logger,
+                       const labm8::StatusOr<cl::Program>& program) {
+  TryRunOrDie(logger, &program);
+}
+
+void Cldrive::TryRunOrDie(
+    Logger& logger, const labm8::StatusOr<cl::Program>* prebuilt_program) {
   try {
-    DoRunOrDie(logger);
+    DoRunOrDie(logger, prebuilt_program);
   } catch (cl::Error error) {
     LOG(FATAL) << "Unhandled OpenCL exception.\n"
                << "    Raised by:  " << error.what() << '\n'
@@ -83,17 +232,24 @@ void Cldrive::RunOrDie(Logger& logger) {
                << "This is a bug! Please report to "
                << "<https://github.com/ChrisCummins/cldrive/issues>.";
   }
+  logger.RecordInstance(instance_);
 }
 
-void Cldrive::DoRunOrDie(Logger& logger) {
-  cl::Context context(device_);
-  cl::CommandQueue queue(context,
-                         /*devices=*/context.getInfo<CL_CONTEXT_DEVICES>()[0],
-                         /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+void Cldrive::DoRunOrDie(Logger& logger,
+                         const labm8::StatusOr<cl::Program>* prebuilt_program) {
+  // The context and queue are shared by every program run on this device.
+  const OpenClDeviceContext& device_context =
+      OpenClContextPool::Get().GetOrCreate(device_);
+  const cl::Context& context = device_context.context;
+  const cl::CommandQueue& queue = device_context.queue;
 
   // Compile program or fail.
-  labm8::StatusOr<cl::Program> program_or = BuildOpenClProgram(
-      string(instance_->opencl_src()), context, instance_->build_opts());
+  labm8::StatusOr<cl::Program> program_or =
+      prebuilt_program
+          ? *prebuilt_program
+          : BuildOpenClProgram(string(instance_->opencl_src()), context,
+                               instance_->build_opts(), instance_->device(),
+                               program_cache_, program_pool_);
   if (!program_or.ok()) {
     LOG(ERROR) << "OpenCL program compilation failed!";
     instance_->set_outcome(CldriveInstance::PROGRAM_COMPILATION_FAILURE);
@@ -103,8 +259,7 @@ void Cldrive::DoRunOrDie(Logger& logger) {
   }
   cl::Program program = program_or.ValueOrDie();
 
-  std::vector<cl::Kernel> kernels;
-  program.createKernels(&kernels);
+  std::vector<cl::Kernel> kernels = util::CreateKernels(program);
 
   if (!kernels.size()) {
     LOG(ERROR) << "OpenCL program contains no kernels!";
@@ -112,18 +267,14 @@ void Cldrive::DoRunOrDie(Logger& logger) {
     return;
   }
 
-  for (auto& kernel : kernels) {
-    KernelDriver(context, queue, kernel, instance_, instance_num_)
+  for (size_t i = num_skipped_kernels_; i < kernels.size(); ++i) {
+    KernelDriver(context, queue, kernels[i], instance_, instance_num_)
         .RunOrDie(logger);
+    logger.RecordKernelInstance(
+        instance_, &instance_->kernel(instance_->kernel_size() - 1));
   }
 
   instance_->set_outcome(CldriveInstance::PASS);
-
-  // TODO: explain
-  for (auto kernel : kernels) {
-    cl_kernel k = *(cl_kernel*)&kernel;
-    ::clReleaseKernel(k);
-  }
 }
 
 }  // namespace cldrive
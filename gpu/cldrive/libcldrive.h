@@ -16,8 +16,12 @@
 #pragma once
 
 #include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/cldrive/program_pool.h"
 #include "gpu/cldrive/proto/cldrive.pb.h"
 
+#include "labm8/cpp/statusor.h"
+
 #include "third_party/opencl/cl.hpp"
 
 namespace gpu {
@@ -25,19 +29,50 @@ namespace cldrive {
 
 class Cldrive {
  public:
-  Cldrive(CldriveInstance* instance, int instance_num = 0);
+  // If a program cache is provided, it is used to load and store the compiled
+  // program. If a program pool is provided, built programs are taken from and
+  // added to it.
+  Cldrive(CldriveInstance* instance, int instance_num = 0,
+          const ProgramCache* program_cache = nullptr,
+          ProgramPool* program_pool = nullptr);
 
   void RunOrDie(Logger& logger);
 
+  // Run the instance with a program returned by BuildProgram(), rather than
+  // building it.
+  void RunOrDie(Logger& logger, const labm8::StatusOr<cl::Program>& program);
+
+  // Run only the kernels of the program after the first num_kernels, e.g.
+  // when the others have already been run by another process.
+  void SkipKernels(int num_kernels) { num_skipped_kernels_ = num_kernels; }
+
  private:
-  void DoRunOrDie(Logger& logger);
+  // If prebuilt_program is null, the program is built.
+  void TryRunOrDie(Logger& logger,
+                   const labm8::StatusOr<cl::Program>* prebuilt_program);
+  void DoRunOrDie(Logger& logger,
+                  const labm8::StatusOr<cl::Program>* prebuilt_program);
 
   CldriveInstance* instance_;
   int instance_num_;
+  const ProgramCache* program_cache_;
+  ProgramPool* program_pool_;
   cl::Device device_;
+  int num_skipped_kernels_;
 };
 
-void ProcessCldriveInstancesOrDie(CldriveInstances* instance);
+// Build the program of an instance in the context of its device, using the
+// program cache and pool as Cldrive does. This is thread-safe, so that
+// programs may be built while other programs are running.
+labm8::StatusOr<cl::Program> BuildProgram(
+    const CldriveInstance& instance,
+    const ProgramCache* program_cache = nullptr,
+    ProgramPool* program_pool = nullptr);
+
+// Run the instances, or with more than one shard, the part of each instance
+// in the shard.
+void ProcessCldriveInstancesOrDie(CldriveInstances* instance,
+                                  int shard_index = 0, int num_shards = 1);
 
 }  // namespace cldrive
 }  // namespace gpu
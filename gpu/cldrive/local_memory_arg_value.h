@@ -44,6 +44,8 @@ class LocalMemoryArgValue : public KernelArgValue {
     kernel->setArg(arg_index, SizeInBytes(), nullptr);
   };
 
+  virtual void SetActiveSize(size_t size) override { size_ = size; }
+
   virtual void CopyToDevice(const cl::CommandQueue &queue,
                             ProfilingData *profiling) override{};
 
@@ -52,6 +54,22 @@ class LocalMemoryArgValue : public KernelArgValue {
     return std::make_unique<LocalMemoryArgValue<T>>(size_);
   }
 
+  virtual void CopyFromDeviceInto(const cl::CommandQueue &queue,
+                                  KernelArgValue *value,
+                                  ProfilingData *profiling) override {
+    value->SetActiveSize(size_);
+  }
+
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) override{};
+
+  virtual void EnqueueCopyFromDeviceInto(const cl::CommandQueue &queue,
+                                         const std::vector<cl::Event> &events,
+                                         KernelArgValue *value,
+                                         ProfilingData *profiling) override {
+    CopyFromDeviceInto(queue, value, profiling);
+  }
+
   virtual string ToString() const override { return "[local memory]"; }
 
   virtual size_t SizeInBytes() const override { return sizeof(T) * size_; }
@@ -59,7 +77,7 @@ class LocalMemoryArgValue : public KernelArgValue {
   virtual size_t Size() const override { return size_; }
 
  private:
-  const size_t size_;
+  size_t size_;
 };
 }  // namespace cldrive
 }  // namespace gpu
@@ -14,6 +14,10 @@
 // You should have received a copy of the GNU General Public License
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/cldrive/logger.h"
+
+#include "gpu/cldrive/delimited_util.h"
+#include "gpu/cldrive/results_store.h"
+
 #include "labm8/cpp/logging.h"
 
 namespace gpu {
@@ -27,6 +31,11 @@ Logger::Logger(std::ostream& ostream, const CldriveInstances* const instances)
   return labm8::Status::OK;
 }
 
+labm8::Status Logger::StartNewInstance(int instance_num) {
+  instance_num_ = instance_num - 1;
+  return StartNewInstance();
+}
+
 /*virtual*/ labm8::Status Logger::RecordLog(
     const CldriveInstance* const instance,
     const CldriveKernelInstance* const kernel_instance,
@@ -36,12 +45,38 @@ Logger::Logger(std::ostream& ostream, const CldriveInstances* const instances)
   return labm8::Status::OK;
 }
 
-void Logger::PrintAndClearBuffer() {
+/*virtual*/ labm8::Status Logger::StartKernelInstance(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance) {
+  return labm8::Status::OK;
+}
+
+/*virtual*/ labm8::Status Logger::RecordRun(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  return labm8::Status::OK;
+}
+
+/*virtual*/ labm8::Status Logger::RecordKernelInstance(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance) {
+  return labm8::Status::OK;
+}
+
+/*virtual*/ labm8::Status Logger::RecordInstance(
+    const CldriveInstance* const instance) {
+  return labm8::Status::OK;
+}
+
+/*virtual*/ bool Logger::RetainsRuns() const { return true; }
+
+/*virtual*/ void Logger::PrintAndClearBuffer() {
   ostream_ << buffer_.str();
   ClearBuffer();
 }
 
-void Logger::ClearBuffer() {
+/*virtual*/ void Logger::ClearBuffer() {
   buffer_.clear();
   buffer_.str(string());
 }
@@ -73,10 +108,74 @@ ProtocolBufferLogger::ProtocolBufferLogger(
   }
 }
 
+StreamingProtocolBufferLogger::StreamingProtocolBufferLogger(
+    std::ostream& ostream, const CldriveInstances* const instances)
+    : Logger(ostream, instances) {}
+
+/*virtual*/ labm8::Status StreamingProtocolBufferLogger::RecordRun(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  CldriveLogRecord record = NewRecord(instance);
+  record.set_kernel_name(kernel_instance->name());
+  *record.mutable_run() = *run;
+  return WriteRecord(record);
+}
+
+/*virtual*/ labm8::Status StreamingProtocolBufferLogger::RecordKernelInstance(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance) {
+  CldriveLogRecord record = NewRecord(instance);
+  *record.mutable_kernel_instance() = *kernel_instance;
+  record.mutable_kernel_instance()->clear_run();
+  return WriteRecord(record);
+}
+
+/*virtual*/ labm8::Status StreamingProtocolBufferLogger::RecordInstance(
+    const CldriveInstance* const instance) {
+  CldriveLogRecord record = NewRecord(instance);
+  // The source and kernels are omitted, as they may be large, and the
+  // kernels have been recorded already.
+  CldriveInstance* instance_record = record.mutable_instance();
+  *instance_record = *instance;
+  instance_record->clear_opencl_src();
+  instance_record->clear_kernel();
+  return WriteRecord(record);
+}
+
+/*virtual*/ bool StreamingProtocolBufferLogger::RetainsRuns() const {
+  return false;
+}
+
+CldriveLogRecord StreamingProtocolBufferLogger::NewRecord(
+    const CldriveInstance* const instance) {
+  CHECK(instance_num() >= 0);
+  CldriveLogRecord record;
+  record.set_instance_num(instance_num());
+  record.set_device_name(instance->device().name());
+  if (instance->has_shard_index()) {
+    record.set_shard_index(instance->shard_index());
+  }
+  return record;
+}
+
+labm8::Status StreamingProtocolBufferLogger::WriteRecord(
+    const CldriveLogRecord& record) {
+  std::ostream& stream = ostream(/*flush=*/true);
+  if (!util::WriteDelimited(record, &stream) || !stream.flush()) {
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Failed to write log record");
+  }
+  return labm8::Status::OK;
+}
+
 CsvLogger::CsvLogger(std::ostream& ostream,
-                     const CldriveInstances* const instances)
+                     const CldriveInstances* const instances,
+                     bool print_header)
     : Logger(ostream, instances) {
-  this->ostream(/*flush=*/true) << CsvLogHeader();
+  if (print_header) {
+    this->ostream(/*flush=*/true) << CsvLogHeader();
+  }
 }
 
 /*virtual*/ labm8::Status CsvLogger::RecordLog(
@@ -89,5 +188,113 @@ CsvLogger::CsvLogger(std::ostream& ostream,
   return labm8::Status::OK;
 }
 
+SummaryLogger::SummaryLogger(std::ostream& ostream,
+                             const CldriveInstances* const instances,
+                             bool print_header)
+    : Logger(ostream, instances) {
+  if (print_header) {
+    this->ostream(/*flush=*/true) << CsvSummaryLogHeader();
+  }
+}
+
+/*virtual*/ labm8::Status SummaryLogger::RecordLog(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log, bool flush) {
+  // The runs of a kernel are summarized by RecordRun().
+  if (!run) {
+    ostream(/*flush=*/true) << CsvSummaryLog::FromProtos(
+        instance_num(), instance, kernel_instance, /*run=*/nullptr);
+  }
+  return labm8::Status::OK;
+}
+
+/*virtual*/ labm8::Status SummaryLogger::RecordRun(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  ostream(/*flush=*/true) << CsvSummaryLog::FromProtos(
+      instance_num(), instance, kernel_instance, run);
+  return labm8::Status::OK;
+}
+
+/*virtual*/ bool SummaryLogger::RetainsRuns() const { return false; }
+
+ResultsStoreLogger::ResultsStoreLogger(std::ostream& ostream,
+                                       const CldriveInstances* const instances,
+                                       std::unique_ptr<Logger> logger,
+                                       ResultsStore* store, bool mark_complete)
+    : Logger(ostream, instances),
+      logger_(std::move(logger)),
+      store_(store),
+      mark_complete_(mark_complete) {}
+
+/*virtual*/ labm8::Status ResultsStoreLogger::StartNewInstance() {
+  Logger::StartNewInstance();
+  return logger_->StartNewInstance(instance_num());
+}
+
+/*virtual*/ labm8::Status ResultsStoreLogger::RecordLog(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run,
+    const gpu::libcecl::OpenClKernelInvocation* const log, bool flush) {
+  return logger_->RecordLog(instance, kernel_instance, run, log, flush);
+}
+
+/*virtual*/ labm8::Status ResultsStoreLogger::StartKernelInstance(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance) {
+  return logger_->StartKernelInstance(instance, kernel_instance);
+}
+
+/*virtual*/ labm8::Status ResultsStoreLogger::RecordRun(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance,
+    const CldriveKernelRun* const run) {
+  auto status = store_->InsertRun(*instance, kernel_instance->name(), *run);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
+  return logger_->RecordRun(instance, kernel_instance, run);
+}
+
+/*virtual*/ labm8::Status ResultsStoreLogger::RecordKernelInstance(
+    const CldriveInstance* const instance,
+    const CldriveKernelInstance* const kernel_instance) {
+  return logger_->RecordKernelInstance(instance, kernel_instance);
+}
+
+/*virtual*/ labm8::Status ResultsStoreLogger::RecordInstance(
+    const CldriveInstance* const instance) {
+  // Record and flush the output first, so that an instance is not marked
+  // complete before its output has been written.
+  auto status = logger_->RecordInstance(instance);
+  if (!mark_complete_) {
+    return status;
+  }
+  if (!status.ok() || !ostream(/*flush=*/true).flush()) {
+    LOG(ERROR) << "Not marking instance complete, as its output could not be "
+               << "written";
+    return status;
+  }
+  auto store_status = store_->MarkComplete(*instance);
+  if (!store_status.ok()) {
+    LOG(ERROR) << store_status.error_message();
+  }
+  return status;
+}
+
+/*virtual*/ bool ResultsStoreLogger::RetainsRuns() const {
+  return logger_->RetainsRuns();
+}
+
+/*virtual*/ void ResultsStoreLogger::PrintAndClearBuffer() {
+  logger_->PrintAndClearBuffer();
+}
+
+/*virtual*/ void ResultsStoreLogger::ClearBuffer() { logger_->ClearBuffer(); }
+
 }  // namespace cldrive
 }  // namespace gpu
@@ -21,11 +21,14 @@
 #include "labm8/cpp/status.h"
 
 #include <iostream>
+#include <memory>
 #include <sstream>
 
 namespace gpu {
 namespace cldrive {
 
+class ResultsStore;
+
 // Abstract logging interface for producing consumable output.
 class Logger {
  public:
@@ -35,6 +38,11 @@ class Logger {
 
   virtual labm8::Status StartNewInstance();
 
+  // Start a new instance with the given number, rather than the number which
+  // follows the previous instance. This is used when instances are logged out
+  // of order.
+  labm8::Status StartNewInstance(int instance_num);
+
   // If flush is false, don't emit the log immediately, but instead store the
   // log in a buffer that is emmitted only on a call to PrintAndClearBuffer().
   virtual labm8::Status RecordLog(
@@ -43,8 +51,32 @@ class Logger {
       const CldriveKernelRun* const run,
       const gpu::libcecl::OpenClKernelInvocation* const log, bool flush = true);
 
-  void PrintAndClearBuffer();
-  void ClearBuffer();
+  // Called once a kernel instance has been created, before it is run.
+  virtual labm8::Status StartKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance);
+
+  // Called once a kernel run is complete, after the logs of its
+  // invocations.
+  virtual labm8::Status RecordRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run);
+
+  // Called once a kernel instance is complete, after its runs.
+  virtual labm8::Status RecordKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance);
+
+  // Called once an instance is complete, after its kernel instances.
+  virtual labm8::Status RecordInstance(const CldriveInstance* const instance);
+
+  // Return whether completed runs must be kept in their kernel instance. If
+  // false, the runs are discarded once recorded.
+  virtual bool RetainsRuns() const;
+
+  virtual void PrintAndClearBuffer();
+  virtual void ClearBuffer();
 
  protected:
   const CldriveInstances* instances();
@@ -71,9 +103,93 @@ class ProtocolBufferLogger : public Logger {
   bool text_format_ = text_format_;
 };
 
+// Logging interface for producing a stream of length-delimited
+// CldriveLogRecord protocol buffers. Each record is written and flushed as
+// soon as it is complete, so memory use does not grow with the number of
+// runs, and the records of a process which is killed are not lost.
+class StreamingProtocolBufferLogger : public Logger {
+ public:
+  StreamingProtocolBufferLogger(std::ostream& ostream,
+                                const CldriveInstances* const instances);
+
+  virtual labm8::Status RecordRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run) override;
+
+  virtual labm8::Status RecordKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance) override;
+
+  virtual labm8::Status RecordInstance(
+      const CldriveInstance* const instance) override;
+
+  virtual bool RetainsRuns() const override;
+
+ private:
+  CldriveLogRecord NewRecord(const CldriveInstance* const instance);
+
+  labm8::Status WriteRecord(const CldriveLogRecord& record);
+};
+
 class CsvLogger : public Logger {
  public:
-  CsvLogger(std::ostream& ostream, const CldriveInstances* const instances);
+  // If print_header is false, the caller is responsible for printing the
+  // CsvLogHeader().
+  CsvLogger(std::ostream& ostream, const CldriveInstances* const instances,
+            bool print_header = true);
+
+  virtual labm8::Status RecordLog(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override;
+};
+
+// A logger which prints one CSV row per kernel and dynamic params, with
+// summary statistics of the kernel and transfer times of its runs, rather
+// than one row per run.
+class SummaryLogger : public Logger {
+ public:
+  // If print_header is false, the caller is responsible for printing the
+  // CsvSummaryLogHeader().
+  SummaryLogger(std::ostream& ostream, const CldriveInstances* const instances,
+                bool print_header = true);
+
+  // Prints a row for failures which are not recorded as a run.
+  virtual labm8::Status RecordLog(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run,
+      const gpu::libcecl::OpenClKernelInvocation* const log,
+      bool flush) override;
+
+  virtual labm8::Status RecordRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run) override;
+
+  virtual bool RetainsRuns() const override;
+};
+
+// A logger which inserts each kernel run into a ResultsStore, and marks each
+// instance complete once it has been run, before forwarding every call to
+// another logger which produces the output.
+class ResultsStoreLogger : public Logger {
+ public:
+  // An instance is marked complete once the other logger has recorded it and
+  // the output stream has been flushed, so the other logger must write its
+  // output as it is recorded, rather than on destruction. If the output is
+  // written elsewhere later, pass mark_complete=false and call
+  // ResultsStore::MarkComplete() once it has been written.
+  ResultsStoreLogger(std::ostream& ostream,
+                     const CldriveInstances* const instances,
+                     std::unique_ptr<Logger> logger, ResultsStore* store,
+                     bool mark_complete = true);
+
+  using Logger::StartNewInstance;
+  virtual labm8::Status StartNewInstance() override;
 
   virtual labm8::Status RecordLog(
       const CldriveInstance* const instance,
@@ -81,6 +197,32 @@ class CsvLogger : public Logger {
       const CldriveKernelRun* const run,
       const gpu::libcecl::OpenClKernelInvocation* const log,
       bool flush) override;
+
+  virtual labm8::Status StartKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance) override;
+
+  virtual labm8::Status RecordRun(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance,
+      const CldriveKernelRun* const run) override;
+
+  virtual labm8::Status RecordKernelInstance(
+      const CldriveInstance* const instance,
+      const CldriveKernelInstance* const kernel_instance) override;
+
+  virtual labm8::Status RecordInstance(
+      const CldriveInstance* const instance) override;
+
+  virtual bool RetainsRuns() const override;
+
+  virtual void PrintAndClearBuffer() override;
+  virtual void ClearBuffer() override;
+
+ private:
+  std::unique_ptr<Logger> logger_;
+  ResultsStore* store_;
+  bool mark_complete_;
 };
 
 }  // namespace cldrive
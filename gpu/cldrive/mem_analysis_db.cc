@@ -0,0 +1,253 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/mem_analysis_db.h"
+
+#include "gpu/cldrive/hash_util.h"
+
+#include "labm8/cpp/logging.h"
+
+#include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+const char kMagic[8] = {'C', 'L', 'D', 'M', 'E', 'M', 'D', 'B'};
+const labm8::uint32 kVersion = 1;
+
+// The layout of a database file is a Header, then num_slots Slots, then
+// num_records Records.
+struct Header {
+  char magic[8];
+  labm8::uint32 version;
+  labm8::uint32 num_slots;
+  labm8::uint64 num_records;
+  labm8::uint64 num_sources;
+};
+
+// A hash table slot. A key of zero marks an empty slot, so GetMemAnalysisKey()
+// never returns zero. The records of a source are contiguous.
+struct Slot {
+  labm8::uint64 key;
+  labm8::uint32 first_record;
+  labm8::uint32 num_records;
+};
+
+struct Record {
+  labm8::int32 arg_index;
+  labm8::uint32 reserved;
+  double gsize_coef;
+  double lsize_coef;
+  double intercept;
+};
+
+static_assert(sizeof(Header) == 32, "Unexpected database header size");
+static_assert(sizeof(Slot) == 16, "Unexpected database slot size");
+static_assert(sizeof(Record) == 32, "Unexpected database record size");
+
+const Header* GetHeader(const void* data) {
+  return static_cast<const Header*>(data);
+}
+
+const Slot* GetSlots(const void* data) {
+  return reinterpret_cast<const Slot*>(static_cast<const char*>(data) +
+                                       sizeof(Header));
+}
+
+const Record* GetRecords(const void* data) {
+  return reinterpret_cast<const Record*>(GetSlots(data) +
+                                         GetHeader(data)->num_slots);
+}
+
+labm8::Status CorruptDatabase(const string& path) {
+  return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                       "Corrupt memory analysis database: " + path);
+}
+
+}  // anonymous namespace
+
+labm8::uint64 GetMemAnalysisKey(const string& opencl_src) {
+  util::Fnv1aHash hash;
+  hash.AddField(opencl_src);
+  return hash.hash() ? hash.hash() : 1;
+}
+
+/*static*/ labm8::Status MemAnalysisDatabase::Open(
+    const string& path, std::unique_ptr<MemAnalysisDatabase>* database) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "Memory analysis database not found: " + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    close(fd);
+    return CorruptDatabase(path);
+  }
+  const size_t size = st.st_size;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Failed to map memory analysis database: " + path);
+  }
+  database->reset(new MemAnalysisDatabase(data, size));
+
+  const Header* header = GetHeader(data);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) ||
+      header->version != kVersion || !header->num_slots ||
+      (header->num_slots & (header->num_slots - 1)) ||
+      size != sizeof(Header) + header->num_slots * sizeof(Slot) +
+                  header->num_records * sizeof(Record)) {
+    database->reset();
+    return CorruptDatabase(path);
+  }
+
+  return labm8::Status::OK;
+}
+
+MemAnalysisDatabase::MemAnalysisDatabase(void* data, size_t size)
+    : data_(data), size_(size) {}
+
+MemAnalysisDatabase::~MemAnalysisDatabase() { munmap(data_, size_); }
+
+bool MemAnalysisDatabase::Lookup(const string& opencl_src,
+                                 CldriveInstance* instance) const {
+  instance->clear_arg_bound();
+
+  const labm8::uint64 key = GetMemAnalysisKey(opencl_src);
+  const Header* header = GetHeader(data_);
+  const Slot* slots = GetSlots(data_);
+  const labm8::uint32 mask = header->num_slots - 1;
+
+  // Linear probing. The table is never full, so the probe ends at an empty
+  // slot if the key is absent.
+  for (labm8::uint32 i = key & mask;; i = (i + 1) & mask) {
+    const Slot& slot = slots[i];
+    if (!slot.key) {
+      return false;
+    }
+    if (slot.key != key) {
+      continue;
+    }
+    if (static_cast<labm8::uint64>(slot.first_record) + slot.num_records >
+        header->num_records) {
+      LOG(WARNING) << "Corrupt memory analysis database slot " << i;
+      return false;
+    }
+    const Record* records = GetRecords(data_) + slot.first_record;
+    for (labm8::uint32 j = 0; j < slot.num_records; ++j) {
+      ArgBound* bound = instance->add_arg_bound();
+      bound->set_arg_index(records[j].arg_index);
+      bound->set_gsize_coef(records[j].gsize_coef);
+      bound->set_lsize_coef(records[j].lsize_coef);
+      bound->set_intercept(records[j].intercept);
+    }
+    return true;
+  }
+}
+
+size_t MemAnalysisDatabase::size() const {
+  return GetHeader(data_)->num_sources;
+}
+
+void MemAnalysisDatabaseBuilder::Add(
+    const string& opencl_src,
+    const google::protobuf::RepeatedPtrField<ArgBound>& bounds) {
+  entries_[GetMemAnalysisKey(opencl_src)] =
+      std::vector<ArgBound>(bounds.begin(), bounds.end());
+}
+
+size_t MemAnalysisDatabaseBuilder::size() const { return entries_.size(); }
+
+labm8::Status MemAnalysisDatabaseBuilder::Write(const string& path) const {
+  // Size the table to at most half full, so that probe sequences are short.
+  labm8::uint32 num_slots = 2;
+  while (num_slots < 2 * entries_.size()) {
+    num_slots *= 2;
+  }
+
+  std::vector<Slot> slots(num_slots);
+  std::vector<Record> records;
+  for (const auto& entry : entries_) {
+    labm8::uint32 i = entry.first & (num_slots - 1);
+    while (slots[i].key) {
+      i = (i + 1) & (num_slots - 1);
+    }
+    slots[i].key = entry.first;
+    slots[i].first_record = records.size();
+    slots[i].num_records = entry.second.size();
+    for (const auto& bound : entry.second) {
+      Record record;
+      record.arg_index = bound.arg_index();
+      record.reserved = 0;
+      record.gsize_coef = bound.gsize_coef();
+      record.lsize_coef = bound.lsize_coef();
+      record.intercept = bound.intercept();
+      records.push_back(record);
+    }
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.num_slots = num_slots;
+  header.num_records = records.size();
+  header.num_sources = entries_.size();
+
+  const fs::path fs_path(path);
+  const fs::path temp_path =
+      fs_path.parent_path() /
+      fs::unique_path(fs_path.filename().string() + ".tmp-%%%%-%%%%-%%%%");
+  {
+    fs::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(slots.data()),
+               slots.size() * sizeof(Slot));
+    file.write(reinterpret_cast<const char*>(records.data()),
+               records.size() * sizeof(Record));
+    if (!file) {
+      boost::system::error_code error;
+      fs::remove(temp_path, error);
+      return labm8::Status(labm8::error::Code::INTERNAL,
+                           "Failed to write memory analysis database: " +
+                               temp_path.string());
+    }
+  }
+
+  boost::system::error_code error;
+  fs::rename(temp_path, fs_path, error);
+  if (error) {
+    fs::remove(temp_path, error);
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Failed to write memory analysis database: " + path);
+  }
+  return labm8::Status::OK;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,86 @@
+// A memory mapped database of memory analysis bounds.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/status.h"
+#include "labm8/cpp/string.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// Return the database key of an OpenCL source: a 64-bit hash of its content.
+labm8::uint64 GetMemAnalysisKey(const string& opencl_src);
+
+// A read-only database of the memory analysis bounds of OpenCL sources,
+// keyed by the hash of the source content.
+//
+// The file is an open addressing hash table of fixed-size slots followed by
+// fixed-size bound records. It is memory mapped, so a lookup probes the
+// table in place rather than reading or parsing a file per source. Files are
+// written by MemAnalysisDatabaseBuilder, in the native byte order.
+class MemAnalysisDatabase {
+ public:
+  // Map a database file into memory.
+  static labm8::Status Open(const string& path,
+                            std::unique_ptr<MemAnalysisDatabase>* database);
+
+  ~MemAnalysisDatabase();
+
+  // Set the arg_bound field of the instance to the bounds of the given
+  // source, replacing any previous bounds. Returns false if the source is not
+  // in the database, leaving the instance without bounds.
+  bool Lookup(const string& opencl_src, CldriveInstance* instance) const;
+
+  // Return the number of sources in the database.
+  size_t size() const;
+
+ private:
+  MemAnalysisDatabase(void* data, size_t size);
+
+  void* data_;
+  size_t size_;
+};
+
+// Builds a MemAnalysisDatabase file.
+class MemAnalysisDatabaseBuilder {
+ public:
+  // Add the bounds of a source, replacing any bounds previously added for the
+  // same source.
+  void Add(const string& opencl_src,
+           const google::protobuf::RepeatedPtrField<ArgBound>& bounds);
+
+  // Return the number of sources added.
+  size_t size() const;
+
+  // Write the database. The file is written to a temporary path and renamed
+  // into place, so readers never see a partial database.
+  labm8::Status Write(const string& path) const;
+
+ private:
+  std::map<labm8::uint64, std::vector<ArgBound>> entries_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
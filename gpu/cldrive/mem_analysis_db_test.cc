@@ -0,0 +1,123 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/mem_analysis_db.h"
+
+#include "labm8/cpp/test.h"
+
+#include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+class MemAnalysisDatabaseTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    path_ = fs::temp_directory_path() /
+            fs::unique_path("mem_analysis_db_test_%%%%-%%%%-%%%%");
+  }
+
+  virtual void TearDown() override { fs::remove(path_); }
+
+  fs::path path_;
+};
+
+google::protobuf::RepeatedPtrField<ArgBound> MakeBounds(int arg_index,
+                                                        double gsize_coef) {
+  google::protobuf::RepeatedPtrField<ArgBound> bounds;
+  ArgBound* bound = bounds.Add();
+  bound->set_arg_index(arg_index);
+  bound->set_gsize_coef(gsize_coef);
+  bound->set_lsize_coef(0);
+  bound->set_intercept(-1);
+  return bounds;
+}
+
+TEST_F(MemAnalysisDatabaseTest, LookupAddedSource) {
+  MemAnalysisDatabaseBuilder builder;
+  builder.Add("kernel void A(global int* a) {}", MakeBounds(0, 2));
+  ASSERT_TRUE(builder.Write(path_.string()).ok());
+
+  std::unique_ptr<MemAnalysisDatabase> database;
+  ASSERT_TRUE(MemAnalysisDatabase::Open(path_.string(), &database).ok());
+  EXPECT_EQ(database->size(), 1);
+
+  CldriveInstance instance;
+  ASSERT_TRUE(database->Lookup("kernel void A(global int* a) {}",
+                                            &instance));
+  ASSERT_EQ(instance.arg_bound_size(), 1);
+  EXPECT_EQ(instance.arg_bound(0).arg_index(), 0);
+  EXPECT_EQ(instance.arg_bound(0).gsize_coef(), 2);
+  EXPECT_EQ(instance.arg_bound(0).intercept(), -1);
+}
+
+TEST_F(MemAnalysisDatabaseTest, LookupMissingSourceClearsBounds) {
+  MemAnalysisDatabaseBuilder builder;
+  builder.Add("kernel void A(global int* a) {}", MakeBounds(0, 2));
+  ASSERT_TRUE(builder.Write(path_.string()).ok());
+
+  std::unique_ptr<MemAnalysisDatabase> database;
+  ASSERT_TRUE(MemAnalysisDatabase::Open(path_.string(), &database).ok());
+  CldriveInstance instance;
+  *instance.add_arg_bound() = MakeBounds(0, 2).Get(0);
+  EXPECT_FALSE(database->Lookup("kernel void B(global int* a) {}",
+                                             &instance));
+  EXPECT_EQ(instance.arg_bound_size(), 0);
+}
+
+TEST_F(MemAnalysisDatabaseTest, ManySources) {
+  MemAnalysisDatabaseBuilder builder;
+  for (int i = 0; i < 1000; ++i) {
+    builder.Add("kernel void A" + std::to_string(i) + "() {}",
+                MakeBounds(i % 4, i));
+  }
+  ASSERT_TRUE(builder.Write(path_.string()).ok());
+
+  std::unique_ptr<MemAnalysisDatabase> database;
+  ASSERT_TRUE(MemAnalysisDatabase::Open(path_.string(), &database).ok());
+  EXPECT_EQ(database->size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    CldriveInstance instance;
+    ASSERT_TRUE(database->Lookup(
+        "kernel void A" + std::to_string(i) + "() {}", &instance));
+    ASSERT_EQ(instance.arg_bound_size(), 1);
+    EXPECT_EQ(instance.arg_bound(0).arg_index(), i % 4);
+    EXPECT_EQ(instance.arg_bound(0).gsize_coef(), i);
+  }
+}
+
+TEST_F(MemAnalysisDatabaseTest, OpenMissingFile) {
+  std::unique_ptr<MemAnalysisDatabase> database;
+  EXPECT_FALSE(MemAnalysisDatabase::Open(path_.string(), &database).ok());
+}
+
+TEST_F(MemAnalysisDatabaseTest, OpenCorruptFile) {
+  {
+    fs::ofstream file(path_);
+    file << "not a database, but long enough to hold a header";
+  }
+  std::unique_ptr<MemAnalysisDatabase> database;
+  EXPECT_FALSE(MemAnalysisDatabase::Open(path_.string(), &database).ok());
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -15,19 +15,12 @@ namespace mem_analysis {
   }
 
 
-  bool isMemAnalysisFileExists(std::string filePathToCheck_, std::string memAnalysisDir_) {
-    // get the file path to check
-    boost::filesystem::path memFileToCheck = getMemAnalysisFilePath(filePathToCheck_, memAnalysisDir_);
-
-    return boost::filesystem::exists(memFileToCheck);
-  }
-
-  std::map<int,int> getMemAnalysisInfo(boost::filesystem::path memFilePath, int gsize, int lsize) {
-    std::map<int, int> memAnalysisInfo;
+  bool setMemAnalysisInfo(boost::filesystem::path memFilePath, CldriveInstance* instance) {
+    instance->clear_arg_bound();
 
     // If the file not exists, then use default memory analysis setting (empty)
     if (boost::filesystem::exists(memFilePath) == false) {
-      return memAnalysisInfo;
+      return false;
     }
 
     std::ifstream jsonFile(memFilePath.string());
@@ -45,29 +38,28 @@ namespace mem_analysis {
 
     CHECK(reader.parse(jsonData, root)) << "Failed to parse JSON data: " << reader.getFormattedErrorMessages() << "\n";
 
-    // Iterate through children of root and get the memory analysis information
+    // Iterate through children of root and copy the coefficients of each argument
     for (const auto& child : root.getMemberNames()) {
         const Json::Value& currentChild = root[child];
-        int argId = currentChild["arg_id"].asInt();
-        int arraySize = std::round(currentChild["coef"][0].asDouble() * gsize 
-                              + currentChild["coef"][1].asDouble() * lsize 
-                              + currentChild["coef"][2].asDouble()) + 1;
-        memAnalysisInfo[argId] = arraySize;
+        ArgBound* bound = instance->add_arg_bound();
+        bound->set_arg_index(currentChild["arg_id"].asInt());
+        bound->set_gsize_coef(currentChild["coef"][0].asDouble());
+        bound->set_lsize_coef(currentChild["coef"][1].asDouble());
+        bound->set_intercept(currentChild["coef"][2].asDouble());
     }
-
-    return memAnalysisInfo;
+    return true;
   }
 
-  std::map<int,int> getMemAnalysisInfo(std::string memFilePathStr, int gsize, int lsize) {
+  bool setMemAnalysisInfo(std::string sourceFile_, std::string memAnalysisDir_, CldriveInstance* instance) {
     // get the file path to check
-    boost::filesystem::path memFilePath(memFilePathStr);
-    return getMemAnalysisInfo(memFilePath, gsize, lsize);
+    boost::filesystem::path memFilePath = getMemAnalysisFilePath(sourceFile_, memAnalysisDir_);
+    return setMemAnalysisInfo(memFilePath, instance);
   }
 
-  std::map<int, int> getMemAnalysisInfo(std::string sourceFile_, std::string memAnalysisDir_, int gsize, int lsize) {
-    // get the file path to check
-    boost::filesystem::path memFilePath = getMemAnalysisFilePath(sourceFile_, memAnalysisDir_);
-    return getMemAnalysisInfo(memFilePath, gsize, lsize);
+  long long getArgArrayBound(const ArgBound& bound, int gsize, int lsize) {
+    return std::llround(bound.gsize_coef() * gsize
+                        + bound.lsize_coef() * lsize
+                        + bound.intercept()) + 1;
   }
 }
 }
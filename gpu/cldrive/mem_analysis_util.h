@@ -1,5 +1,6 @@
 #include "boost/filesystem.hpp"
 #include "boost/filesystem/fstream.hpp"
+#include "gpu/cldrive/proto/cldrive.pb.h"
 #include "labm8/cpp/logging.h"
 
 #include <json/json.h>
@@ -13,13 +14,14 @@ namespace mem_analysis {
   // generate the memory analysis file path from the source file path and the memory analysis directory
   boost::filesystem::path getMemAnalysisFilePath(std::string sourcePath_, std::string memAnalysisDir_);
 
-  // check if the memory analysis file exists
-  bool isMemAnalysisFileExists(std::string filePathToCheck_, std::string memAnalysisDir_);
+  // parse the memory analysis file once into the arg_bound field of the instance, replacing any
+  // previous bounds. If the file does not exist, the instance has no bounds (default setting) and
+  // false is returned
+  bool setMemAnalysisInfo(boost::filesystem::path memFilePath, CldriveInstance* instance);
+  bool setMemAnalysisInfo(std::string sourceFile_, std::string memAnalysisDir_, CldriveInstance* instance);
 
-  // get the memory analysis information from the memory analysis file
-  std::map<int,int> getMemAnalysisInfo(boost::filesystem::path memFilePath, int gsize, int lsize);
-  std::map<int,int> getMemAnalysisInfo(std::string memFilePathStr, int gsize, int lsize);
-  std::map<int, int> getMemAnalysisInfo(std::string sourceFile_, std::string memAnalysisDir_, int gsize, int lsize);
+  // get the number of elements of an argument for the given launch configuration
+  long long getArgArrayBound(const ArgBound& bound, int gsize, int lsize);
 }
 }
 }
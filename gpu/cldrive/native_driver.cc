@@ -13,23 +13,115 @@
 //
 // You should have received a copy of the GNU General Public License
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/delimited_util.h"
 #include "gpu/cldrive/libcldrive.h"
+#include "gpu/cldrive/opencl_context_pool.h"
+#include "gpu/cldrive/shard_util.h"
 
+#include "labm8/cpp/logging.h"
 #include "labm8/cpp/pbutil.h"
 
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+#include <unistd.h>
+
+
 namespace gpu {
 namespace cldrive {
 
-void ProcessCldriveInstancesOrDie(CldriveInstances* instances) {
+void ProcessCldriveInstancesOrDie(CldriveInstances* instances, int shard_index,
+                                  int num_shards) {
   ProtocolBufferLogger logger(std::cout, instances, /*text_format=*/false);
   for (int i = 0; i < instances->instance_size(); ++i) {
     logger.StartNewInstance();
-    Cldrive(instances->mutable_instance(i), i).RunOrDie(logger);
+    if (util::ShardDynamicParams(shard_index, num_shards,
+                                 instances->mutable_instance(i))) {
+      Cldrive(instances->mutable_instance(i), i).RunOrDie(logger);
+    }
   }
+  OpenClContextPool::Get().Clear();
+}
+
+// Read a stream of length-delimited CldriveInstance messages from a file
+// descriptor, running each instance as soon as it has been read and writing a
+// stream of length-delimited CldriveLogRecord messages to stdout as they are
+// produced. Only one instance is held in memory at a time.
+void StreamCldriveInstancesOrDie(int fd, int shard_index, int num_shards) {
+  CldriveInstances instances;
+  CldriveInstance* instance = instances.add_instance();
+  StreamingProtocolBufferLogger logger(std::cout, &instances);
+  util::DelimitedReader reader(fd);
+
+  int instance_num = 0;
+  for (; reader.Next(instance); ++instance_num) {
+    logger.StartNewInstance();
+    if (!util::ShardDynamicParams(shard_index, num_shards, instance)) {
+      continue;
+    }
+    Cldrive(instance, instance_num).RunOrDie(logger);
+  }
+  CHECK(!reader.error()) << "Failed to read instance " << instance_num
+                         << " from the input stream";
+  OpenClContextPool::Get().Clear();
 }
 
 }  // namespace cldrive
 }  // namespace gpu
 
-PBUTIL_INPLACE_PROCESS_MAIN(gpu::cldrive::ProcessCldriveInstancesOrDie,
-                            gpu::cldrive::CldriveInstances);
+namespace {
+
+// Parse the command line arguments, returning whether --stream is set.
+bool ParseArgsOrDie(int argc, char** argv, int* shard_index, int* num_shards) {
+  bool stream = false;
+  for (int i = 1; i < argc; ++i) {
+    absl::string_view arg(argv[i]);
+    if (arg == "--stream") {
+      stream = true;
+    } else if (absl::ConsumePrefix(&arg, "--shard_index=")) {
+      CHECK(absl::SimpleAtoi(arg, shard_index))
+          << "Illegal value for --shard_index: '" << string(arg) << "'";
+    } else if (absl::ConsumePrefix(&arg, "--num_shards=")) {
+      CHECK(absl::SimpleAtoi(arg, num_shards))
+          << "Illegal value for --num_shards: '" << string(arg) << "'";
+    } else {
+      LOG(FATAL) << "Usage: " << argv[0]
+                 << " [--stream] [--shard_index=<n> --num_shards=<n>]";
+    }
+  }
+  const auto status =
+      gpu::cldrive::util::ValidateShard(*shard_index, *num_shards);
+  CHECK(status.ok()) << status.error_message();
+  return stream;
+}
+
+}  // anonymous namespace
+
+// Usage: native_driver [--stream] [--shard_index=<n> --num_shards=<n>]
+//         < instances.pb
+//
+// By default, reads a CldriveInstances message from stdin and writes the
+// instances to stdout with their results once every instance has run. With
+// --stream, reads a stream of length-delimited CldriveInstance messages from
+// stdin and writes a stream of length-delimited CldriveLogRecord messages to
+// stdout. With --num_shards, only the part of each instance in the shard
+// --shard_index is run.
+int main(int argc, char** argv) {
+  int shard_index = 0;
+  int num_shards = 1;
+  const bool stream = ParseArgsOrDie(argc, argv, &shard_index, &num_shards);
+
+  if (stream) {
+    gpu::cldrive::StreamCldriveInstancesOrDie(STDIN_FILENO, shard_index,
+                                              num_shards);
+    return 0;
+  }
+
+  labm8::pbutil::ProcessMessageInPlace<gpu::cldrive::CldriveInstances>(
+      [&](gpu::cldrive::CldriveInstances* instances) {
+        gpu::cldrive::ProcessCldriveInstancesOrDie(instances, shard_index,
+                                                   num_shards);
+      });
+  return 0;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/opencl_context_pool.h"
+
+namespace gpu {
+namespace cldrive {
+
+/*static*/ OpenClContextPool& OpenClContextPool::Get() {
+  // The pool is intentionally leaked so that its destructor does not run
+  // after the OpenCL implementation has been unloaded. Use Clear() to release
+  // the OpenCL objects.
+  static OpenClContextPool* pool = new OpenClContextPool();
+  return *pool;
+}
+
+const OpenClDeviceContext& OpenClContextPool::GetOrCreate(
+    const cl::Device& device) {
+  labm8::MutexLock lock(&mutex_);
+
+  auto it = contexts_.find(device());
+  if (it == contexts_.end()) {
+    OpenClDeviceContext device_context;
+    device_context.context = cl::Context(device);
+    device_context.queue =
+        cl::CommandQueue(device_context.context, /*devices=*/device,
+                         /*properties=*/CL_QUEUE_PROFILING_ENABLE);
+    it = contexts_.emplace(device(), device_context).first;
+  }
+  return it->second;
+}
+
+void OpenClContextPool::Clear() {
+  labm8::MutexLock lock(&mutex_);
+  contexts_.clear();
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,60 @@
+// A process-wide pool of OpenCL contexts and command queues.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "third_party/opencl/cl.hpp"
+
+#include "labm8/cpp/mutex.h"
+
+#include <map>
+
+namespace gpu {
+namespace cldrive {
+
+// A context and profiling-enabled command queue for a single device.
+struct OpenClDeviceContext {
+  cl::Context context;
+  cl::CommandQueue queue;
+};
+
+// A registry of one context and command queue per device, which lives for
+// the duration of the process. Creating a context is expensive on some
+// OpenCL implementations, so contexts are created on first use of a device
+// and re-used for every subsequent program run on it.
+class OpenClContextPool {
+ public:
+  // Return the process-wide pool.
+  static OpenClContextPool& Get();
+
+  // Return the context and queue for a device, creating them on first use.
+  // The returned reference is valid until Clear() is called.
+  const OpenClDeviceContext& GetOrCreate(const cl::Device& device);
+
+  // Release all of the contexts and queues. This must be called before the
+  // OpenCL implementation is unloaded at process exit.
+  void Clear();
+
+ private:
+  OpenClContextPool() = default;
+
+  labm8::Mutex mutex_;
+  std::map<cl_device_id, OpenClDeviceContext> contexts_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
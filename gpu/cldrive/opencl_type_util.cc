@@ -15,28 +15,69 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/cldrive/opencl_type_util.h"
 
+#include "gpu/cldrive/device_global_memory_arg_value.h"
+#include "gpu/cldrive/device_random_fill.h"
 #include "gpu/cldrive/global_memory_arg_value.h"
 #include "gpu/cldrive/local_memory_arg_value.h"
+#include "gpu/cldrive/random_util.h"
 #include "gpu/cldrive/scalar_kernel_arg_value.h"
 
+#include <algorithm>
+
 namespace gpu {
 namespace cldrive {
 namespace util {
 
 namespace {
 
+// The number of random words generated at a time by FillRandom().
+constexpr size_t kRandomBatchSize = 1024;
+
+// Fill data with non-negative random integers, as rand() would produce, from
+// the Philox stream identified by seed and stream. Element i always takes the
+// i-th word of the stream, regardless of how the work is split across
+// threads.
+template <typename T>
+void FillRandom(labm8::uint64 seed, labm8::uint32 stream, T* data,
+                size_t size) {
+  ParallelForChunks(size, kRandomBatchSize, [&](size_t begin, size_t end) {
+    labm8::uint32 words[kRandomBatchSize];
+    for (size_t i = begin; i < end; i += kRandomBatchSize) {
+      const size_t n = std::min(kRandomBatchSize, end - i);
+      GeneratePhilox4x32(seed, stream, /*first_block=*/i / 4,
+                         /*num_blocks=*/(n + 3) / 4, words);
+      for (size_t j = 0; j < n; ++j) {
+        data[i + j] =
+            opencl_type::MakeScalar<T>(static_cast<int>(words[j] >> 1));
+      }
+    }
+  });
+}
+
 template <typename T>
-std::unique_ptr<GlobalMemoryArgValueWithBuffer<T>> CreateGlobalMemoryArgValue(
-    const cl::Context& context, size_t size, const int& value,
-    bool rand_values) {
+std::unique_ptr<KernelArgValue> CreateGlobalMemoryArgValue(
+    const OpenClType& type, const cl::Context& context, size_t size,
+    const int& value, bool rand_values, labm8::uint64 seed,
+    labm8::uint32 stream, bool device_init) {
+  if (device_init && !rand_values) {
+    return std::make_unique<DeviceGlobalMemoryArgValue<T>>(
+        context, size, /*value=*/opencl_type::MakeScalar<T>(value));
+  } else if (device_init) {
+    // Fall back to generating the values on the host if the device cannot
+    // build the random fill kernel for this type.
+    auto kernel_or = CreateRandomFillKernel(context, type);
+    if (kernel_or.ok()) {
+      return std::make_unique<DeviceGlobalMemoryArgValue<T>>(
+          context, size, kernel_or.ValueOrDie(), seed, stream);
+    }
+  }
+
   auto arg_value = std::make_unique<GlobalMemoryArgValueWithBuffer<T>>(
       context, size, /*value=*/opencl_type::MakeScalar<T>(value));
   if (rand_values) {
-    for (size_t i = 0; i < size; ++i) {
-      arg_value->vector()[i] = opencl_type::MakeScalar<T>(rand());
-    }
+    FillRandom(seed, stream, arg_value->vector().data(), size);
   }
-  return arg_value;
+  return std::move(arg_value);
 }
 
 template <typename T>
@@ -49,278 +90,279 @@ std::unique_ptr<KernelArgValue> CreateScalarArgValue(const int& value) {
 
 std::unique_ptr<KernelArgValue> CreateGlobalMemoryArgValue(
     const OpenClType& type, const cl::Context& context, size_t size,
-    const int& value, bool rand_values) {
+    const int& value, bool rand_values, labm8::uint64 seed,
+    labm8::uint32 stream, bool device_init) {
   DCHECK(size) << "Cannot create array with 0 elements";
   switch (type) {
     case OpenClType::BOOL: {
       // Use cl_bool here because std::vector<bool> has a funny bitmask
       // specialization in some STL implementations.
-      return CreateGlobalMemoryArgValue<cl_bool>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_bool>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::CHAR: {
-      return CreateGlobalMemoryArgValue<cl_char>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_char>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UCHAR: {
-      return CreateGlobalMemoryArgValue<cl_uchar>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::SHORT: {
-      return CreateGlobalMemoryArgValue<cl_short>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_short>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::USHORT: {
-      return CreateGlobalMemoryArgValue<cl_ushort>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::INT: {
-      return CreateGlobalMemoryArgValue<cl_int>(context, size, value,
-                                                rand_values);
+      return CreateGlobalMemoryArgValue<cl_int>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UINT: {
-      return CreateGlobalMemoryArgValue<cl_uint>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::LONG: {
-      return CreateGlobalMemoryArgValue<cl_long>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_long>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::ULONG: {
-      return CreateGlobalMemoryArgValue<cl_ulong>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::FLOAT: {
-      return CreateGlobalMemoryArgValue<cl_float>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_float>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::DOUBLE: {
-      return CreateGlobalMemoryArgValue<cl_double>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_double>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::HALF: {
-      return CreateGlobalMemoryArgValue<cl_half>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_half>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::CHAR2: {
-      return CreateGlobalMemoryArgValue<cl_char2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::CHAR3: {
-      return CreateGlobalMemoryArgValue<cl_char3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::CHAR4: {
-      return CreateGlobalMemoryArgValue<cl_char4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::CHAR8: {
-      return CreateGlobalMemoryArgValue<cl_char8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_char8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::CHAR16: {
-      return CreateGlobalMemoryArgValue<cl_char16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_char16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UCHAR2: {
-      return CreateGlobalMemoryArgValue<cl_uchar2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UCHAR3: {
-      return CreateGlobalMemoryArgValue<cl_uchar3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UCHAR4: {
-      return CreateGlobalMemoryArgValue<cl_uchar4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UCHAR8: {
-      return CreateGlobalMemoryArgValue<cl_uchar8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UCHAR16: {
-      return CreateGlobalMemoryArgValue<cl_uchar16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_uchar16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::SHORT2: {
-      return CreateGlobalMemoryArgValue<cl_short2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::SHORT3: {
-      return CreateGlobalMemoryArgValue<cl_short3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::SHORT4: {
-      return CreateGlobalMemoryArgValue<cl_short4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::SHORT8: {
-      return CreateGlobalMemoryArgValue<cl_short8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_short8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::SHORT16: {
-      return CreateGlobalMemoryArgValue<cl_short16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_short16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::USHORT2: {
-      return CreateGlobalMemoryArgValue<cl_ushort2>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::USHORT3: {
-      return CreateGlobalMemoryArgValue<cl_ushort3>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::USHORT4: {
-      return CreateGlobalMemoryArgValue<cl_ushort4>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::USHORT8: {
-      return CreateGlobalMemoryArgValue<cl_ushort8>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::USHORT16: {
-      return CreateGlobalMemoryArgValue<cl_ushort16>(context, size, value,
-                                                     rand_values);
+      return CreateGlobalMemoryArgValue<cl_ushort16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::INT2: {
-      return CreateGlobalMemoryArgValue<cl_int2>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::INT3: {
-      return CreateGlobalMemoryArgValue<cl_int3>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::INT4: {
-      return CreateGlobalMemoryArgValue<cl_int4>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::INT8: {
-      return CreateGlobalMemoryArgValue<cl_int8>(context, size, value,
-                                                 rand_values);
+      return CreateGlobalMemoryArgValue<cl_int8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::INT16: {
-      return CreateGlobalMemoryArgValue<cl_int16>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_int16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UINT2: {
-      return CreateGlobalMemoryArgValue<cl_uint2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UINT3: {
-      return CreateGlobalMemoryArgValue<cl_uint3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UINT4: {
-      return CreateGlobalMemoryArgValue<cl_uint4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UINT8: {
-      return CreateGlobalMemoryArgValue<cl_uint8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::UINT16: {
-      return CreateGlobalMemoryArgValue<cl_uint16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_uint16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::LONG2: {
-      return CreateGlobalMemoryArgValue<cl_long2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::LONG3: {
-      return CreateGlobalMemoryArgValue<cl_long3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::LONG4: {
-      return CreateGlobalMemoryArgValue<cl_long4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::LONG8: {
-      return CreateGlobalMemoryArgValue<cl_long8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_long8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::LONG16: {
-      return CreateGlobalMemoryArgValue<cl_long16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_long16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::ULONG2: {
-      return CreateGlobalMemoryArgValue<cl_ulong2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::ULONG3: {
-      return CreateGlobalMemoryArgValue<cl_ulong3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::ULONG4: {
-      return CreateGlobalMemoryArgValue<cl_ulong4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::ULONG8: {
-      return CreateGlobalMemoryArgValue<cl_ulong8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::ULONG16: {
-      return CreateGlobalMemoryArgValue<cl_ulong16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_ulong16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::FLOAT2: {
-      return CreateGlobalMemoryArgValue<cl_float2>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::FLOAT3: {
-      return CreateGlobalMemoryArgValue<cl_float3>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::FLOAT4: {
-      return CreateGlobalMemoryArgValue<cl_float4>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::FLOAT8: {
-      return CreateGlobalMemoryArgValue<cl_float8>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_float8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::FLOAT16: {
-      return CreateGlobalMemoryArgValue<cl_float16>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_float16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::DOUBLE2: {
-      return CreateGlobalMemoryArgValue<cl_double2>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::DOUBLE3: {
-      return CreateGlobalMemoryArgValue<cl_double3>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::DOUBLE4: {
-      return CreateGlobalMemoryArgValue<cl_double4>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::DOUBLE8: {
-      return CreateGlobalMemoryArgValue<cl_double8>(context, size, value,
-                                                    rand_values);
+      return CreateGlobalMemoryArgValue<cl_double8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::DOUBLE16: {
-      return CreateGlobalMemoryArgValue<cl_double16>(context, size, value,
-                                                     rand_values);
+      return CreateGlobalMemoryArgValue<cl_double16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::HALF2: {
-      return CreateGlobalMemoryArgValue<cl_half2>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half2>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::HALF3: {
-      return CreateGlobalMemoryArgValue<cl_half3>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half3>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::HALF4: {
-      return CreateGlobalMemoryArgValue<cl_half4>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half4>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::HALF8: {
-      return CreateGlobalMemoryArgValue<cl_half8>(context, size, value,
-                                                  rand_values);
+      return CreateGlobalMemoryArgValue<cl_half8>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::HALF16: {
-      return CreateGlobalMemoryArgValue<cl_half16>(context, size, value,
-                                                   rand_values);
+      return CreateGlobalMemoryArgValue<cl_half16>(
+          type, context, size, value, rand_values, seed, stream, device_init);
     }
     case OpenClType::DEFAULT_UNKNOWN: {
       // This condition should never occur as KernelArg::Init() will return an
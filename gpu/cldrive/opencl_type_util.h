@@ -21,6 +21,7 @@
 
 #include "gpu/cldrive/kernel_arg_value.h"
 #include "gpu/cldrive/opencl_type.h"
+#include "labm8/cpp/port.h"
 
 #include "third_party/opencl/cl.hpp"
 
@@ -30,9 +31,14 @@ namespace gpu {
 namespace cldrive {
 namespace util {
 
+// Create a global memory value of size elements. If rand_values is true, the
+// elements are drawn from the random stream identified by seed and stream,
+// else every element is value. If device_init is true, the elements are
+// initialized on the device rather than uploaded from the host.
 std::unique_ptr<KernelArgValue> CreateGlobalMemoryArgValue(
     const OpenClType& type, const cl::Context& context, size_t size,
-    const int& value, bool rand_values);
+    const int& value, bool rand_values, labm8::uint64 seed = 0,
+    labm8::uint32 stream = 0, bool device_init = false);
 
 std::unique_ptr<KernelArgValue> CreateLocalMemoryArgValue(
     const OpenClType& type, size_t size);
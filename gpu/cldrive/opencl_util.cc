@@ -45,6 +45,61 @@ void CopyDeviceToHost(const cl::CommandQueue& queue, const cl::Buffer& buffer,
   profiling->transferred_bytes += buffer_size;
 }
 
+void EnqueueCopyHostToDevice(const cl::CommandQueue& queue, void* host_pointer,
+                             const cl::Buffer& buffer, size_t buffer_size,
+                             ProfilingData* profiling) {
+  cl::Event event;
+  queue.enqueueWriteBuffer(
+      buffer, /*blocking=*/false, /*offset=*/0, /*size=*/buffer_size,
+      /*ptr=*/host_pointer, /*events=*/nullptr, /*event=*/&event);
+
+  // Set profiling data. The elapsed time is collected once the event has
+  // completed.
+  profiling->transfer_events.push_back(event);
+  profiling->transferred_bytes += buffer_size;
+}
+
+void EnqueueCopyDeviceToHost(const cl::CommandQueue& queue,
+                             const cl::Buffer& buffer, void* host_pointer,
+                             size_t buffer_size,
+                             const std::vector<cl::Event>& events,
+                             ProfilingData* profiling) {
+  cl::Event event;
+  queue.enqueueReadBuffer(
+      buffer, /*blocking=*/false, /*offset=*/0, /*size=*/buffer_size,
+      /*ptr=*/host_pointer, /*events=*/&events, /*event=*/&event);
+
+  // Set profiling data. The elapsed time is collected once the event has
+  // completed.
+  profiling->transfer_events.push_back(event);
+  profiling->transferred_bytes += buffer_size;
+}
+
+std::vector<cl::Kernel> CreateKernels(const cl::Program& program) {
+  cl_uint num_kernels;
+  cl_int err =
+      ::clCreateKernelsInProgram(program(), 0, nullptr, &num_kernels);
+  if (err != CL_SUCCESS) {
+    throw cl::Error(err, "clCreateKernelsInProgram");
+  }
+
+  std::vector<cl_kernel> handles(num_kernels);
+  if (num_kernels) {
+    err = ::clCreateKernelsInProgram(program(), num_kernels, handles.data(),
+                                     nullptr);
+    if (err != CL_SUCCESS) {
+      throw cl::Error(err, "clCreateKernelsInProgram");
+    }
+  }
+
+  // cl::Kernel takes ownership of the handle without retaining it.
+  std::vector<cl::Kernel> kernels;
+  for (auto handle : handles) {
+    kernels.push_back(cl::Kernel(handle));
+  }
+  return kernels;
+}
+
 string GetOpenClKernelName(const cl::Kernel& kernel) {
   // Rather than determine the size of the character array needed to store the
   // string, allocate a buffer that *should be* large enough. This is a
@@ -35,6 +35,27 @@ void CopyDeviceToHost(const cl::CommandQueue &queue, const cl::Buffer &buffer,
                       void *host_pointer, size_t buffer_size,
                       ProfilingData *profiling);
 
+// Non-blocking host to device copy operation. The host memory must not be
+// modified until the copy has completed. The transfer event is appended to
+// the profiling data, see ProfilingData::CollectTransferEvents().
+void EnqueueCopyHostToDevice(const cl::CommandQueue &queue, void *host_pointer,
+                             const cl::Buffer &buffer, size_t buffer_size,
+                             ProfilingData *profiling);
+
+// Non-blocking device to host copy operation, which begins once all of the
+// given events have completed. The host memory must not be accessed until
+// the copy has completed.
+void EnqueueCopyDeviceToHost(const cl::CommandQueue &queue,
+                             const cl::Buffer &buffer, void *host_pointer,
+                             size_t buffer_size,
+                             const std::vector<cl::Event> &events,
+                             ProfilingData *profiling);
+
+// Create the kernels of a built program. Unlike cl::Program::createKernels(),
+// which retains each kernel an extra time and so leaks them, the returned
+// kernels are the sole owners of their references.
+std::vector<cl::Kernel> CreateKernels(const cl::Program &program);
+
 // Get the name of a kernel.
 string GetOpenClKernelName(const cl::Kernel &kernel);
 
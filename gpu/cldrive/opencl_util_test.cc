@@ -19,6 +19,8 @@
 
 #include "labm8/cpp/test.h"
 
+#include <set>
+
 namespace gpu {
 namespace cldrive {
 namespace util {
@@ -51,6 +53,30 @@ TEST(GetKernelArgTypeName, FloatVectorPointer) {
   EXPECT_EQ(GetKernelArgTypeName(kernel, 0), "float8*");
 }
 
+TEST(CreateKernels, NoKernels) {
+  cl::Program program("void A() {}");
+  program.build("-cl-kernel-arg-info");
+  EXPECT_TRUE(CreateKernels(program).empty());
+}
+
+TEST(CreateKernels, KernelNames) {
+  cl::Program program("kernel void A() {}\nkernel void B() {}");
+  program.build("-cl-kernel-arg-info");
+  auto kernels = CreateKernels(program);
+  ASSERT_EQ(kernels.size(), 2);
+  std::set<string> names{GetOpenClKernelName(kernels[0]),
+                         GetOpenClKernelName(kernels[1])};
+  EXPECT_EQ(names, std::set<string>({"A", "B"}));
+}
+
+TEST(CreateKernels, KernelsHaveSingleReference) {
+  cl::Program program("kernel void A() {}");
+  program.build("-cl-kernel-arg-info");
+  auto kernels = CreateKernels(program);
+  ASSERT_EQ(kernels.size(), 1);
+  EXPECT_EQ(kernels[0].getInfo<CL_KERNEL_REFERENCE_COUNT>(), 1);
+}
+
 TEST(GetKernelArgTypeName, SecondArg) {
   auto kernel =
       CreateClKernel("kernel void A(const int a, local float8 *b) {}");
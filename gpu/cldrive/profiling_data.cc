@@ -25,5 +25,19 @@ labm8::int64 GetElapsedNanoseconds(const cl::Event& event) {
   return static_cast<labm8::int64>(end - start);
 }
 
+labm8::int64 GetExecutionNanoseconds(const cl::Event& event) {
+  event.wait();
+  cl_ulong start = event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+  cl_ulong end = event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+  return static_cast<labm8::int64>(end - start);
+}
+
+void ProfilingData::CollectTransferEvents() {
+  for (const auto& event : transfer_events) {
+    transfer_nanoseconds += GetExecutionNanoseconds(event);
+  }
+  transfer_events.clear();
+}
+
 }  // namespace cldrive
 }  // namespace gpu
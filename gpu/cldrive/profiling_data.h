@@ -19,18 +19,37 @@
 
 #include "third_party/opencl/cl.hpp"
 
+#include <vector>
+
 namespace gpu {
 namespace cldrive {
 
 labm8::int64 GetElapsedNanoseconds(const cl::Event& event);
 
+// Return the time an event spent executing, excluding the time it spent
+// queued. This is used for commands which are enqueued ahead of the commands
+// they depend on, where the queued time includes the time waiting for those.
+labm8::int64 GetExecutionNanoseconds(const cl::Event& event);
+
 class ProfilingData {
  public:
   ProfilingData()
-      : kernel_nanoseconds(0), transfer_nanoseconds(0), transferred_bytes(0) {}
+      : kernel_nanoseconds(0),
+        transfer_nanoseconds(0),
+        transferred_bytes(0),
+        host_allocated_bytes(0) {}
   labm8::int64 kernel_nanoseconds;
   labm8::int64 transfer_nanoseconds;
   labm8::int64 transferred_bytes;
+  // The number of bytes of host memory allocated to hold argument values.
+  labm8::int64 host_allocated_bytes;
+  // The events of non-blocking transfers which have not yet been added to
+  // transfer_nanoseconds.
+  std::vector<cl::Event> transfer_events;
+
+  // Wait for the pending transfer events and add their execution times to
+  // transfer_nanoseconds.
+  void CollectTransferEvents();
 };
 
 }  // namespace cldrive
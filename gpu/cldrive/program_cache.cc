@@ -0,0 +1,115 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/program_cache.h"
+
+#include "gpu/cldrive/hash_util.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/port.h"
+
+#include "absl/strings/str_format.h"
+
+#include "boost/filesystem/fstream.hpp"
+
+#include <iterator>
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace cldrive {
+
+ProgramCache::ProgramCache(const fs::path& cache_dir) : cache_dir_(cache_dir) {
+  boost::system::error_code error;
+  fs::create_directories(cache_dir_, error);
+  if (error) {
+    LOG(WARNING) << "Failed to create program cache directory "
+                 << cache_dir_.string() << ": " << error.message();
+  }
+}
+
+/*static*/ string ProgramCache::GetKey(
+    const string& opencl_src, const string& build_opts,
+    const ::gpu::clinfo::OpenClDevice& device) {
+  util::Fnv1aHash hash;
+  hash.AddField(opencl_src);
+  hash.AddField(build_opts);
+  hash.AddField(device.platform_name());
+  hash.AddField(device.device_name());
+  hash.AddField(device.driver_version());
+  hash.AddField(device.opencl_version());
+  return absl::StrFormat("%016x", hash.hash());
+}
+
+labm8::StatusOr<string> ProgramCache::LoadBinary(const string& key) const {
+  const fs::path path = cache_dir_ / (key + ".bin");
+  fs::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "Program binary not in cache");
+  }
+  string binary((std::istreambuf_iterator<char>(file)),
+                std::istreambuf_iterator<char>());
+  if (binary.empty()) {
+    return labm8::Status(labm8::error::Code::NOT_FOUND,
+                         "Program binary not in cache");
+  }
+  return binary;
+}
+
+bool ProgramCache::IsKnownFailure(const string& key) const {
+  boost::system::error_code error;
+  return fs::exists(cache_dir_ / (key + ".fail"), error);
+}
+
+void ProgramCache::StoreBinary(const string& key, const string& binary) const {
+  AtomicWrite(cache_dir_ / (key + ".bin"), binary);
+}
+
+void ProgramCache::StoreFailure(const string& key) const {
+  AtomicWrite(cache_dir_ / (key + ".fail"), "");
+}
+
+void ProgramCache::AtomicWrite(const fs::path& path,
+                               const string& contents) const {
+  // Write to a uniquely named temporary file in the same directory, then
+  // rename it into place. Rename is atomic within a filesystem, so concurrent
+  // readers see either no entry or a complete one.
+  const fs::path temp_path = cache_dir_ / fs::unique_path(
+                                              path.filename().string() +
+                                              ".tmp-%%%%-%%%%-%%%%-%%%%");
+  {
+    fs::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+    if (!file) {
+      LOG(WARNING) << "Failed to write program cache entry "
+                   << temp_path.string();
+      boost::system::error_code error;
+      fs::remove(temp_path, error);
+      return;
+    }
+  }
+
+  boost::system::error_code error;
+  fs::rename(temp_path, path, error);
+  if (error) {
+    LOG(WARNING) << "Failed to write program cache entry " << path.string()
+                 << ": " << error.message();
+    fs::remove(temp_path, error);
+  }
+}
+
+}  // namespace cldrive
+}  // namespace gpu
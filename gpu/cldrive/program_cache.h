@@ -0,0 +1,66 @@
+// An on-disk cache of compiled OpenCL program binaries.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/clinfo/proto/clinfo.pb.h"
+
+#include "labm8/cpp/statusor.h"
+#include "labm8/cpp/string.h"
+
+#include "boost/filesystem.hpp"
+
+namespace gpu {
+namespace cldrive {
+
+// A content-addressed cache of OpenCL program binaries, keyed by a hash of the
+// program source, build options, and device. Compilation failures are cached
+// too, so that programs which are known to fail are rejected without a
+// rebuild.
+//
+// Entries are written to a temporary file and renamed into place, so the
+// cache can be shared by concurrent processes. The cache is best-effort:
+// failures to read or write entries are logged and ignored.
+class ProgramCache {
+ public:
+  // Create a cache in the given directory, creating it if required.
+  explicit ProgramCache(const boost::filesystem::path& cache_dir);
+
+  // Return the cache key of a program. The key is a hex-encoded 64-bit hash
+  // of the source, build options, and the device name and driver version.
+  static string GetKey(const string& opencl_src, const string& build_opts,
+                       const ::gpu::clinfo::OpenClDevice& device);
+
+  // Return the cached program binary for the given key, else NOT_FOUND.
+  labm8::StatusOr<string> LoadBinary(const string& key) const;
+
+  // Return whether a compilation failure was cached for the given key.
+  bool IsKnownFailure(const string& key) const;
+
+  void StoreBinary(const string& key, const string& binary) const;
+
+  void StoreFailure(const string& key) const;
+
+ private:
+  void AtomicWrite(const boost::filesystem::path& path,
+                   const string& contents) const;
+
+  boost::filesystem::path cache_dir_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
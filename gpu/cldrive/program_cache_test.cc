@@ -0,0 +1,114 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/program_cache.h"
+
+#include "labm8/cpp/test.h"
+
+#include "boost/filesystem.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+class ProgramCacheTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    cache_dir_ = fs::temp_directory_path() /
+                 fs::unique_path("program_cache_test_%%%%-%%%%-%%%%");
+  }
+
+  virtual void TearDown() override { fs::remove_all(cache_dir_); }
+
+  fs::path cache_dir_;
+};
+
+::gpu::clinfo::OpenClDevice MakeDevice(const string& driver_version) {
+  ::gpu::clinfo::OpenClDevice device;
+  device.set_platform_name("platform");
+  device.set_device_name("device");
+  device.set_driver_version(driver_version);
+  device.set_opencl_version("1.2");
+  return device;
+}
+
+TEST(ProgramCacheGetKey, SameInputsHaveSameKey) {
+  EXPECT_EQ(ProgramCache::GetKey("kernel void A() {}", "", MakeDevice("1")),
+            ProgramCache::GetKey("kernel void A() {}", "", MakeDevice("1")));
+}
+
+TEST(ProgramCacheGetKey, DifferentSourcesHaveDifferentKeys) {
+  EXPECT_NE(ProgramCache::GetKey("kernel void A() {}", "", MakeDevice("1")),
+            ProgramCache::GetKey("kernel void B() {}", "", MakeDevice("1")));
+}
+
+TEST(ProgramCacheGetKey, DifferentBuildOptsHaveDifferentKeys) {
+  EXPECT_NE(ProgramCache::GetKey("kernel void A() {}", "", MakeDevice("1")),
+            ProgramCache::GetKey("kernel void A() {}", "-cl-opt-disable",
+                                 MakeDevice("1")));
+}
+
+TEST(ProgramCacheGetKey, DifferentDriverVersionsHaveDifferentKeys) {
+  EXPECT_NE(ProgramCache::GetKey("kernel void A() {}", "", MakeDevice("1")),
+            ProgramCache::GetKey("kernel void A() {}", "", MakeDevice("2")));
+}
+
+TEST(ProgramCacheGetKey, FieldBoundariesAreHashed) {
+  EXPECT_NE(ProgramCache::GetKey("ab", "c", MakeDevice("1")),
+            ProgramCache::GetKey("a", "bc", MakeDevice("1")));
+}
+
+TEST_F(ProgramCacheTest, MissingBinaryIsNotFound) {
+  ProgramCache cache(cache_dir_);
+  EXPECT_FALSE(cache.LoadBinary("0123456789abcdef").ok());
+}
+
+TEST_F(ProgramCacheTest, StoredBinaryIsLoaded) {
+  ProgramCache cache(cache_dir_);
+  const string binary("\x7f" "ELF\0binary", 11);
+  cache.StoreBinary("0123456789abcdef", binary);
+
+  auto loaded = ProgramCache(cache_dir_).LoadBinary("0123456789abcdef");
+  ASSERT_TRUE(loaded.ok());
+  EXPECT_EQ(loaded.ValueOrDie(), binary);
+}
+
+TEST_F(ProgramCacheTest, StoredFailureIsKnown) {
+  ProgramCache cache(cache_dir_);
+  EXPECT_FALSE(cache.IsKnownFailure("0123456789abcdef"));
+  cache.StoreFailure("0123456789abcdef");
+  EXPECT_TRUE(cache.IsKnownFailure("0123456789abcdef"));
+  EXPECT_FALSE(cache.LoadBinary("0123456789abcdef").ok());
+}
+
+TEST_F(ProgramCacheTest, NoTemporaryFilesRemain) {
+  ProgramCache cache(cache_dir_);
+  cache.StoreBinary("0123456789abcdef", "binary");
+  cache.StoreBinary("0123456789abcdef", "binary");
+  int num_files = 0;
+  for (fs::directory_iterator it(cache_dir_); it != fs::directory_iterator();
+       ++it) {
+    ++num_files;
+  }
+  EXPECT_EQ(num_files, 1);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
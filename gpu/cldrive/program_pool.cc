@@ -0,0 +1,59 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/program_pool.h"
+
+namespace gpu {
+namespace cldrive {
+
+ProgramPool::ProgramPool(size_t capacity) : capacity_(capacity) {}
+
+bool ProgramPool::Get(const string& key, cl::Program* program) {
+  labm8::MutexLock lock(&mutex_);
+
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return false;
+  }
+  programs_.splice(programs_.begin(), programs_, it->second);
+  *program = it->second->second;
+  return true;
+}
+
+void ProgramPool::Put(const string& key, const cl::Program& program) {
+  labm8::MutexLock lock(&mutex_);
+
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second->second = program;
+    programs_.splice(programs_.begin(), programs_, it->second);
+    return;
+  }
+
+  programs_.emplace_front(key, program);
+  index_[key] = programs_.begin();
+  while (programs_.size() > capacity_) {
+    index_.erase(programs_.back().first);
+    programs_.pop_back();
+  }
+}
+
+size_t ProgramPool::size() const {
+  labm8::MutexLock lock(&mutex_);
+  return programs_.size();
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,62 @@
+// An in-memory pool of built OpenCL programs.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "third_party/opencl/cl.hpp"
+
+#include "labm8/cpp/mutex.h"
+#include "labm8/cpp/string.h"
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace gpu {
+namespace cldrive {
+
+// A bounded pool of built programs, keyed by ProgramCache::GetKey(). This
+// lets a long-lived process skip clBuildProgram() for programs it has run
+// before. Unlike ProgramCache, entries are only valid within a process, and
+// only while the contexts of OpenClContextPool are alive, so the pool must be
+// destroyed before OpenClContextPool::Clear() is called.
+class ProgramPool {
+ public:
+  // Create a pool of up to capacity programs. Once full, the least recently
+  // used program is evicted.
+  explicit ProgramPool(size_t capacity);
+
+  // Return whether a program is pooled for the given key, and if so, set the
+  // program.
+  bool Get(const string& key, cl::Program* program);
+
+  void Put(const string& key, const cl::Program& program);
+
+  size_t size() const;
+
+ private:
+  using Entry = std::pair<string, cl::Program>;
+
+  const size_t capacity_;
+  mutable labm8::Mutex mutex_;
+  // Programs in order of most to least recently used.
+  std::list<Entry> programs_;
+  std::unordered_map<string, std::list<Entry>::iterator> index_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
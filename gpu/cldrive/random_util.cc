@@ -0,0 +1,150 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/random_util.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+namespace {
+
+constexpr labm8::uint32 kPhiloxM0 = 0xD2511F53;
+constexpr labm8::uint32 kPhiloxM1 = 0xCD9E8D57;
+constexpr labm8::uint32 kPhiloxW0 = 0x9E3779B9;
+constexpr labm8::uint32 kPhiloxW1 = 0xBB67AE85;
+constexpr int kPhiloxRounds = 10;
+
+// The number of blocks generated together in structure-of-arrays form.
+constexpr size_t kBatchSize = 16;
+
+// The minimum number of elements worth starting a thread for.
+constexpr size_t kMinChunkSize = 1 << 18;
+
+inline void MulHiLo(labm8::uint32 a, labm8::uint32 b, labm8::uint32* hi,
+                    labm8::uint32* lo) {
+  labm8::uint64 product = static_cast<labm8::uint64>(a) * b;
+  *hi = static_cast<labm8::uint32>(product >> 32);
+  *lo = static_cast<labm8::uint32>(product);
+}
+
+// Run the Philox rounds over kBatchSize blocks. Each array holds one word of
+// every block, so that each round is a loop over independent lanes.
+void PhiloxBatch(labm8::uint32 c0[kBatchSize], labm8::uint32 c1[kBatchSize],
+                 labm8::uint32 c2[kBatchSize], labm8::uint32 c3[kBatchSize],
+                 labm8::uint32 k0, labm8::uint32 k1) {
+  for (int round = 0; round < kPhiloxRounds; ++round) {
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      labm8::uint32 hi0, lo0, hi1, lo1;
+      MulHiLo(kPhiloxM0, c0[i], &hi0, &lo0);
+      MulHiLo(kPhiloxM1, c2[i], &hi1, &lo1);
+      const labm8::uint32 x0 = hi1 ^ c1[i] ^ k0;
+      const labm8::uint32 x2 = hi0 ^ c3[i] ^ k1;
+      c0[i] = x0;
+      c1[i] = lo1;
+      c2[i] = x2;
+      c3[i] = lo0;
+    }
+    k0 += kPhiloxW0;
+    k1 += kPhiloxW1;
+  }
+}
+
+}  // anonymous namespace
+
+void Philox4x32(const labm8::uint32 counter[4], const labm8::uint32 key[2],
+                labm8::uint32 out[4]) {
+  labm8::uint32 c0 = counter[0], c1 = counter[1], c2 = counter[2],
+                c3 = counter[3];
+  labm8::uint32 k0 = key[0], k1 = key[1];
+  for (int round = 0; round < kPhiloxRounds; ++round) {
+    labm8::uint32 hi0, lo0, hi1, lo1;
+    MulHiLo(kPhiloxM0, c0, &hi0, &lo0);
+    MulHiLo(kPhiloxM1, c2, &hi1, &lo1);
+    c0 = hi1 ^ c1 ^ k0;
+    c1 = lo1;
+    c2 = hi0 ^ c3 ^ k1;
+    c3 = lo0;
+    k0 += kPhiloxW0;
+    k1 += kPhiloxW1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+void GeneratePhilox4x32(labm8::uint64 seed, labm8::uint32 stream,
+                        labm8::uint64 first_block, size_t num_blocks,
+                        labm8::uint32* out) {
+  const labm8::uint32 k0 = static_cast<labm8::uint32>(seed);
+  const labm8::uint32 k1 = static_cast<labm8::uint32>(seed >> 32);
+
+  labm8::uint32 c0[kBatchSize], c1[kBatchSize], c2[kBatchSize],
+      c3[kBatchSize];
+  for (size_t begin = 0; begin < num_blocks; begin += kBatchSize) {
+    // The counter is the 64-bit block index, followed by the stream.
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      const labm8::uint64 block = first_block + begin + i;
+      c0[i] = static_cast<labm8::uint32>(block);
+      c1[i] = static_cast<labm8::uint32>(block >> 32);
+      c2[i] = stream;
+      c3[i] = 0;
+    }
+
+    PhiloxBatch(c0, c1, c2, c3, k0, k1);
+
+    const size_t n = std::min(kBatchSize, num_blocks - begin);
+    labm8::uint32* dst = out + 4 * begin;
+    for (size_t i = 0; i < n; ++i) {
+      dst[4 * i] = c0[i];
+      dst[4 * i + 1] = c1[i];
+      dst[4 * i + 2] = c2[i];
+      dst[4 * i + 3] = c3[i];
+    }
+  }
+}
+
+void ParallelForChunks(size_t size, size_t alignment,
+                       const std::function<void(size_t, size_t)>& fn) {
+  const size_t max_threads =
+      std::max(std::thread::hardware_concurrency(), 1u);
+  const size_t num_threads =
+      std::min(max_threads, std::max<size_t>(size / kMinChunkSize, 1));
+  if (num_threads == 1) {
+    fn(0, size);
+    return;
+  }
+
+  // Round the chunk size up to a multiple of the alignment.
+  size_t chunk_size = (size + num_threads - 1) / num_threads;
+  chunk_size = ((chunk_size + alignment - 1) / alignment) * alignment;
+
+  std::vector<std::thread> threads;
+  for (size_t begin = 0; begin < size; begin += chunk_size) {
+    threads.emplace_back(fn, begin, std::min(begin + chunk_size, size));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,55 @@
+// Counter-based random number generation for argument values.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/port.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// The Philox4x32-10 counter-based pseudo-random number generator of Salmon et
+// al., "Parallel Random Numbers: As Easy as 1, 2, 3" (SC'11). Each (key,
+// counter) pair maps to a block of four independent 32-bit words, so any
+// range of a random sequence can be generated directly, in any order and by
+// any number of threads, with identical results.
+//
+// Sets out to the block for the given counter and key.
+void Philox4x32(const labm8::uint32 counter[4], const labm8::uint32 key[2],
+                labm8::uint32 out[4]);
+
+// Generate num_blocks consecutive blocks of the random sequence identified by
+// a seed and a stream, starting at block first_block, and write the 4 *
+// num_blocks words to out. Blocks are generated in batches that the compiler
+// can vectorize.
+void GeneratePhilox4x32(labm8::uint64 seed, labm8::uint32 stream,
+                        labm8::uint64 first_block, size_t num_blocks,
+                        labm8::uint32* out);
+
+// Call fn(begin, end) for disjoint chunks which cover [0, size). Chunk
+// boundaries are multiples of alignment. Large ranges are split across
+// threads, and this returns once all chunks have been processed.
+void ParallelForChunks(size_t size, size_t alignment,
+                       const std::function<void(size_t, size_t)>& fn);
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
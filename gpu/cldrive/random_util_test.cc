@@ -0,0 +1,113 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/random_util.h"
+
+#include "labm8/cpp/test.h"
+
+#include <atomic>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+namespace {
+
+// Known answer tests from the Random123 distribution.
+
+TEST(Philox4x32, KnownAnswerZeros) {
+  labm8::uint32 counter[4] = {0, 0, 0, 0};
+  labm8::uint32 key[2] = {0, 0};
+  labm8::uint32 out[4];
+  Philox4x32(counter, key, out);
+  EXPECT_EQ(out[0], 0x6627e8d5);
+  EXPECT_EQ(out[1], 0xe169c58d);
+  EXPECT_EQ(out[2], 0xbc57ac4c);
+  EXPECT_EQ(out[3], 0x9b00dbd8);
+}
+
+TEST(Philox4x32, KnownAnswerOnes) {
+  labm8::uint32 counter[4] = {0xffffffff, 0xffffffff, 0xffffffff,
+                              0xffffffff};
+  labm8::uint32 key[2] = {0xffffffff, 0xffffffff};
+  labm8::uint32 out[4];
+  Philox4x32(counter, key, out);
+  EXPECT_EQ(out[0], 0x408f276d);
+  EXPECT_EQ(out[1], 0x41c83b0e);
+  EXPECT_EQ(out[2], 0xa20bc7c6);
+  EXPECT_EQ(out[3], 0x6d5451fd);
+}
+
+TEST(GeneratePhilox4x32, MatchesSingleBlocks) {
+  const labm8::uint64 seed = 0x123456789abcdefULL;
+  std::vector<labm8::uint32> words(4 * 37);
+  GeneratePhilox4x32(seed, /*stream=*/3, /*first_block=*/5, 37, words.data());
+
+  for (size_t block = 0; block < 37; ++block) {
+    labm8::uint32 counter[4] = {static_cast<labm8::uint32>(5 + block), 0, 3,
+                                0};
+    labm8::uint32 key[2] = {0x89abcdef, 0x01234567};
+    labm8::uint32 out[4];
+    Philox4x32(counter, key, out);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(words[4 * block + i], out[i]);
+    }
+  }
+}
+
+TEST(GeneratePhilox4x32, StreamsDiffer) {
+  std::vector<labm8::uint32> a(4), b(4);
+  GeneratePhilox4x32(/*seed=*/0, /*stream=*/0, 0, 1, a.data());
+  GeneratePhilox4x32(/*seed=*/0, /*stream=*/1, 0, 1, b.data());
+  EXPECT_NE(a, b);
+}
+
+TEST(GeneratePhilox4x32, SeedsDiffer) {
+  std::vector<labm8::uint32> a(4), b(4);
+  GeneratePhilox4x32(/*seed=*/0, /*stream=*/0, 0, 1, a.data());
+  GeneratePhilox4x32(/*seed=*/1, /*stream=*/0, 0, 1, b.data());
+  EXPECT_NE(a, b);
+}
+
+TEST(ParallelForChunks, SmallRangeIsSingleChunk) {
+  int num_calls = 0;
+  ParallelForChunks(100, 4, [&](size_t begin, size_t end) {
+    ++num_calls;
+    EXPECT_EQ(begin, 0);
+    EXPECT_EQ(end, 100);
+  });
+  EXPECT_EQ(num_calls, 1);
+}
+
+TEST(ParallelForChunks, LargeRangeIsCoveredOnce) {
+  const size_t size = (1 << 21) + 3;
+  std::vector<std::atomic<int>> counts(size);
+  ParallelForChunks(size, 1024, [&](size_t begin, size_t end) {
+    EXPECT_EQ(begin % 1024, 0);
+    for (size_t i = begin; i < end; ++i) {
+      ++counts[i];
+    }
+  });
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_EQ(counts[i], 1);
+  }
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
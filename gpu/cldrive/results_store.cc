@@ -0,0 +1,321 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/results_store.h"
+
+#include "gpu/cldrive/hash_util.h"
+
+#include "labm8/cpp/logging.h"
+
+#include "absl/strings/str_format.h"
+
+#include <sqlite3.h>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// Journal writes ahead of the database so that readers and a writer may run
+// concurrently, and a crash never leaves a partially written database.
+// NORMAL synchronization is durable across process crashes, which is the
+// failure this store guards against, without an fsync per transaction.
+const char* kSchema = R"(
+PRAGMA journal_mode = WAL;
+PRAGMA synchronous = NORMAL;
+
+CREATE TABLE IF NOT EXISTS runs (
+  source_hash TEXT NOT NULL,
+  device_name TEXT NOT NULL,
+  build_opts TEXT NOT NULL,
+  global_size INTEGER NOT NULL,
+  local_size INTEGER NOT NULL,
+  kernel_name TEXT NOT NULL,
+  driver_version TEXT NOT NULL,
+  outcome TEXT NOT NULL,
+  kernel_time_ns_median REAL,
+  run BLOB NOT NULL,
+  PRIMARY KEY (source_hash, device_name, build_opts, global_size, local_size,
+               kernel_name)
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS complete (
+  source_hash TEXT NOT NULL,
+  device_name TEXT NOT NULL,
+  build_opts TEXT NOT NULL,
+  global_size INTEGER NOT NULL,
+  local_size INTEGER NOT NULL,
+  driver_version TEXT NOT NULL,
+  outcome TEXT NOT NULL,
+  PRIMARY KEY (source_hash, device_name, build_opts, global_size, local_size)
+) WITHOUT ROWID;
+)";
+
+// The key columns, bound as the first five parameters of each statement.
+#define KEY_COLUMNS \
+  "source_hash = ?1 AND device_name = ?2 AND build_opts = ?3 AND " \
+  "global_size = ?4 AND local_size = ?5"
+
+const int kBusyTimeoutMs = 60000;
+
+void BindText(sqlite3_stmt* statement, int index, const string& value) {
+  sqlite3_bind_text(statement, index, value.data(), value.size(),
+                    SQLITE_TRANSIENT);
+}
+
+void BindKey(sqlite3_stmt* statement, const ResultKey& key) {
+  BindText(statement, 1, key.source_hash);
+  BindText(statement, 2, key.device_name);
+  BindText(statement, 3, key.build_opts);
+  sqlite3_bind_int(statement, 4, key.global_size);
+  sqlite3_bind_int(statement, 5, key.local_size);
+}
+
+// Return whether the instance, or any of its kernels, crashed or timed out,
+// in which case some of its kernels may not have run.
+bool CrashedOrTimedOut(const CldriveInstance& instance) {
+  if (instance.outcome() == CldriveInstance::CRASH ||
+      instance.outcome() == CldriveInstance::TIMEOUT) {
+    return true;
+  }
+  for (const auto& kernel : instance.kernel()) {
+    if (kernel.outcome() == CldriveKernelInstance::CRASH ||
+        kernel.outcome() == CldriveKernelInstance::TIMEOUT) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // anonymous namespace
+
+ResultKey GetResultKey(const CldriveInstance& instance,
+                       const DynamicParams& dynamic_params) {
+  util::Fnv1aHash hash;
+  hash.AddField(instance.opencl_src());
+
+  ResultKey key;
+  key.source_hash = absl::StrFormat("%016x", hash.hash());
+  key.device_name = instance.device().name();
+  key.build_opts = instance.build_opts();
+  key.global_size = dynamic_params.global_size_x();
+  key.local_size = dynamic_params.local_size_x();
+  return key;
+}
+
+/*static*/ labm8::Status ResultsStore::Open(
+    const string& path, std::unique_ptr<ResultsStore>* store) {
+  sqlite3* db;
+  if (sqlite3_open_v2(path.c_str(), &db,
+                      SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE |
+                          SQLITE_OPEN_FULLMUTEX,
+                      nullptr) != SQLITE_OK) {
+    string message = db ? sqlite3_errmsg(db) : "out of memory";
+    sqlite3_close(db);
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Failed to open results store " + path + ": " +
+                             message);
+  }
+  sqlite3_busy_timeout(db, kBusyTimeoutMs);
+  store->reset(new ResultsStore(db));
+
+  labm8::Status status = (*store)->Execute(kSchema);
+  if (status.ok()) {
+    status = (*store)->Prepare(
+        "SELECT 1 FROM complete WHERE " KEY_COLUMNS " AND driver_version = ?6",
+        &(*store)->is_complete_);
+  }
+  if (status.ok()) {
+    status = (*store)->Prepare(
+        "INSERT OR REPLACE INTO runs (source_hash, device_name, build_opts, "
+        "global_size, local_size, kernel_name, driver_version, outcome, "
+        "kernel_time_ns_median, run) "
+        "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)",
+        &(*store)->insert_run_);
+  }
+  if (status.ok()) {
+    status = (*store)->Prepare(
+        "DELETE FROM runs WHERE " KEY_COLUMNS " AND driver_version != ?6",
+        &(*store)->delete_stale_runs_);
+  }
+  if (status.ok()) {
+    status = (*store)->Prepare(
+        "INSERT OR REPLACE INTO complete (source_hash, device_name, "
+        "build_opts, global_size, local_size, driver_version, outcome) "
+        "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)",
+        &(*store)->mark_complete_);
+  }
+  if (!status.ok()) {
+    store->reset();
+  }
+  return status;
+}
+
+ResultsStore::ResultsStore(sqlite3* db)
+    : db_(db),
+      is_complete_(nullptr),
+      insert_run_(nullptr),
+      delete_stale_runs_(nullptr),
+      mark_complete_(nullptr) {}
+
+ResultsStore::~ResultsStore() {
+  for (auto statement :
+       {is_complete_, insert_run_, delete_stale_runs_, mark_complete_}) {
+    sqlite3_finalize(statement);
+  }
+  sqlite3_close(db_);
+}
+
+bool ResultsStore::IsComplete(const ResultKey& key,
+                              const string& driver_version) {
+  labm8::MutexLock lock(&mutex_);
+  BindKey(is_complete_, key);
+  BindText(is_complete_, 6, driver_version);
+  const int result = sqlite3_step(is_complete_);
+  if (result != SQLITE_ROW && result != SQLITE_DONE) {
+    LOG(ERROR) << "Failed to look up result: " << sqlite3_errmsg(db_);
+  }
+  sqlite3_reset(is_complete_);
+  return result == SQLITE_ROW;
+}
+
+bool ResultsStore::IsComplete(const CldriveInstance& instance) {
+  if (!instance.dynamic_params_size()) {
+    return false;
+  }
+  for (const auto& dynamic_params : instance.dynamic_params()) {
+    if (!IsComplete(GetResultKey(instance, dynamic_params),
+                    instance.device().driver_version())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+labm8::Status ResultsStore::InsertRun(const CldriveInstance& instance,
+                                      const string& kernel_name,
+                                      const CldriveKernelRun& run) {
+  const ResultKey key = GetResultKey(instance, run.dynamic_params());
+  string serialized_run;
+  run.SerializeToString(&serialized_run);
+
+  // A single statement is a transaction of its own.
+  labm8::MutexLock lock(&mutex_);
+  BindKey(insert_run_, key);
+  BindText(insert_run_, 6, kernel_name);
+  BindText(insert_run_, 7, instance.device().driver_version());
+  BindText(insert_run_, 8,
+           CldriveKernelRun::KernelRunOutcome_Name(run.outcome()));
+  if (run.has_kernel_time_ns_median()) {
+    sqlite3_bind_double(insert_run_, 9, run.kernel_time_ns_median());
+  } else {
+    sqlite3_bind_null(insert_run_, 9);
+  }
+  sqlite3_bind_blob(insert_run_, 10, serialized_run.data(),
+                    serialized_run.size(), SQLITE_TRANSIENT);
+  return Step(insert_run_);
+}
+
+labm8::Status ResultsStore::MarkComplete(const CldriveInstance& instance) {
+  if (CrashedOrTimedOut(instance)) {
+    return labm8::Status::OK;
+  }
+
+  const string& driver_version = instance.device().driver_version();
+  const string outcome =
+      CldriveInstance::InstanceOutcome_Name(instance.outcome());
+
+  labm8::MutexLock lock(&mutex_);
+  labm8::Status status = Execute("BEGIN IMMEDIATE");
+  if (!status.ok()) {
+    return status;
+  }
+  for (const auto& dynamic_params : instance.dynamic_params()) {
+    const ResultKey key = GetResultKey(instance, dynamic_params);
+
+    BindKey(delete_stale_runs_, key);
+    BindText(delete_stale_runs_, 6, driver_version);
+    status = Step(delete_stale_runs_);
+    if (!status.ok()) {
+      break;
+    }
+
+    BindKey(mark_complete_, key);
+    BindText(mark_complete_, 6, driver_version);
+    BindText(mark_complete_, 7, outcome);
+    status = Step(mark_complete_);
+    if (!status.ok()) {
+      break;
+    }
+  }
+  if (!status.ok()) {
+    Execute("ROLLBACK");
+    return status;
+  }
+  return Execute("COMMIT");
+}
+
+int ResultsStore::num_runs() { return Count("runs"); }
+
+int ResultsStore::num_complete() { return Count("complete"); }
+
+labm8::Status ResultsStore::Execute(const string& sql) {
+  char* error = nullptr;
+  if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+    string message = error ? error : sqlite3_errmsg(db_);
+    sqlite3_free(error);
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Results store error: " + message);
+  }
+  return labm8::Status::OK;
+}
+
+labm8::Status ResultsStore::Prepare(const string& sql,
+                                    sqlite3_stmt** statement) {
+  if (sqlite3_prepare_v2(db_, sql.c_str(), -1, statement, nullptr) !=
+      SQLITE_OK) {
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         string("Results store error: ") + sqlite3_errmsg(db_));
+  }
+  return labm8::Status::OK;
+}
+
+labm8::Status ResultsStore::Step(sqlite3_stmt* statement) {
+  labm8::Status status = labm8::Status::OK;
+  if (sqlite3_step(statement) != SQLITE_DONE) {
+    status =
+        labm8::Status(labm8::error::Code::INTERNAL,
+                      string("Results store error: ") + sqlite3_errmsg(db_));
+  }
+  sqlite3_reset(statement);
+  return status;
+}
+
+int ResultsStore::Count(const string& table) {
+  labm8::MutexLock lock(&mutex_);
+  sqlite3_stmt* statement;
+  if (!Prepare("SELECT COUNT(*) FROM " + table, &statement).ok()) {
+    return 0;
+  }
+  int count = 0;
+  if (sqlite3_step(statement) == SQLITE_ROW) {
+    count = sqlite3_column_int(statement, 0);
+  }
+  sqlite3_finalize(statement);
+  return count;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,110 @@
+// An embedded store of kernel run results, used to resume batches.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/mutex.h"
+#include "labm8/cpp/status.h"
+#include "labm8/cpp/string.h"
+
+#include <memory>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace gpu {
+namespace cldrive {
+
+// The key of a result: a source on a device, built with a set of options and
+// driven with a launch config.
+struct ResultKey {
+  // A hex encoded 64-bit hash of the source content.
+  string source_hash;
+  string device_name;
+  string build_opts;
+  int global_size;
+  int local_size;
+};
+
+// Return the key of the given dynamic params of an instance on its device.
+ResultKey GetResultKey(const CldriveInstance& instance,
+                       const DynamicParams& dynamic_params);
+
+// A crash-safe store of kernel run results, backed by a SQLite database in
+// write-ahead logging mode. Each kernel run is inserted in its own
+// transaction, so a process which is killed loses at most the run in
+// progress. Once every kernel of an instance has run, the keys of the
+// instance are marked complete, and a restarted batch skips them with an
+// index lookup.
+//
+// A key is only complete for the driver version of the device which produced
+// it, so results are re-run when a driver is upgraded. Since the source hash
+// is part of the key, a changed source is a new key.
+//
+// A store may be shared by threads, and by concurrent processes.
+class ResultsStore {
+ public:
+  // Open a database, creating it if it does not exist.
+  static labm8::Status Open(const string& path,
+                            std::unique_ptr<ResultsStore>* store);
+
+  ~ResultsStore();
+
+  // Return whether a key is complete for the given driver version.
+  bool IsComplete(const ResultKey& key, const string& driver_version);
+
+  // Return whether every dynamic params of an instance is complete for the
+  // driver version of its device.
+  bool IsComplete(const CldriveInstance& instance);
+
+  // Insert the run of a kernel, replacing any previous run of the kernel with
+  // the same key.
+  labm8::Status InsertRun(const CldriveInstance& instance,
+                          const string& kernel_name,
+                          const CldriveKernelRun& run);
+
+  // Mark every dynamic params of an instance complete, and delete the runs of
+  // its keys which were produced by other driver versions. An instance which
+  // crashed or timed out, or one of whose kernels did, is not marked complete,
+  // so that it is run again when the batch is resumed.
+  labm8::Status MarkComplete(const CldriveInstance& instance);
+
+  // Return the number of runs, and the number of complete keys, in the
+  // store.
+  int num_runs();
+  int num_complete();
+
+ private:
+  explicit ResultsStore(sqlite3* db);
+
+  labm8::Status Execute(const string& sql);
+  labm8::Status Prepare(const string& sql, sqlite3_stmt** statement);
+  labm8::Status Step(sqlite3_stmt* statement);
+  int Count(const string& table);
+
+  labm8::Mutex mutex_;
+  sqlite3* db_;
+  sqlite3_stmt* is_complete_;
+  sqlite3_stmt* insert_run_;
+  sqlite3_stmt* delete_stale_runs_;
+  sqlite3_stmt* mark_complete_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
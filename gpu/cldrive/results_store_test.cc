@@ -0,0 +1,189 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/results_store.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/test.h"
+
+#include "boost/filesystem.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+class ResultsStoreTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    dir_ = fs::temp_directory_path() /
+           fs::unique_path("results_store_test_%%%%-%%%%-%%%%");
+    fs::create_directories(dir_);
+    path_ = (dir_ / "results.db").string();
+  }
+
+  virtual void TearDown() override { fs::remove_all(dir_); }
+
+  std::unique_ptr<ResultsStore> OpenOrDie() {
+    std::unique_ptr<ResultsStore> store;
+    auto status = ResultsStore::Open(path_, &store);
+    CHECK(status.ok()) << status.error_message();
+    return store;
+  }
+
+  fs::path dir_;
+  string path_;
+};
+
+CldriveInstance MakeInstance(const string& opencl_src,
+                             const string& driver_version) {
+  CldriveInstance instance;
+  instance.set_opencl_src(opencl_src);
+  instance.mutable_device()->set_name("device");
+  instance.mutable_device()->set_driver_version(driver_version);
+  instance.set_outcome(CldriveInstance::PASS);
+  for (int global_size : {1024, 4096}) {
+    DynamicParams* dynamic_params = instance.add_dynamic_params();
+    dynamic_params->set_global_size_x(global_size);
+    dynamic_params->set_local_size_x(128);
+  }
+  return instance;
+}
+
+CldriveKernelRun MakeRun(const DynamicParams& dynamic_params) {
+  CldriveKernelRun run;
+  run.set_outcome(CldriveKernelRun::PASS);
+  run.set_kernel_time_ns_median(100);
+  *run.mutable_dynamic_params() = dynamic_params;
+  return run;
+}
+
+TEST(GetResultKey, DifferentSourcesHaveDifferentKeys) {
+  const auto a = MakeInstance("kernel void A() {}", "1");
+  const auto b = MakeInstance("kernel void B() {}", "1");
+  EXPECT_NE(GetResultKey(a, a.dynamic_params(0)).source_hash,
+            GetResultKey(b, b.dynamic_params(0)).source_hash);
+}
+
+TEST_F(ResultsStoreTest, NewStoreIsEmpty) {
+  auto store = OpenOrDie();
+  EXPECT_EQ(store->num_runs(), 0);
+  EXPECT_EQ(store->num_complete(), 0);
+  EXPECT_FALSE(store->IsComplete(MakeInstance("kernel void A() {}", "1")));
+}
+
+TEST_F(ResultsStoreTest, RunsAreNotCompleteUntilMarked) {
+  auto store = OpenOrDie();
+  const auto instance = MakeInstance("kernel void A() {}", "1");
+  for (const auto& dynamic_params : instance.dynamic_params()) {
+    ASSERT_TRUE(store->InsertRun(instance, "A", MakeRun(dynamic_params)).ok());
+  }
+  EXPECT_EQ(store->num_runs(), 2);
+  EXPECT_FALSE(store->IsComplete(instance));
+
+  ASSERT_TRUE(store->MarkComplete(instance).ok());
+  EXPECT_EQ(store->num_complete(), 2);
+  EXPECT_TRUE(store->IsComplete(instance));
+}
+
+TEST_F(ResultsStoreTest, RerunReplacesRun) {
+  auto store = OpenOrDie();
+  const auto instance = MakeInstance("kernel void A() {}", "1");
+  const auto run = MakeRun(instance.dynamic_params(0));
+  ASSERT_TRUE(store->InsertRun(instance, "A", run).ok());
+  ASSERT_TRUE(store->InsertRun(instance, "A", run).ok());
+  EXPECT_EQ(store->num_runs(), 1);
+}
+
+TEST_F(ResultsStoreTest, ResultsArePersistent) {
+  const auto instance = MakeInstance("kernel void A() {}", "1");
+  {
+    auto store = OpenOrDie();
+    ASSERT_TRUE(
+        store->InsertRun(instance, "A", MakeRun(instance.dynamic_params(0)))
+            .ok());
+    ASSERT_TRUE(store->MarkComplete(instance).ok());
+  }
+  auto store = OpenOrDie();
+  EXPECT_EQ(store->num_runs(), 1);
+  EXPECT_TRUE(store->IsComplete(instance));
+}
+
+TEST_F(ResultsStoreTest, ChangedSourceIsNotComplete) {
+  auto store = OpenOrDie();
+  ASSERT_TRUE(
+      store->MarkComplete(MakeInstance("kernel void A() {}", "1")).ok());
+  EXPECT_FALSE(store->IsComplete(MakeInstance("kernel void B() {}", "1")));
+}
+
+TEST_F(ResultsStoreTest, ChangedDriverVersionIsNotComplete) {
+  auto store = OpenOrDie();
+  const auto old_instance = MakeInstance("kernel void A() {}", "1");
+  const auto new_instance = MakeInstance("kernel void A() {}", "2");
+  ASSERT_TRUE(store
+                  ->InsertRun(old_instance, "A",
+                              MakeRun(old_instance.dynamic_params(0)))
+                  .ok());
+  ASSERT_TRUE(store->MarkComplete(old_instance).ok());
+  EXPECT_FALSE(store->IsComplete(new_instance));
+
+  // Completing the instance with the new driver removes the stale runs.
+  ASSERT_TRUE(store->MarkComplete(new_instance).ok());
+  EXPECT_TRUE(store->IsComplete(new_instance));
+  EXPECT_FALSE(store->IsComplete(old_instance));
+  EXPECT_EQ(store->num_runs(), 0);
+}
+
+TEST_F(ResultsStoreTest, CrashedInstanceIsNotComplete) {
+  auto instance = MakeInstance("kernel void A() {}", "1");
+  instance.set_outcome(CldriveInstance::CRASH);
+  {
+    auto store = OpenOrDie();
+    ASSERT_TRUE(store->MarkComplete(instance).ok());
+    EXPECT_EQ(store->num_complete(), 0);
+  }
+
+  // The instance is run again when resumed, and is complete once it passes.
+  auto store = OpenOrDie();
+  EXPECT_FALSE(store->IsComplete(instance));
+  instance.set_outcome(CldriveInstance::PASS);
+  ASSERT_TRUE(store->MarkComplete(instance).ok());
+  EXPECT_TRUE(store->IsComplete(instance));
+}
+
+TEST_F(ResultsStoreTest, InstanceWithTimedOutKernelIsNotComplete) {
+  auto instance = MakeInstance("kernel void A() {}", "1");
+  instance.add_kernel()->set_outcome(CldriveKernelInstance::PASS);
+  instance.add_kernel()->set_outcome(CldriveKernelInstance::TIMEOUT);
+  {
+    auto store = OpenOrDie();
+    ASSERT_TRUE(
+        store->InsertRun(instance, "A", MakeRun(instance.dynamic_params(0)))
+            .ok());
+    ASSERT_TRUE(store->MarkComplete(instance).ok());
+  }
+
+  // The runs of the kernels which completed are kept.
+  auto store = OpenOrDie();
+  EXPECT_FALSE(store->IsComplete(instance));
+  EXPECT_EQ(store->num_runs(), 1);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -49,14 +49,36 @@ class ScalarKernelArgValue : public KernelArgValue {
     kernel->setArg(arg_index, value());
   };
 
+  // Scalars always have a single element.
+  virtual void SetActiveSize(size_t size) override{};
+
   virtual void CopyToDevice(const cl::CommandQueue &queue,
                             ProfilingData *profiling) override{};
 
   virtual std::unique_ptr<KernelArgValue> CopyFromDevice(
       const cl::CommandQueue &queue, ProfilingData *profiling) override {
+    profiling->host_allocated_bytes += SizeInBytes();
     return std::make_unique<ScalarKernelArgValue>(value());
   }
 
+  virtual void CopyFromDeviceInto(const cl::CommandQueue &queue,
+                                  KernelArgValue *value,
+                                  ProfilingData *profiling) override {
+    auto output = dynamic_cast<ScalarKernelArgValue *>(value);
+    CHECK(output) << "Cannot copy scalar into a different value type";
+    output->value() = this->value();
+  }
+
+  virtual void EnqueueCopyToDevice(const cl::CommandQueue &queue,
+                                   ProfilingData *profiling) override{};
+
+  virtual void EnqueueCopyFromDeviceInto(const cl::CommandQueue &queue,
+                                         const std::vector<cl::Event> &events,
+                                         KernelArgValue *value,
+                                         ProfilingData *profiling) override {
+    CopyFromDeviceInto(queue, value, profiling);
+  }
+
   virtual string ToString() const override {
     return opencl_type::ToString(value());
   }
@@ -0,0 +1,242 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/server.h"
+
+#include "gpu/cldrive/delimited_util.h"
+#include "gpu/cldrive/libcldrive.h"
+#include "gpu/cldrive/logger.h"
+#include "gpu/cldrive/opencl_context_pool.h"
+#include "gpu/clinfo/libclinfo.h"
+
+#include "labm8/cpp/logging.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace gpu {
+namespace cldrive {
+
+namespace {
+
+// Write all of a buffer to a socket. Returns false if the peer has closed the
+// connection.
+bool WriteAll(int fd, const string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::send(fd, data.data() + written, data.size() - written,
+                       MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+CldriveServer::CldriveServer(const CldriveServerOptions& options)
+    : options_(options),
+      program_pool_(options.program_pool_size),
+      requests_(options.max_queue_size),
+      socket_fd_(-1),
+      shutting_down_(false),
+      num_requests_(0) {}
+
+CldriveServer::~CldriveServer() { Shutdown(); }
+
+labm8::Status CldriveServer::Start() {
+  CHECK(socket_fd_ < 0) << "Server already started";
+
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (options_.socket_path.empty() ||
+      options_.socket_path.size() >= sizeof(address.sun_path)) {
+    return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                         "Illegal socket path");
+  }
+  std::strncpy(address.sun_path, options_.socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+
+  // Warm up the contexts and queues of the devices, so that the first
+  // request does not pay for their creation.
+  for (const auto& device : options_.devices) {
+    try {
+      OpenClContextPool::Get().GetOrCreate(
+          labm8::gpu::clinfo::GetOpenClDevice(device));
+    } catch (std::invalid_argument e) {
+      return labm8::Status(labm8::error::Code::NOT_FOUND,
+                           "Device not found: " + device.name());
+    }
+  }
+
+  socket_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (socket_fd_ < 0) {
+    return labm8::Status(labm8::error::Code::INTERNAL,
+                         "Failed to create socket");
+  }
+  ::unlink(options_.socket_path.c_str());
+  if (::bind(socket_fd_, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) ||
+      ::listen(socket_fd_, SOMAXCONN)) {
+    const string error = std::strerror(errno);
+    ::close(socket_fd_);
+    socket_fd_ = -1;
+    return labm8::Status(
+        labm8::error::Code::INTERNAL,
+        "Failed to listen on '" + options_.socket_path + "': " + error);
+  }
+
+  for (int i = 0; i < options_.num_workers; ++i) {
+    worker_threads_.emplace_back(&CldriveServer::RunRequests, this);
+  }
+  accept_thread_ = std::thread(&CldriveServer::AcceptConnections, this);
+
+  LOG(INFO) << "Listening on " << options_.socket_path << " with "
+            << options_.num_workers << " worker(s)";
+  return labm8::Status::OK;
+}
+
+void CldriveServer::Shutdown() {
+  if (socket_fd_ < 0) {
+    return;
+  }
+
+  // Unblock the accept() and read() calls of the server threads.
+  {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    shutting_down_ = true;
+    ::shutdown(socket_fd_, SHUT_RDWR);
+    for (int fd : connection_fds_) {
+      ::shutdown(fd, SHUT_RDWR);
+    }
+  }
+  accept_thread_.join();
+
+  // The queued requests are run before the workers exit, so that no
+  // connection waits on a response which will never be produced.
+  requests_.Close();
+  for (auto& thread : worker_threads_) {
+    thread.join();
+  }
+  worker_threads_.clear();
+
+  {
+    std::unique_lock<std::mutex> lock(connections_mutex_);
+    connections_closed_.wait(lock, [this] { return connection_fds_.empty(); });
+  }
+
+  ::close(socket_fd_);
+  ::unlink(options_.socket_path.c_str());
+  socket_fd_ = -1;
+}
+
+void CldriveServer::AcceptConnections() {
+  while (true) {
+    int fd = ::accept(socket_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      // The listening socket has been shut down.
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    if (shutting_down_) {
+      ::close(fd);
+      return;
+    }
+    connection_fds_.insert(fd);
+    std::thread(&CldriveServer::ServeConnection, this, fd).detach();
+  }
+}
+
+void CldriveServer::ServeConnection(int fd) {
+  util::DelimitedReader reader(fd);
+  while (true) {
+    auto request = std::make_shared<Request>();
+    if (!reader.Next(&request->instance)) {
+      LOG_IF(WARNING, reader.error())
+          << "Malformed request, closing connection";
+      break;
+    }
+
+    std::future<string> response = request->response.get_future();
+    if (!requests_.Push(std::move(request))) {
+      // The server is shutting down.
+      break;
+    }
+    if (!WriteAll(fd, response.get())) {
+      break;
+    }
+  }
+
+  // Close the descriptor while holding the lock, so that Shutdown() never
+  // sees a descriptor number which has been reused by a new connection.
+  std::lock_guard<std::mutex> lock(connections_mutex_);
+  connection_fds_.erase(fd);
+  ::close(fd);
+  connections_closed_.notify_all();
+}
+
+void CldriveServer::RunRequests() {
+  std::shared_ptr<Request> request;
+  while (requests_.Pop(&request)) {
+    request->response.set_value(
+        RunRequest(&request->instance, num_requests_++));
+    request.reset();
+  }
+}
+
+string CldriveServer::RunRequest(CldriveInstance* instance, int instance_num) {
+  if (!instance->has_device() && !options_.devices.empty()) {
+    *instance->mutable_device() = options_.devices[0];
+  }
+  if (options_.mem_analysis_db && !instance->arg_bound_size()) {
+    options_.mem_analysis_db->Lookup(instance->opencl_src(), instance);
+  }
+
+  std::stringstream response;
+  CldriveInstances instances;
+  StreamingProtocolBufferLogger logger(response, &instances);
+  logger.StartNewInstance();
+
+  try {
+    labm8::gpu::clinfo::GetOpenClDevice(instance->device());
+  } catch (std::invalid_argument e) {
+    LOG(WARNING) << "Device not found: '" << instance->device().name() << "'";
+    instance->clear_outcome();
+    logger.RecordInstance(instance);
+    return response.str();
+  }
+
+  Cldrive(instance, instance_num, options_.program_cache, &program_pool_)
+      .RunOrDie(logger);
+  return response.str();
+}
+
+}  // namespace cldrive
+}  // namespace gpu
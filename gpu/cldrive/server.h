@@ -0,0 +1,123 @@
+// A long-lived cldrive server which runs instances sent over a socket.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/bounded_queue.h"
+#include "gpu/cldrive/mem_analysis_db.h"
+#include "gpu/cldrive/program_cache.h"
+#include "gpu/cldrive/program_pool.h"
+#include "gpu/cldrive/proto/cldrive.pb.h"
+#include "gpu/clinfo/proto/clinfo.pb.h"
+
+#include "labm8/cpp/status.h"
+#include "labm8/cpp/string.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+struct CldriveServerOptions {
+  // The path of the Unix domain socket to listen on. An existing file at this
+  // path is replaced.
+  string socket_path;
+  // The number of instances which are run concurrently. Instances which run
+  // concurrently on the same device perturb each other's timings.
+  int num_workers = 1;
+  // The maximum number of requests waiting for a worker. Once full, clients
+  // block until a worker is free.
+  int max_queue_size = 64;
+  // The maximum number of built programs kept in memory.
+  int program_pool_size = 256;
+  // The devices to create contexts for on startup. The first device is used
+  // for requests which do not specify a device.
+  std::vector<::gpu::clinfo::OpenClDevice> devices;
+  // Optional. If set, the compiled programs are loaded from and stored in
+  // this cache.
+  const ProgramCache* program_cache = nullptr;
+  // Optional. If set, the memory analysis of requests without argument
+  // bounds is looked up in this database.
+  const MemAnalysisDatabase* mem_analysis_db = nullptr;
+};
+
+// A server which accepts connections on a Unix domain socket and runs the
+// CldriveInstance requests of many clients, re-using the OpenCL contexts,
+// command queues, and built programs of previous requests.
+//
+// The protocol is a sequence of requests and responses on each connection.
+// A request is a length-delimited CldriveInstance message. The response is a
+// sequence of length-delimited CldriveLogRecord messages, in the format of
+// StreamingProtocolBufferLogger, ending with the record which has its
+// instance field set. Requests on a connection are run in order, so clients
+// which require concurrency open multiple connections.
+class CldriveServer {
+ public:
+  explicit CldriveServer(const CldriveServerOptions& options);
+
+  ~CldriveServer();
+
+  // Bind the socket and start accepting connections. Returns once the server
+  // is ready to accept connections.
+  labm8::Status Start();
+
+  // Stop accepting connections, close the open connections, and wait for the
+  // running requests to complete.
+  void Shutdown();
+
+ private:
+  struct Request {
+    CldriveInstance instance;
+    std::promise<string> response;
+  };
+
+  void AcceptConnections();
+
+  void ServeConnection(int fd);
+
+  void RunRequests();
+
+  // Run a request and return the serialized response.
+  string RunRequest(CldriveInstance* instance, int instance_num);
+
+  const CldriveServerOptions options_;
+  ProgramPool program_pool_;
+  BoundedQueue<std::shared_ptr<Request>> requests_;
+
+  int socket_fd_;
+  std::thread accept_thread_;
+  std::vector<std::thread> worker_threads_;
+
+  // The open connections, which are served by detached threads.
+  std::mutex connections_mutex_;
+  std::condition_variable connections_closed_;
+  std::set<int> connection_fds_;
+  bool shutting_down_;
+
+  // The number of requests received, used to number the instances.
+  std::atomic<int> num_requests_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,125 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/server.h"
+
+#include "gpu/cldrive/delimited_util.h"
+
+#include "labm8/cpp/logging.h"
+#include "labm8/cpp/test.h"
+
+#include "boost/filesystem.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+class CldriveServerTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    options_.socket_path =
+        (fs::temp_directory_path() /
+         fs::unique_path("cldrive_server_test_%%%%-%%%%-%%%%.sock"))
+            .string();
+  }
+
+  // Connect to the server, returning the socket.
+  int Connect() {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    CHECK(fd >= 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, options_.socket_path.c_str(),
+                 sizeof(address.sun_path) - 1);
+    CHECK(!::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                     sizeof(address)));
+    return fd;
+  }
+
+  void SendRequest(int fd, const CldriveInstance& instance) {
+    std::stringstream request;
+    CHECK(util::WriteDelimited(instance, &request));
+    const string bytes = request.str();
+    CHECK(::write(fd, bytes.data(), bytes.size()) == bytes.size());
+  }
+
+  CldriveServerOptions options_;
+};
+
+CldriveInstance MakeInstanceOnUnknownDevice() {
+  CldriveInstance instance;
+  instance.mutable_device()->set_name("not a real device");
+  instance.set_opencl_src("kernel void A(global int* a) {}");
+  return instance;
+}
+
+TEST_F(CldriveServerTest, StartWithIllegalSocketPath) {
+  options_.socket_path = "";
+  CldriveServer server(options_);
+  EXPECT_FALSE(server.Start().ok());
+}
+
+TEST_F(CldriveServerTest, RespondsToRequestsInOrder) {
+  CldriveServer server(options_);
+  ASSERT_TRUE(server.Start().ok());
+
+  int fd = Connect();
+  SendRequest(fd, MakeInstanceOnUnknownDevice());
+  SendRequest(fd, MakeInstanceOnUnknownDevice());
+
+  // A request on an unknown device has a single record, with an error
+  // outcome.
+  util::DelimitedReader reader(fd);
+  CldriveLogRecord record;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(reader.Next(&record));
+    ASSERT_TRUE(record.has_instance());
+    EXPECT_EQ(record.device_name(), "not a real device");
+    EXPECT_EQ(record.instance().outcome(), CldriveInstance::UNKNOWN_ERROR);
+  }
+
+  ::close(fd);
+  server.Shutdown();
+}
+
+TEST_F(CldriveServerTest, ShutdownClosesConnections) {
+  CldriveServer server(options_);
+  ASSERT_TRUE(server.Start().ok());
+
+  int fd = Connect();
+  server.Shutdown();
+
+  util::DelimitedReader reader(fd);
+  CldriveLogRecord record;
+  EXPECT_FALSE(reader.Next(&record));
+  EXPECT_FALSE(fs::exists(options_.socket_path));
+  ::close(fd);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,86 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/shard_util.h"
+
+#include "gpu/cldrive/hash_util.h"
+
+#include "absl/strings/str_format.h"
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+int JumpConsistentHash(labm8::uint64 key, int num_buckets) {
+  labm8::int64 bucket = -1;
+  labm8::int64 next = 0;
+  while (next < num_buckets) {
+    bucket = next;
+    key = key * 2862933555777941757ULL + 1;
+    next = (bucket + 1) * (static_cast<double>(1LL << 31) /
+                           static_cast<double>((key >> 33) + 1));
+  }
+  return static_cast<int>(bucket);
+}
+
+int GetShard(const string& opencl_src, int num_shards) {
+  Fnv1aHash hash;
+  hash.AddField(opencl_src);
+  return JumpConsistentHash(hash.hash(), num_shards);
+}
+
+int GetShard(const string& opencl_src, int global_size, int local_size,
+             int num_shards) {
+  Fnv1aHash hash;
+  hash.AddField(opencl_src);
+  hash.AddField(std::to_string(global_size));
+  hash.AddField(std::to_string(local_size));
+  return JumpConsistentHash(hash.hash(), num_shards);
+}
+
+labm8::Status ValidateShard(int shard_index, int num_shards) {
+  if (num_shards < 1 || shard_index < 0 || shard_index >= num_shards) {
+    return labm8::Status(
+        labm8::error::Code::INVALID_ARGUMENT,
+        absl::StrFormat("Shard index %d is not in the range [0, %d)",
+                        shard_index, num_shards));
+  }
+  return labm8::Status::OK;
+}
+
+bool ShardDynamicParams(int shard_index, int num_shards,
+                        CldriveInstance* instance) {
+  if (num_shards == 1) {
+    return true;
+  }
+  instance->set_shard_index(shard_index);
+  if (!instance->dynamic_params_size()) {
+    return GetShard(instance->opencl_src(), num_shards) == shard_index;
+  }
+
+  google::protobuf::RepeatedPtrField<DynamicParams> dynamic_params;
+  for (const auto& params : instance->dynamic_params()) {
+    if (GetShard(instance->opencl_src(), params.global_size_x(),
+                 params.local_size_x(), num_shards) == shard_index) {
+      *dynamic_params.Add() = params;
+    }
+  }
+  instance->mutable_dynamic_params()->Swap(&dynamic_params);
+  return instance->dynamic_params_size() > 0;
+}
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
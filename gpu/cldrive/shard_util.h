@@ -0,0 +1,57 @@
+// Utility code for sharding kernels and launch configs across processes.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/cldrive/proto/cldrive.pb.h"
+
+#include "labm8/cpp/port.h"
+#include "labm8/cpp/status.h"
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// Return the bucket of a key in [0, num_buckets), using the jump consistent
+// hash of Lamping and Veach. When the number of buckets grows from n to n + 1,
+// only 1 / (n + 1) of the keys move, all of them to the new bucket.
+int JumpConsistentHash(labm8::uint64 key, int num_buckets);
+
+// Return the shard of an OpenCL source in [0, num_shards). The shard depends
+// only on the content of the source, so it is stable as sources are added to
+// or removed from a corpus, and across hosts and releases.
+int GetShard(const string& opencl_src, int num_shards);
+
+// Return the shard of an OpenCL source driven with a launch config.
+int GetShard(const string& opencl_src, int global_size, int local_size,
+             int num_shards);
+
+// Return an error if the shard index is not in [0, num_shards).
+labm8::Status ValidateShard(int shard_index, int num_shards);
+
+// Remove the dynamic params of an instance which are not in the given shard.
+// If there is more than one shard, the shard_index field of the instance is
+// set. Returns false if no part of the instance is in the shard, in which
+// case it should not be run. An instance without dynamic params is sharded by
+// its source alone.
+bool ShardDynamicParams(int shard_index, int num_shards,
+                        CldriveInstance* instance);
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,115 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/shard_util.h"
+
+#include "labm8/cpp/test.h"
+
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+namespace {
+
+TEST(JumpConsistentHash, SingleBucket) {
+  for (labm8::uint64 key = 0; key < 100; ++key) {
+    EXPECT_EQ(JumpConsistentHash(key, 1), 0);
+  }
+}
+
+TEST(JumpConsistentHash, KeysOnlyMoveToNewBucket) {
+  for (labm8::uint64 key = 0; key < 1000; ++key) {
+    const int bucket = JumpConsistentHash(key, 7);
+    const int new_bucket = JumpConsistentHash(key, 8);
+    EXPECT_TRUE(new_bucket == bucket || new_bucket == 7);
+  }
+}
+
+TEST(GetShard, ShardsAreBalanced) {
+  std::vector<int> counts(4, 0);
+  for (int i = 0; i < 4000; ++i) {
+    const string src = "kernel void A" + std::to_string(i) + "() {}";
+    ++counts[GetShard(src, 1024, 128, 4)];
+  }
+  for (int count : counts) {
+    EXPECT_GT(count, 800);
+    EXPECT_LT(count, 1200);
+  }
+}
+
+TEST(GetShard, ShardIsStable) {
+  EXPECT_EQ(GetShard("kernel void A() {}", 1024, 128, 4),
+            GetShard("kernel void A() {}", 1024, 128, 4));
+}
+
+TEST(ValidateShard, ShardInRange) {
+  EXPECT_TRUE(ValidateShard(0, 1).ok());
+  EXPECT_TRUE(ValidateShard(3, 4).ok());
+}
+
+TEST(ValidateShard, ShardOutOfRange) {
+  EXPECT_FALSE(ValidateShard(1, 1).ok());
+  EXPECT_FALSE(ValidateShard(-1, 4).ok());
+  EXPECT_FALSE(ValidateShard(0, 0).ok());
+}
+
+TEST(ShardDynamicParams, SingleShardIsUnchanged) {
+  CldriveInstance instance;
+  instance.add_dynamic_params()->set_global_size_x(1024);
+  EXPECT_TRUE(ShardDynamicParams(0, 1, &instance));
+  EXPECT_EQ(instance.dynamic_params_size(), 1);
+  EXPECT_FALSE(instance.has_shard_index());
+}
+
+TEST(ShardDynamicParams, EveryDynamicParamsIsInExactlyOneShard) {
+  CldriveInstance instance;
+  instance.set_opencl_src("kernel void A() {}");
+  for (int i = 1; i <= 32; ++i) {
+    DynamicParams* dynamic_params = instance.add_dynamic_params();
+    dynamic_params->set_global_size_x(1024 * i);
+    dynamic_params->set_local_size_x(128);
+  }
+
+  int num_dynamic_params = 0;
+  for (int shard_index = 0; shard_index < 3; ++shard_index) {
+    CldriveInstance shard = instance;
+    if (ShardDynamicParams(shard_index, 3, &shard)) {
+      EXPECT_EQ(shard.shard_index(), shard_index);
+      num_dynamic_params += shard.dynamic_params_size();
+    } else {
+      EXPECT_EQ(shard.dynamic_params_size(), 0);
+    }
+  }
+  EXPECT_EQ(num_dynamic_params, 32);
+}
+
+TEST(ShardDynamicParams, InstanceWithoutDynamicParamsIsInOneShard) {
+  CldriveInstance instance;
+  instance.set_opencl_src("kernel void A() {}");
+  int num_shards_run = 0;
+  for (int shard_index = 0; shard_index < 3; ++shard_index) {
+    CldriveInstance shard = instance;
+    num_shards_run += ShardDynamicParams(shard_index, 3, &shard);
+  }
+  EXPECT_EQ(num_shards_run, 1);
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -0,0 +1,111 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/statistics.h"
+
+#include "labm8/cpp/logging.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+namespace {
+
+// The z score of a two-sided 95% confidence interval.
+constexpr double kZScore = 1.96;
+
+// Return the p-th percentile of a sorted sample, interpolating between the
+// closest order statistics.
+template <typename T>
+double Percentile(const std::vector<T>& sorted_sample, double p) {
+  const double rank = p / 100 * (sorted_sample.size() - 1);
+  const size_t lower = static_cast<size_t>(std::floor(rank));
+  const size_t upper = static_cast<size_t>(std::ceil(rank));
+  return sorted_sample[lower] +
+         (rank - lower) * (sorted_sample[upper] - sorted_sample[lower]);
+}
+
+}  // anonymous namespace
+
+double MedianConfidenceInterval::RelativeWidth() const {
+  if (upper == lower) {
+    return 0;
+  }
+  return (upper - lower) / std::abs(median);
+}
+
+MedianConfidenceInterval GetMedianConfidenceInterval(
+    std::vector<labm8::int64> sample) {
+  CHECK(!sample.empty()) << "Cannot compute the median of an empty sample";
+  std::sort(sample.begin(), sample.end());
+
+  const int n = sample.size();
+  MedianConfidenceInterval interval;
+  if (n % 2) {
+    interval.median = sample[n / 2];
+  } else {
+    interval.median = (sample[n / 2 - 1] + sample[n / 2]) / 2.0;
+  }
+
+  // The 1-based ranks of the order statistics which bound the interval.
+  const double half_width = kZScore * std::sqrt(n) / 2;
+  int lower_rank = static_cast<int>(std::floor(n / 2.0 - half_width));
+  int upper_rank = static_cast<int>(std::ceil(1 + n / 2.0 + half_width));
+  lower_rank = std::max(lower_rank, 1);
+  upper_rank = std::min(upper_rank, n);
+
+  interval.lower = sample[lower_rank - 1];
+  interval.upper = sample[upper_rank - 1];
+  return interval;
+}
+
+SummaryStatistics GetSummaryStatistics(std::vector<labm8::int64> sample) {
+  CHECK(!sample.empty()) << "Cannot summarize an empty sample";
+  std::sort(sample.begin(), sample.end());
+
+  SummaryStatistics stats;
+  stats.count = sample.size();
+  stats.min = sample.front();
+  stats.max = sample.back();
+  stats.median = Percentile(sample, 50);
+  stats.p5 = Percentile(sample, 5);
+  stats.p95 = Percentile(sample, 95);
+
+  double sum = 0;
+  for (auto value : sample) {
+    sum += value;
+  }
+  stats.mean = sum / stats.count;
+
+  double sum_of_squares = 0;
+  std::vector<double> deviations;
+  deviations.reserve(sample.size());
+  for (auto value : sample) {
+    sum_of_squares += (value - stats.mean) * (value - stats.mean);
+    deviations.push_back(std::abs(value - stats.median));
+  }
+  stats.stddev = std::sqrt(sum_of_squares / stats.count);
+
+  std::sort(deviations.begin(), deviations.end());
+  stats.mad = Percentile(deviations, 50);
+  return stats;
+}
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
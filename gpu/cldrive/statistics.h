@@ -0,0 +1,70 @@
+// Summary statistics of kernel timings.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/port.h"
+
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+
+// The median of a sample, and a confidence interval of the median.
+struct MedianConfidenceInterval {
+  double median;
+  double lower;
+  double upper;
+
+  // The width of the interval relative to the median. Returns zero for an
+  // empty interval.
+  double RelativeWidth() const;
+};
+
+// Compute a distribution-free 95% confidence interval of the median of a
+// sample. The bounds are order statistics of the sample, chosen using the
+// normal approximation to the binomial distribution, so no assumption is made
+// about the distribution of the sample. For small samples the interval spans
+// the entire range of the sample. The sample must not be empty.
+MedianConfidenceInterval GetMedianConfidenceInterval(
+    std::vector<labm8::int64> sample);
+
+// Summary statistics of a sample.
+struct SummaryStatistics {
+  labm8::int64 count;
+  double min;
+  double max;
+  double mean;
+  double median;
+  // The 5th and 95th percentiles.
+  double p5;
+  double p95;
+  // The population standard deviation.
+  double stddev;
+  // The median absolute deviation from the median.
+  double mad;
+};
+
+// Compute summary statistics of a sample. Percentiles are interpolated
+// linearly between the closest order statistics, so the median and
+// percentiles match numpy's defaults. The sample must not be empty.
+SummaryStatistics GetSummaryStatistics(std::vector<labm8::int64> sample);
+
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
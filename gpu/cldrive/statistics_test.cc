@@ -0,0 +1,132 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/statistics.h"
+
+#include "labm8/cpp/test.h"
+
+#include <cmath>
+
+namespace gpu {
+namespace cldrive {
+namespace util {
+namespace {
+
+TEST(GetMedianConfidenceInterval, SingleElement) {
+  auto interval = GetMedianConfidenceInterval({5});
+  EXPECT_EQ(interval.median, 5);
+  EXPECT_EQ(interval.lower, 5);
+  EXPECT_EQ(interval.upper, 5);
+  EXPECT_EQ(interval.RelativeWidth(), 0);
+}
+
+TEST(GetMedianConfidenceInterval, OddMedian) {
+  auto interval = GetMedianConfidenceInterval({3, 1, 2});
+  EXPECT_EQ(interval.median, 2);
+}
+
+TEST(GetMedianConfidenceInterval, EvenMedian) {
+  auto interval = GetMedianConfidenceInterval({4, 1, 3, 2});
+  EXPECT_EQ(interval.median, 2.5);
+}
+
+TEST(GetMedianConfidenceInterval, SmallSampleSpansRange) {
+  auto interval = GetMedianConfidenceInterval({10, 50, 20, 40, 30});
+  EXPECT_EQ(interval.lower, 10);
+  EXPECT_EQ(interval.upper, 50);
+  EXPECT_DOUBLE_EQ(interval.RelativeWidth(), 40.0 / 30);
+}
+
+TEST(GetMedianConfidenceInterval, LargeSampleExcludesTails) {
+  std::vector<labm8::int64> sample;
+  for (int i = 1; i <= 100; ++i) {
+    sample.push_back(i);
+  }
+  auto interval = GetMedianConfidenceInterval(sample);
+  EXPECT_EQ(interval.median, 50.5);
+  EXPECT_EQ(interval.lower, 40);
+  EXPECT_EQ(interval.upper, 61);
+}
+
+TEST(GetMedianConfidenceInterval, ConstantSampleHasZeroWidth) {
+  auto interval = GetMedianConfidenceInterval(
+      std::vector<labm8::int64>(30, 1000));
+  EXPECT_EQ(interval.RelativeWidth(), 0);
+}
+
+TEST(GetMedianConfidenceInterval, NarrowsWithSampleSize) {
+  std::vector<labm8::int64> sample;
+  double previous_width = 0;
+  for (int n = 0; n < 200; ++n) {
+    sample.push_back(1000 + (n * 37) % 100);
+    if (n == 19) {
+      previous_width = GetMedianConfidenceInterval(sample).RelativeWidth();
+    }
+  }
+  EXPECT_LT(GetMedianConfidenceInterval(sample).RelativeWidth(),
+            previous_width);
+}
+
+TEST(GetSummaryStatistics, SingleElement) {
+  auto stats = GetSummaryStatistics({5});
+  EXPECT_EQ(stats.count, 1);
+  EXPECT_EQ(stats.min, 5);
+  EXPECT_EQ(stats.max, 5);
+  EXPECT_EQ(stats.mean, 5);
+  EXPECT_EQ(stats.median, 5);
+  EXPECT_EQ(stats.p5, 5);
+  EXPECT_EQ(stats.p95, 5);
+  EXPECT_EQ(stats.stddev, 0);
+  EXPECT_EQ(stats.mad, 0);
+}
+
+TEST(GetSummaryStatistics, UnsortedSample) {
+  auto stats = GetSummaryStatistics({4, 1, 3, 2});
+  EXPECT_EQ(stats.count, 4);
+  EXPECT_EQ(stats.min, 1);
+  EXPECT_EQ(stats.max, 4);
+  EXPECT_EQ(stats.mean, 2.5);
+  EXPECT_EQ(stats.median, 2.5);
+  EXPECT_DOUBLE_EQ(stats.stddev, std::sqrt(1.25));
+  EXPECT_EQ(stats.mad, 1);
+}
+
+TEST(GetSummaryStatistics, PercentilesInterpolate) {
+  std::vector<labm8::int64> sample;
+  for (int i = 0; i <= 100; ++i) {
+    sample.push_back(i * 10);
+  }
+  auto stats = GetSummaryStatistics(sample);
+  EXPECT_DOUBLE_EQ(stats.p5, 50);
+  EXPECT_DOUBLE_EQ(stats.p95, 950);
+
+  stats = GetSummaryStatistics({0, 100});
+  EXPECT_DOUBLE_EQ(stats.p5, 5);
+  EXPECT_DOUBLE_EQ(stats.p95, 95);
+}
+
+TEST(GetSummaryStatistics, MadIgnoresOutliers) {
+  auto stats = GetSummaryStatistics({10, 11, 9, 10, 1000});
+  EXPECT_EQ(stats.median, 10);
+  EXPECT_EQ(stats.mad, 1);
+  EXPECT_GT(stats.stddev, 100);
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -15,6 +15,8 @@
 // along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/cldrive/testutil.h"
 
+#include "gpu/cldrive/opencl_util.h"
+
 namespace gpu {
 namespace cldrive {
 namespace test {
@@ -24,8 +26,7 @@ cl::Kernel CreateClKernel(const string& opencl_kernel) {
     cl::Program program(opencl_kernel);
     program.build("-cl-kernel-arg-info");
 
-    std::vector<cl::Kernel> kernels;
-    program.createKernels(&kernels);
+    std::vector<cl::Kernel> kernels = util::CreateKernels(program);
     CHECK(kernels.size() == 1);
     return kernels[0];
   } catch (cl::Error err) {
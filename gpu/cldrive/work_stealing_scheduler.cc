@@ -0,0 +1,72 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/work_stealing_scheduler.h"
+
+#include "labm8/cpp/logging.h"
+
+namespace gpu {
+namespace cldrive {
+
+WorkStealingScheduler::WorkStealingScheduler(size_t num_items,
+                                             size_t num_workers) {
+  CHECK(num_workers > 0) << "Scheduler requires at least one worker";
+  for (size_t i = 0; i < num_workers; ++i) {
+    ranges_.push_back(
+        {num_items * i / num_workers, num_items * (i + 1) / num_workers});
+  }
+}
+
+bool WorkStealingScheduler::Next(size_t worker, size_t* item, bool* stolen) {
+  labm8::MutexLock lock(&mutex_);
+  CHECK(worker < ranges_.size()) << "Worker " << worker << " out of range";
+
+  Range& own = ranges_[worker];
+  if (own.begin < own.end) {
+    *item = own.begin++;
+    if (stolen) {
+      *stolen = false;
+    }
+    return true;
+  }
+
+  Range* victim = nullptr;
+  for (auto& range : ranges_) {
+    if (range.end - range.begin > 0 &&
+        (!victim || range.end - range.begin > victim->end - victim->begin)) {
+      victim = &range;
+    }
+  }
+  if (!victim) {
+    return false;
+  }
+  *item = --victim->end;
+  if (stolen) {
+    *stolen = true;
+  }
+  return true;
+}
+
+size_t WorkStealingScheduler::remaining() const {
+  labm8::MutexLock lock(&mutex_);
+  size_t remaining = 0;
+  for (const auto& range : ranges_) {
+    remaining += range.end - range.begin;
+  }
+  return remaining;
+}
+
+}  // namespace cldrive
+}  // namespace gpu
@@ -0,0 +1,54 @@
+// Distribute a list of items over a set of workers with work stealing.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/mutex.h"
+
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+
+// Distributes the items [0, num_items) over a fixed number of workers. The
+// items are divided into contiguous ranges, one per worker, and each worker
+// takes items from the front of its own range. A worker whose range is
+// exhausted steals from the back of the range with the most items remaining,
+// so that fast workers are not left idle while slow workers finish.
+class WorkStealingScheduler {
+ public:
+  WorkStealingScheduler(size_t num_items, size_t num_workers);
+
+  // Get the next item for a worker, and whether it was stolen from another
+  // worker. Returns false once every item has been taken.
+  bool Next(size_t worker, size_t* item, bool* stolen = nullptr);
+
+  // Return the number of items which have not been taken.
+  size_t remaining() const;
+
+ private:
+  struct Range {
+    size_t begin;
+    size_t end;
+  };
+
+  mutable labm8::Mutex mutex_;
+  std::vector<Range> ranges_;
+};
+
+}  // namespace cldrive
+}  // namespace gpu
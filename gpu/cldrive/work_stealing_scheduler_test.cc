@@ -0,0 +1,115 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of cldrive.
+//
+// cldrive is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// cldrive is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with cldrive.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/cldrive/work_stealing_scheduler.h"
+
+#include "labm8/cpp/test.h"
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace gpu {
+namespace cldrive {
+namespace {
+
+TEST(WorkStealingScheduler, WorkersTakeTheirOwnRangesInOrder) {
+  WorkStealingScheduler scheduler(4, 2);
+  size_t item;
+  bool stolen;
+  ASSERT_TRUE(scheduler.Next(0, &item, &stolen));
+  EXPECT_EQ(item, 0);
+  EXPECT_FALSE(stolen);
+  ASSERT_TRUE(scheduler.Next(1, &item, &stolen));
+  EXPECT_EQ(item, 2);
+  EXPECT_FALSE(stolen);
+  ASSERT_TRUE(scheduler.Next(0, &item, &stolen));
+  EXPECT_EQ(item, 1);
+  EXPECT_EQ(scheduler.remaining(), 1);
+}
+
+TEST(WorkStealingScheduler, IdleWorkerStealsFromTheBack) {
+  WorkStealingScheduler scheduler(6, 3);
+  size_t item;
+  bool stolen;
+  // Exhaust worker 0's range, and take one item of worker 1's.
+  ASSERT_TRUE(scheduler.Next(0, &item));
+  ASSERT_TRUE(scheduler.Next(0, &item));
+  ASSERT_TRUE(scheduler.Next(1, &item));
+  EXPECT_EQ(item, 2);
+
+  // Worker 2 has the most items remaining.
+  ASSERT_TRUE(scheduler.Next(0, &item, &stolen));
+  EXPECT_EQ(item, 5);
+  EXPECT_TRUE(stolen);
+  ASSERT_TRUE(scheduler.Next(0, &item, &stolen));
+  EXPECT_TRUE(stolen);
+  ASSERT_TRUE(scheduler.Next(0, &item, &stolen));
+  EXPECT_TRUE(stolen);
+  EXPECT_FALSE(scheduler.Next(0, &item));
+  EXPECT_FALSE(scheduler.Next(1, &item));
+  EXPECT_FALSE(scheduler.Next(2, &item));
+}
+
+TEST(WorkStealingScheduler, MoreWorkersThanItems) {
+  WorkStealingScheduler scheduler(1, 4);
+  size_t item;
+  ASSERT_TRUE(scheduler.Next(3, &item));
+  EXPECT_EQ(item, 0);
+  EXPECT_FALSE(scheduler.Next(0, &item));
+}
+
+TEST(WorkStealingScheduler, EveryItemTakenOnceByConcurrentWorkers) {
+  const size_t num_items = 10000;
+  WorkStealingScheduler scheduler(num_items, 4);
+  std::vector<std::vector<size_t>> taken(4);
+  std::atomic<int> num_stolen(0);
+
+  std::vector<std::thread> workers;
+  for (size_t worker = 0; worker < 4; ++worker) {
+    workers.emplace_back([&, worker]() {
+      size_t item;
+      bool stolen;
+      while (scheduler.Next(worker, &item, &stolen)) {
+        taken[worker].push_back(item);
+        num_stolen += stolen;
+        // Worker 0 is slow, so the others must steal its items.
+        if (!worker) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::set<size_t> items;
+  for (const auto& worker_items : taken) {
+    items.insert(worker_items.begin(), worker_items.end());
+  }
+  EXPECT_EQ(items.size(), num_items);
+  EXPECT_EQ(*items.rbegin(), num_items - 1);
+  EXPECT_GT(num_stolen, 0);
+  EXPECT_LT(taken[0].size(), num_items / 4);
+}
+
+}  // anonymous namespace
+}  // namespace cldrive
+}  // namespace gpu
+
+TEST_MAIN();
@@ -20,6 +20,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "gpu/clinfo/libclinfo.h"
@@ -270,8 +271,11 @@ void SetOpenClDevice(const cl::Platform& platform, const cl::Device& device,
   message->set_device_id(device_id);
 }
 
-::gpu::clinfo::OpenClDevices GetOpenClDevices() {
-  ::gpu::clinfo::OpenClDevices message;
+namespace {
+
+// Enumerate the available OpenCL devices, as protos and as device handles.
+void EnumerateOpenClDevices(::gpu::clinfo::OpenClDevices* message,
+                            std::vector<cl::Device>* handles) {
   std::vector<cl::Platform> platforms;
 
   try {
@@ -283,7 +287,7 @@ void SetOpenClDevice(const cl::Platform& platform, const cl::Device& device,
     if (strcmp(err.what(), "clGetPlatformIDs") == 0 &&
         strcmp(labm8::gpu::clinfo::OpenClErrorString(err.err()),
                "CL_PLATFORM_NOT_FOUND_KHR") == 0) {
-      return message;
+      return;
     }
     throw err;
   }
@@ -295,110 +299,122 @@ void SetOpenClDevice(const cl::Platform& platform, const cl::Device& device,
     int device_id = 0;
     for (const auto& device : devices) {
       labm8::gpu::clinfo::SetOpenClDevice(platform, device, platform_id,
-                                          device_id, message.add_device());
+                                          device_id, message->add_device());
+      handles->push_back(device);
       ++device_id;
     }
     ++platform_id;
   }
-  return message;
+}
+
+// The fields which identify a device proto, as used by
+// GetOpenClDevice(const OpenClDevice&).
+string GetDeviceProtoKey(const ::gpu::clinfo::OpenClDevice& device) {
+  string key = device.platform_name();
+  key.push_back('\0');
+  key.append(device.device_name());
+  key.push_back('\0');
+  key.append(device.driver_version());
+  return key;
+}
+
+// A process-wide registry of the available OpenCL devices. The platforms are
+// enumerated once, on first use, after which lookups by name or by proto are
+// constant time. The registry is immutable once constructed, so it may be
+// used concurrently.
+class OpenClDeviceRegistry {
+ public:
+  static const OpenClDeviceRegistry& Get() {
+    // Initialization of function-local statics is thread-safe. The registry
+    // is intentionally leaked so that the device handles are not released
+    // after the OpenCL implementation has been unloaded at process exit.
+    static const OpenClDeviceRegistry* registry = new OpenClDeviceRegistry();
+    return *registry;
+  }
+
+  const ::gpu::clinfo::OpenClDevices& devices() const { return devices_; }
+
+  const cl::Device& handle(int index) const { return handles_[index]; }
+
+  // Return the index of a device, or -1 if not found.
+  int FindByName(const string& name) const {
+    auto it = name_index_.find(name);
+    return it == name_index_.end() ? -1 : it->second;
+  }
+
+  int FindByProto(const ::gpu::clinfo::OpenClDevice& device) const {
+    auto it = proto_index_.find(GetDeviceProtoKey(device));
+    return it == proto_index_.end() ? -1 : it->second;
+  }
+
+ private:
+  OpenClDeviceRegistry() {
+    EnumerateOpenClDevices(&devices_, &handles_);
+    // If multiple devices share a key, the first is used, as per a linear
+    // search of the enumerated devices.
+    for (int i = 0; i < devices_.device_size(); ++i) {
+      name_index_.emplace(devices_.device(i).name(), i);
+      proto_index_.emplace(GetDeviceProtoKey(devices_.device(i)), i);
+    }
+  }
+
+  ::gpu::clinfo::OpenClDevices devices_;
+  std::vector<cl::Device> handles_;
+  std::unordered_map<string, int> name_index_;
+  std::unordered_map<string, int> proto_index_;
+};
+
+}  // anonymous namespace
+
+::gpu::clinfo::OpenClDevices GetOpenClDevices() {
+  return OpenClDeviceRegistry::Get().devices();
 }
 
 ::gpu::clinfo::OpenClDevice GetOpenClDevice(const int platform_id,
                                             const int device_id) {
-  ::gpu::clinfo::OpenClDevice message;
-  std::vector<cl::Platform> platforms;
-  cl::Platform::get(&platforms);
-  std::vector<cl::Device> devices;
-  int cur_platform = 0;
-  for (const auto& platform : platforms) {
-    if (cur_platform == platform_id) {
-      platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
-      int cur_device = 0;
-      for (const auto& device : devices) {
-        if (cur_device == device_id) {
-          labm8::gpu::clinfo::SetOpenClDevice(platform, device, cur_platform,
-                                              cur_device, &message);
-          return message;
-        }
-        ++cur_device;
-      }
+  const auto& devices = OpenClDeviceRegistry::Get().devices();
+  for (int i = 0; i < devices.device_size(); ++i) {
+    if (devices.device(i).platform_id() == platform_id &&
+        devices.device(i).device_id() == device_id) {
+      return devices.device(i);
     }
-    ++cur_platform;
   }
   throw std::invalid_argument("Platform and device ID not found");
 }
 
 StatusOr<::gpu::clinfo::OpenClDevice> GetOpenClDeviceProto(const string& name) {
-  auto devices = GetOpenClDevices();
-
-  for (int i = 0; i < devices.device_size(); ++i) {
-    if (!devices.device(i).name().compare(name)) {
-      return devices.device(i);
-    }
+  const auto& registry = OpenClDeviceRegistry::Get();
+  int index = registry.FindByName(name);
+  if (index >= 0) {
+    return registry.devices().device(index);
   }
 
   return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
                        "OpenCL device not found");
 }
 
-namespace {
-
-// Workaround for a defect in which getInfo<>() methods return strings
-// including terminating '\0' character. See discussion at:
-// https://github.com/KhronosGroup/OpenCL-CLHPP/issues/8
-void StripTrailingNullCharacter(string* str) {
-  if (!str->empty() && str->back() == '\0') {
-    str->resize(str->size() - 1);
-  }
-}
-
-}  // anonymous namespace
-
 cl::Device GetOpenClDevice(const ::gpu::clinfo::OpenClDevice& device_proto) {
-  string platform_name, device_name, driver_version, opencl_version;
-
-  std::vector<cl::Platform> platforms;
-  cl::Platform::get(&platforms);
-  for (const auto& platform : platforms) {
-    platform.getInfo(CL_PLATFORM_NAME, &platform_name);
-    StripTrailingNullCharacter(&platform_name);
-    if (platform_name.compare(device_proto.platform_name())) {
-      continue;
-    }
-
-    std::vector<cl::Device> devices;
-    platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
-    for (const auto& device : devices) {
-      device.getInfo(CL_DEVICE_NAME, &device_name);
-      StripTrailingNullCharacter(&device_name);
-      if (device_name.compare(device_proto.device_name())) {
-        continue;
-      }
-
-      device.getInfo(CL_DRIVER_VERSION, &driver_version);
-      StripTrailingNullCharacter(&driver_version);
-      if (driver_version.compare(device_proto.driver_version())) {
-        continue;
-      }
-
-      return device;
-    }
+  const auto& registry = OpenClDeviceRegistry::Get();
+  int index = registry.FindByProto(device_proto);
+  if (index >= 0) {
+    return registry.handle(index);
   }
 
   throw std::invalid_argument("Device not found");
 }
 
 cl::Device GetDefaultOpenClDeviceOrDie() {
-  auto devices = GetOpenClDevices();
+  const auto& registry = OpenClDeviceRegistry::Get();
+  const auto& devices = registry.devices();
 
   for (int i = 0; i < devices.device_size(); ++i) {
     if (!devices.device(i).platform_name().compare("Oclgrind")) {
-      return GetOpenClDeviceOrDie(devices.device(i));
+      return registry.handle(i);
     }
   }
 
   CHECK(devices.device_size()) << "No OpenCL devices found!";
-  return GetOpenClDeviceOrDie(devices.device(0));
+  return registry.handle(0);
 }
 
 // Lookup an OpenCL device by proto or die.
@@ -412,12 +428,10 @@ cl::Device GetOpenClDeviceOrDie(const ::gpu::clinfo::OpenClDevice& device) {
 }
 
 cl::Device GetOpenClDevice(const string& name) {
-  auto devices = GetOpenClDevices();
-
-  for (int i = 0; i < devices.device_size(); ++i) {
-    if (!devices.device(i).name().compare(name)) {
-      return GetOpenClDeviceOrDie(devices.device(i));
-    }
+  const auto& registry = OpenClDeviceRegistry::Get();
+  int index = registry.FindByName(name);
+  if (index >= 0) {
+    return registry.handle(index);
   }
 
   throw std::invalid_argument("Device not found");
@@ -40,6 +40,10 @@ void SetOpenClDevice(const cl::Platform& platform, const cl::Device& device,
                      const int platform_id, const int device_id,
                      ::gpu::clinfo::OpenClDevice* const message);
 
+// Return the available OpenCL devices. The devices are enumerated once per
+// process, on the first call to any of the device lookup functions below,
+// after which lookups by name or by proto do not rescan the platforms.
+// Devices which become available after the first call are not found.
 ::gpu::clinfo::OpenClDevices GetOpenClDevices();
 
 ::gpu::clinfo::OpenClDevice GetOpenClDevice(const int platform_id,
@@ -0,0 +1,295 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/access_tracking.h"
+
+#include <cctype>
+#include <vector>
+
+namespace gpu {
+namespace clmem {
+namespace util {
+
+const char* const kAccessRangesArgName = "clmem_access_ranges";
+
+namespace {
+
+// Prepended to instrumented programs. The #line directive keeps the line
+// numbers of compiler diagnostics the same as in the original source.
+const char* const kInstrumentationPrelude = R"(
+#define CLMEM_ACCESS(arg, index) \
+  clmem_access(clmem_access_ranges, (arg), (index))
+long clmem_access(global int* ranges, int arg, long index) {
+  atomic_min(&ranges[2 * arg], (int)index);
+  atomic_max(&ranges[2 * arg + 1], (int)index);
+  return index;
+}
+#line 1
+)";
+
+bool IsIdentifierChar(char c) { return std::isalnum(c) || c == '_'; }
+
+// Return a copy of the source with comments and string and character
+// literals replaced by spaces, so that it can be scanned for code without
+// changing any offsets.
+string MaskCommentsAndLiterals(const string& src) {
+  string masked = src;
+  size_t i = 0;
+  while (i < src.size()) {
+    if (!src.compare(i, 2, "//")) {
+      while (i < src.size() && src[i] != '\n') {
+        masked[i++] = ' ';
+      }
+    } else if (!src.compare(i, 2, "/*")) {
+      size_t end = src.find("*/", i + 2);
+      end = end == string::npos ? src.size() : end + 2;
+      for (; i < end; ++i) {
+        if (src[i] != '\n') {
+          masked[i] = ' ';
+        }
+      }
+    } else if (src[i] == '"' || src[i] == '\'') {
+      const char quote = src[i];
+      masked[i++] = ' ';
+      while (i < src.size() && src[i] != quote && src[i] != '\n') {
+        if (src[i] == '\\' && i + 1 < src.size()) {
+          masked[i++] = ' ';
+        }
+        masked[i++] = ' ';
+      }
+      if (i < src.size() && src[i] == quote) {
+        masked[i++] = ' ';
+      }
+    } else {
+      ++i;
+    }
+  }
+  return masked;
+}
+
+// Return the offset of the bracket which closes the one at open, or npos.
+size_t FindClosingBracket(const string& masked, size_t open) {
+  const char open_char = masked[open];
+  const char close_char =
+      open_char == '(' ? ')' : (open_char == '[' ? ']' : '}');
+  int depth = 0;
+  for (size_t i = open; i < masked.size(); ++i) {
+    if (masked[i] == open_char) {
+      ++depth;
+    } else if (masked[i] == close_char && !--depth) {
+      return i;
+    }
+  }
+  return string::npos;
+}
+
+size_t SkipSpaces(const string& masked, size_t i) {
+  while (i < masked.size() && std::isspace(masked[i])) {
+    ++i;
+  }
+  return i;
+}
+
+bool IsWordAt(const string& masked, size_t i, const string& word) {
+  return !masked.compare(i, word.size(), word) &&
+         (i == 0 || !IsIdentifierChar(masked[i - 1])) &&
+         (i + word.size() == masked.size() ||
+          !IsIdentifierChar(masked[i + word.size()]));
+}
+
+// A kernel parameter, as parsed from the text of a parameter list.
+struct Param {
+  string name;
+  bool is_global_pointer;
+};
+
+// Split the text of a parameter list into parameters.
+std::vector<Param> ParseParams(const string& masked) {
+  std::vector<Param> params;
+  size_t start = 0;
+  int depth = 0;
+  for (size_t i = 0; i <= masked.size(); ++i) {
+    if (i < masked.size() && (masked[i] == '(' || masked[i] == '[')) {
+      ++depth;
+    } else if (i < masked.size() && (masked[i] == ')' || masked[i] == ']')) {
+      --depth;
+    } else if (i == masked.size() || (masked[i] == ',' && !depth)) {
+      const string text = masked.substr(start, i - start);
+      start = i + 1;
+
+      // The name is the last identifier of the parameter.
+      size_t end = text.find_last_of(
+          "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+      if (end == string::npos) {
+        continue;
+      }
+      size_t begin = end;
+      while (begin > 0 && IsIdentifierChar(text[begin - 1])) {
+        --begin;
+      }
+      Param param;
+      param.name = text.substr(begin, end - begin + 1);
+      if (param.name == "void" && params.empty()) {
+        continue;
+      }
+      bool is_global = false;
+      for (size_t j = 0; j < text.size(); ++j) {
+        if (IsWordAt(text, j, "global") || IsWordAt(text, j, "__global")) {
+          is_global = true;
+        }
+      }
+      param.is_global_pointer =
+          is_global && text.find('*') != string::npos;
+      params.push_back(param);
+    }
+  }
+  return params;
+}
+
+// Rewrite the subscripts of the global pointer parameters within
+// src[begin, end).
+string RewriteSubscripts(const string& src, const string& masked, size_t begin,
+                         size_t end, const std::vector<Param>& params) {
+  string out;
+  size_t i = begin;
+  while (i < end) {
+    if (!IsIdentifierChar(masked[i]) ||
+        (i > begin && IsIdentifierChar(masked[i - 1]))) {
+      out.push_back(src[i++]);
+      continue;
+    }
+
+    size_t word_end = i;
+    while (word_end < end && IsIdentifierChar(masked[word_end])) {
+      ++word_end;
+    }
+    const string word = masked.substr(i, word_end - i);
+
+    // Member accesses are not parameters.
+    size_t previous = i;
+    while (previous > begin && std::isspace(masked[previous - 1])) {
+      --previous;
+    }
+    const bool is_member =
+        previous > begin &&
+        (masked[previous - 1] == '.' ||
+         (masked[previous - 1] == '>' && previous > begin + 1 &&
+          masked[previous - 2] == '-'));
+
+    int arg_index = -1;
+    for (size_t j = 0; j < params.size() && !is_member; ++j) {
+      if (params[j].is_global_pointer && params[j].name == word) {
+        arg_index = j;
+      }
+    }
+
+    const size_t open = SkipSpaces(masked, word_end);
+    if (arg_index < 0 || open >= end || masked[open] != '[') {
+      out.append(src, i, word_end - i);
+      i = word_end;
+      continue;
+    }
+
+    const size_t close = FindClosingBracket(masked, open);
+    if (close == string::npos || close >= end) {
+      out.append(src, i, end - i);
+      break;
+    }
+
+    out.append(src, i, open - i);
+    out.append("[CLMEM_ACCESS(");
+    out.append(std::to_string(arg_index));
+    out.append(", ");
+    out.append(RewriteSubscripts(src, masked, open + 1, close, params));
+    out.append(")]");
+    i = close + 1;
+  }
+  return out;
+}
+
+}  // anonymous namespace
+
+string InstrumentAccesses(const string& src) {
+  const string masked = MaskCommentsAndLiterals(src);
+
+  string out = kInstrumentationPrelude;
+  size_t copied = 0;
+  for (size_t i = 0; i < masked.size(); ++i) {
+    if (!IsWordAt(masked, i, "kernel") && !IsWordAt(masked, i, "__kernel")) {
+      continue;
+    }
+
+    // The parameter list is the first parenthesized list after the name of
+    // the kernel, skipping any __attribute__((...)) qualifiers.
+    size_t open = i;
+    for (;;) {
+      open = masked.find('(', open);
+      if (open == string::npos) {
+        break;
+      }
+      size_t word_end = open;
+      while (word_end > 0 && std::isspace(masked[word_end - 1])) {
+        --word_end;
+      }
+      if (word_end < 13 || !IsWordAt(masked, word_end - 13, "__attribute__")) {
+        break;
+      }
+      open = FindClosingBracket(masked, open);
+      if (open == string::npos) {
+        break;
+      }
+    }
+    if (open == string::npos) {
+      break;
+    }
+    const size_t close = FindClosingBracket(masked, open);
+    if (close == string::npos) {
+      break;
+    }
+
+    const std::vector<Param> params =
+        ParseParams(masked.substr(open + 1, close - open - 1));
+
+    // Append the access ranges parameter, replacing an empty or void list.
+    out.append(src, copied, open + 1 - copied);
+    if (!params.empty()) {
+      out.append(src, open + 1, close - open - 1);
+      out.append(", ");
+    }
+    out.append("global int* ");
+    out.append(kAccessRangesArgName);
+    out.push_back(')');
+    copied = close + 1;
+
+    // Rewrite the body, if this is a definition rather than a declaration.
+    const size_t body = SkipSpaces(masked, close + 1);
+    if (body < masked.size() && masked[body] == '{') {
+      const size_t body_end = FindClosingBracket(masked, body);
+      if (body_end == string::npos) {
+        break;
+      }
+      out.append(src, copied, body - copied);
+      out.append(RewriteSubscripts(src, masked, body, body_end + 1, params));
+      copied = body_end + 1;
+    }
+    i = copied;
+  }
+  out.append(src, copied, string::npos);
+  return out;
+}
+
+}  // namespace util
+}  // namespace clmem
+}  // namespace gpu
@@ -0,0 +1,43 @@
+// Instrumentation of OpenCL kernels to record global memory accesses.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "labm8/cpp/string.h"
+
+namespace gpu {
+namespace clmem {
+namespace util {
+
+// The name of the argument which InstrumentAccesses() appends to kernels.
+extern const char* const kAccessRangesArgName;
+
+// Rewrite an OpenCL program so that every kernel records the range of indices
+// used to subscript each of its global memory arguments.
+//
+// Every kernel gains a trailing `global int*` argument of 2 * n elements,
+// where n is the number of its other arguments. Elements 2 * i and 2 * i + 1
+// receive the minimum and maximum index of argument i, through atomic_min()
+// and atomic_max(), so they must be initialized to INT_MAX and INT_MIN before
+// each run. Only subscripts of the form `arg[index]` within the body of the
+// kernel are recorded. Accesses through pointer arithmetic, or in functions
+// called by the kernel, are not.
+string InstrumentAccesses(const string& src);
+
+}  // namespace util
+}  // namespace clmem
+}  // namespace gpu
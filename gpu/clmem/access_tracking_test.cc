@@ -0,0 +1,94 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/access_tracking.h"
+
+#include "labm8/cpp/test.h"
+
+namespace gpu {
+namespace clmem {
+namespace util {
+namespace {
+
+TEST(InstrumentAccesses, AppendsAccessRangesArg) {
+  string src = InstrumentAccesses("kernel void A(global int* a, int n) {}");
+  EXPECT_NE(
+      src.find("kernel void A(global int* a, int n, "
+               "global int* clmem_access_ranges)"),
+      string::npos);
+}
+
+TEST(InstrumentAccesses, ReplacesEmptyArgList) {
+  string src = InstrumentAccesses("__kernel void A(void) {}");
+  EXPECT_NE(src.find("__kernel void A(global int* clmem_access_ranges)"),
+            string::npos);
+}
+
+TEST(InstrumentAccesses, RewritesGlobalSubscript) {
+  string src = InstrumentAccesses(
+      "kernel void A(global int* a, global int* b) {\n"
+      "  a[get_global_id(0)] = b[0];\n"
+      "}\n");
+  EXPECT_NE(src.find("a[CLMEM_ACCESS(0, get_global_id(0))] = "
+                     "b[CLMEM_ACCESS(1, 0)];"),
+            string::npos);
+}
+
+TEST(InstrumentAccesses, RewritesNestedSubscripts) {
+  string src = InstrumentAccesses(
+      "kernel void A(global int* a, global int* b) { a[b[1]] = 0; }");
+  EXPECT_NE(src.find("a[CLMEM_ACCESS(0, b[CLMEM_ACCESS(1, 1)])]"),
+            string::npos);
+}
+
+TEST(InstrumentAccesses, IgnoresLocalAndScalarArgs) {
+  string src = InstrumentAccesses(
+      "kernel void A(local int* a, int b, global int* c) { a[0] = c[1]; }");
+  EXPECT_NE(src.find("a[0] = c[CLMEM_ACCESS(2, 1)]"), string::npos);
+}
+
+TEST(InstrumentAccesses, IgnoresComments) {
+  string src = InstrumentAccesses(
+      "kernel void A(global int* a) {\n"
+      "  // a[1]\n"
+      "  /* a[2] */\n"
+      "}\n");
+  EXPECT_NE(src.find("// a[1]"), string::npos);
+  EXPECT_NE(src.find("/* a[2] */"), string::npos);
+}
+
+TEST(InstrumentAccesses, IgnoresMemberAccess) {
+  string src = InstrumentAccesses(
+      "kernel void A(global int* a, S s) { s.a[0] = a[1]; }");
+  EXPECT_NE(src.find("s.a[0] = a[CLMEM_ACCESS(0, 1)]"), string::npos);
+}
+
+TEST(InstrumentAccesses, MultipleKernels) {
+  string src = InstrumentAccesses(
+      "kernel void A(global int* a) { a[0] = 0; }\n"
+      "void B(global int* a) { a[0] = 0; }\n"
+      "kernel void C(int n, global int* a) { a[n] = 0; }\n");
+  EXPECT_NE(src.find("A(global int* a, global int* clmem_access_ranges)"),
+            string::npos);
+  EXPECT_NE(src.find("void B(global int* a) { a[0] = 0; }"), string::npos);
+  EXPECT_NE(src.find("a[CLMEM_ACCESS(1, n)]"), string::npos);
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace clmem
+}  // namespace gpu
+
+TEST_MAIN();
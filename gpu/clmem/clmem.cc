@@ -23,7 +23,9 @@
 // along with clmem.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/clmem/libclmem.h"
 
+#include "gpu/cldrive/shard_util.h"
 #include "gpu/clmem/logger.h"
+#include "gpu/clmem/mem_analysis.h"
 #include "gpu/clmem/proto/clmem.pb.h"
 #include "gpu/clinfo/libclinfo.h"
 
@@ -61,6 +63,34 @@ string ReadFileOrDie(const string& path) {
   return buffer.str();
 }
 
+// Write the fitted bounds of the first analyzed kernel of an instance to
+// <dir>/<basename>.json, the file read by cldrive's --mem_analysis_dir.
+void WriteMemAnalysisOrDie(const string& src_path, const string& dir,
+                           const gpu::clmem::ClmemInstance& instance) {
+  for (const auto& kernel : instance.kernel()) {
+    if (!kernel.arg_bound_size()) {
+      continue;
+    }
+    for (const auto& bound : kernel.arg_bound()) {
+      if (!bound.exact()) {
+        LOG(WARNING) << "Inexact bound for argument '" << bound.arg_name()
+                     << "' of kernel '" << kernel.name() << "'";
+      }
+    }
+
+    boost::filesystem::create_directories(dir);
+    const boost::filesystem::path path =
+        boost::filesystem::path(dir) /
+        boost::filesystem::path(src_path).filename().replace_extension(
+            ".json");
+    boost::filesystem::ofstream ostream(path);
+    CHECK(ostream.is_open()) << "Failed to open: '" << path.string() << "'";
+    ostream << gpu::clmem::util::ArgBoundsToJson(kernel);
+    return;
+  }
+  LOG(WARNING) << "No memory accesses recorded for '" << src_path << "'";
+}
+
 }  // anonymous namespace
 
 // Flag definitions ------------------------------------
@@ -118,6 +148,34 @@ DEFINE_int32(gsize, 1024,
 DEFINE_int32(lsize, 128, "The local (work group) size. Must be <= gsize.");
 DEFINE_string(cl_build_opt, "", "Build options passed to clBuildProgram().");
 DEFINE_int32(num_runs, 30, "The number of runs per kernel.");
+DEFINE_double(buffer_size_factor, 4,
+              "Allocate global memory buffers with this many times the "
+              "global size. Buffers are doubled if a run fails.");
+DEFINE_int32(max_buffer_growths, 4,
+             "The maximum number of times the buffers of a kernel are "
+             "doubled.");
+DEFINE_bool(track_accesses, false,
+            "Instrument kernels to record the range of indices used to "
+            "access each global memory argument. The ranges are recorded in "
+            "the pb and pbtxt output formats.");
+DEFINE_bool(analyze, false,
+            "Run each kernel over a sweep of launch configurations, fit the "
+            "largest index accessed of each argument to the global and local "
+            "sizes, and write the fit to --mem_analysis_dir for cldrive. "
+            "The sweep of a kernel ends early once every fit is exact. "
+            "Overrides --gsize and --lsize, and implies --track_accesses.");
+DEFINE_string(mem_analysis_dir, "mem_analysis_info",
+              "The directory to write the --analyze results to. For an "
+              "OpenCL source /path/to/file.cl, the results are written to "
+              "/path/to/mem_analysis_info/file.json. Only the results of the "
+              "first device are written.");
+DEFINE_int32(num_shards, 1,
+             "Split the sources into this many shards, and run only the "
+             "shard --shard_index. Shards are assigned by a consistent hash "
+             "of the source content and, without --analyze, the launch "
+             "config, so they are balanced, and a source keeps its shard as "
+             "sources are added to the corpus.");
+DEFINE_int32(shard_index, 0, "The shard to run, in [0, --num_shards).");
 DEFINE_bool(clinfo, false, "List the available devices and exit.");
 
 // End flag definitions ------------------------------------
@@ -191,6 +249,9 @@ int main(int argc, char** argv) {
   if (FLAGS_srcs.empty()) {
     LOG(FATAL) << "Flag --srcs must be set";
   }
+  const auto shard_status =
+      gpu::cldrive::util::ValidateShard(FLAGS_shard_index, FLAGS_num_shards);
+  CHECK(shard_status.ok()) << shard_status.error_message();
 
   auto devices = GetDevicesFromCommaSeparatedString(FLAGS_envs);
 
@@ -198,10 +259,23 @@ int main(int argc, char** argv) {
   gpu::clmem::ClmemInstances instances;
   gpu::clmem::ClmemInstance* instance = instances.add_instance();
   instance->set_build_opts(FLAGS_cl_build_opt);
-  auto dp = instance->add_dynamic_params();
-  dp->set_global_size_x(FLAGS_gsize);
-  dp->set_local_size_x(FLAGS_lsize);
+  if (FLAGS_analyze) {
+    for (const auto& dp : gpu::clmem::util::SampleMemAnalysisDynamicParams()) {
+      *instance->add_dynamic_params() = dp;
+    }
+  } else {
+    auto dp = instance->add_dynamic_params();
+    dp->set_global_size_x(FLAGS_gsize);
+    dp->set_local_size_x(FLAGS_lsize);
+  }
   instance->set_min_runs_per_kernel(FLAGS_num_runs);
+  instance->set_buffer_size_factor(FLAGS_buffer_size_factor);
+  instance->set_max_buffer_growths(FLAGS_max_buffer_growths);
+  instance->set_track_accesses(FLAGS_track_accesses || FLAGS_analyze);
+  instance->set_analyze_bounds(FLAGS_analyze);
+  if (FLAGS_num_shards > 1) {
+    instance->set_shard_index(FLAGS_shard_index);
+  }
 
   // Parse logger flag.
   std::unique_ptr<gpu::clmem::Logger> logger =
@@ -212,6 +286,19 @@ int main(int argc, char** argv) {
     logger->StartNewInstance();
     instance->set_opencl_src(ReadFileOrDie(path));
 
+    // The sweep of --analyze is a single unit of work, so it is sharded by
+    // the source alone.
+    const int shard =
+        FLAGS_analyze
+            ? gpu::cldrive::util::GetShard(instance->opencl_src(),
+                                           FLAGS_num_shards)
+            : gpu::cldrive::util::GetShard(instance->opencl_src(), FLAGS_gsize,
+                                           FLAGS_lsize, FLAGS_num_shards);
+    if (shard != FLAGS_shard_index) {
+      ++instance_num;
+      continue;
+    }
+
     for (size_t i = 0; i < devices.size(); ++i) {
       // Reset fields from previous loop iterations.
       instance->clear_outcome();
@@ -220,6 +307,10 @@ int main(int argc, char** argv) {
       *instance->mutable_device() = devices[i];
 
       gpu::clmem::Clmem(instance, instance_num).RunOrDie(*logger);
+
+      if (FLAGS_analyze && !i) {
+        WriteMemAnalysisOrDie(path, FLAGS_mem_analysis_dir, *instance);
+      }
     }
 
     ++instance_num;
@@ -79,6 +79,12 @@ labm8::Status KernelArg::Init(cl::Kernel* kernel, size_t arg_index) {
 
 const OpenClType& KernelArg::type() const { return type_; }
 
+size_t KernelArg::ElementSizeInBytes() const {
+  // A local memory value allocates nothing, so a single element value is a
+  // cheap way to look up the size of the type.
+  return util::CreateLocalMemoryArgValue(type(), /*size=*/1)->SizeInBytes();
+}
+
 std::unique_ptr<KernelArgValue> KernelArg::TryToCreateRandomValue(
     const cl::Context& context, const DynamicParams& dynamic_params) const {
   return TryToCreateKernelArgValue(context, dynamic_params,
@@ -117,12 +123,12 @@ std::unique_ptr<KernelArgValue> KernelArg::TryToCreateKernelArgValue(
   if (IsPointer() && IsGlobal()) {
     return util::CreateGlobalMemoryArgValue(
         type(), context,
-        /*size=*/dynamic_params.global_size_x(), // large number of elements for mem analysis
+        /*size=*/dynamic_params.global_size_x(),
         /*value=*/1, rand_values);
   } else if (IsPointer() && IsLocal()) {
     return util::CreateLocalMemoryArgValue(
         type(),
-        /*size=*/dynamic_params.global_size_x()); // large number of elements for mem analysis
+        /*size=*/dynamic_params.global_size_x());
   } else if (!IsPointer()) {
     return util::CreateScalarArgValue(type(),
                                       /*value=*/dynamic_params.global_size_x());
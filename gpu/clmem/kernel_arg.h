@@ -56,6 +56,9 @@ class KernelArg {
 
   const OpenClType &type() const;
 
+  // Return the size in bytes of one element of the argument type.
+  size_t ElementSizeInBytes() const;
+
  private:
   std::unique_ptr<KernelArgValue> TryToCreateKernelArgValue(
       const cl::Context &context, const DynamicParams &dynamic_params,
@@ -23,10 +23,13 @@
 namespace gpu {
 namespace clmem {
 
-KernelArgSet::KernelArgSet(cl::Kernel* kernel) : kernel_(kernel) {}
+KernelArgSet::KernelArgSet(cl::Kernel* kernel, size_t num_instrumentation_args)
+    : kernel_(kernel), num_instrumentation_args_(num_instrumentation_args) {}
 
 ClmemKernelInstance::KernelInstanceOutcome KernelArgSet::Init() {
   size_t num_args = kernel_->getInfo<CL_KERNEL_NUM_ARGS>();
+  CHECK(num_args >= num_instrumentation_args_);
+  num_args -= num_instrumentation_args_;
   if (!num_args) {
     LOG(WARNING) << "Kernel '" << util::GetOpenClKernelName(*kernel_)
                  << "' has no arguments";
@@ -75,6 +78,27 @@ labm8::Status KernelArgSet::SetRandom(const cl::Context& context,
   return labm8::Status::OK;
 }
 
+labm8::Status KernelArgSet::SetRandom(
+    const cl::Context& context, const std::vector<long long>& args_array_bound,
+    KernelArgValuesSet* values) {
+  CHECK(args_array_bound.size() == args_.size());
+  values->Clear();
+  for (size_t i = 0; i < args_.size(); ++i) {
+    DynamicParams dynamic_params;
+    dynamic_params.set_global_size_x(args_array_bound[i]);
+    auto value = args_[i].TryToCreateRandomValue(context, dynamic_params);
+    if (value) {
+      values->AddKernelArgValue(std::move(value));
+    } else {
+      // TryToCreateRandomValue() returns nullptr if the argument is not
+      // supported.
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Unsupported argument type.");
+    }
+  }
+  return labm8::Status::OK;
+}
+
 labm8::Status KernelArgSet::SetOnes(const cl::Context& context,
                                     const DynamicParams& dynamic_params,
                                     KernelArgValuesSet* values) {
@@ -93,5 +117,25 @@ labm8::Status KernelArgSet::SetOnes(const cl::Context& context,
   return labm8::Status::OK;
 }
 
+labm8::Status KernelArgSet::SetDynamicParams(
+    const cl::Context& context, const DynamicParams& dynamic_params,
+    KernelArgValuesSet* values) {
+  CHECK(values->values().size() == args_.size());
+  for (size_t i = 0; i < args_.size(); ++i) {
+    if (args_[i].IsPointer()) {
+      continue;
+    }
+    auto value = args_[i].TryToCreateRandomValue(context, dynamic_params);
+    if (!value) {
+      return labm8::Status(labm8::error::Code::INVALID_ARGUMENT,
+                           "Unsupported argument type.");
+    }
+    values->values()[i] = std::move(value);
+  }
+  return labm8::Status::OK;
+}
+
+const std::vector<KernelArg>& KernelArgSet::args() const { return args_; }
+
 }  // namespace clmem
 }  // namespace gpu
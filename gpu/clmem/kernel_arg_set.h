@@ -26,7 +26,9 @@ namespace clmem {
 
 class KernelArgSet {
  public:
-  KernelArgSet(cl::Kernel* kernel);
+  // The last num_instrumentation_args arguments of the kernel are added by
+  // instrumentation, and are not driven by this set.
+  KernelArgSet(cl::Kernel* kernel, size_t num_instrumentation_args = 0);
 
   ClmemKernelInstance::KernelInstanceOutcome LogErrorOutcome(
       const ClmemKernelInstance::KernelInstanceOutcome& outcome);
@@ -37,12 +39,27 @@ class KernelArgSet {
                           const DynamicParams& dynamic_params,
                           KernelArgValuesSet* values);
 
+  // Create values with args_array_bound[i] elements for pointer argument i.
+  // Scalar arguments are set to their bound.
+  labm8::Status SetRandom(const cl::Context& context,
+                          const std::vector<long long>& args_array_bound,
+                          KernelArgValuesSet* values);
+
   labm8::Status SetOnes(const cl::Context& context,
                         const DynamicParams& dynamic_params,
                         KernelArgValuesSet* values);
 
+  // Update the scalar values of a set created by SetRandom() for new dynamic
+  // params. Pointer values are left unchanged.
+  labm8::Status SetDynamicParams(const cl::Context& context,
+                                 const DynamicParams& dynamic_params,
+                                 KernelArgValuesSet* values);
+
+  const std::vector<KernelArg>& args() const;
+
  private:
   cl::Kernel* kernel_;
+  size_t num_instrumentation_args_;
   std::vector<KernelArg> args_;
 };
 
@@ -23,7 +23,31 @@
 #include "labm8/cpp/logging.h"
 #include "labm8/cpp/status_macros.h"
 
-#define MAX_ARRAY_SIZE 10000000
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+// The minimum number of runs before an exact fit of the bounds may end
+// memory analysis of a kernel.
+const int kMinMemAnalysisRuns = 8;
+
+// Return whether an OpenCL error may be caused by a kernel accessing beyond
+// the end of its buffers, or by the buffers being too large for the device.
+// Other errors are not retried with larger buffers.
+bool IsBufferError(cl_int error) {
+  switch (error) {
+    case CL_OUT_OF_RESOURCES:
+    case CL_OUT_OF_HOST_MEMORY:
+    case CL_MEM_OBJECT_ALLOCATION_FAILURE:
+    case CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // anonymous namespace
 
 namespace gpu {
 namespace clmem {
@@ -40,7 +64,8 @@ KernelDriver::KernelDriver(const cl::Context& context,
       instance_num_(instance_num),
       kernel_instance_(instance->add_kernel()),
       name_(util::GetOpenClKernelName(kernel)),
-      args_set_(&kernel_) {}
+      args_set_(&kernel_, instance->track_accesses() ? 1 : 0),
+      num_buffer_growths_(0) {}
 
 void KernelDriver::RunOrDie(Logger& logger) {
   kernel_instance_->set_name(name_);
@@ -57,30 +82,61 @@ void KernelDriver::RunOrDie(Logger& logger) {
                      /*log=*/nullptr);
     return;
   }
-  // preallocate the buffer for kernel arguments, 
-  // since the size is fixed for all dynamic params 
-  // (we does not know the size of the buffer before analysis)
-  gpu::clmem::DynamicParams temp_dp;
-  temp_dp.set_global_size_x(MAX_ARRAY_SIZE);
-  temp_dp.set_local_size_x(1);
+  if (!instance_.dynamic_params_size()) {
+    return;
+  }
+
+  // The ranges buffer is the argument after those of the uninstrumented
+  // kernel.
+  if (instance_.track_accesses()) {
+    const size_t num_args = args_set_.args().size();
+    access_ranges_ = cl::Buffer(context_, CL_MEM_READ_WRITE,
+                                sizeof(cl_int) * 2 * num_args);
+    kernel_.setArg(num_args, access_ranges_);
+  }
+
+  // Allocate the buffers once for every dynamic params. The extent of the
+  // accesses is not known before the analysis, so the buffers are larger
+  // than the global size, and grow if a run fails.
+  InitArgArrayBounds();
   KernelArgValuesSet inputs;
-  auto args_status = args_set_.SetRandom(context_, temp_dp, &inputs);
-  if (!args_status.ok()) {
+  if (!AllocateInputs(&inputs).ok()) {
     LOG(WARNING) << "Unsupported params for kernel: '" << name_ << "'";
     logger.RecordLog(&instance_, kernel_instance_, /*run=*/nullptr, 
                     /*log=*/nullptr);
     return;
   }
 
+  if (instance_.analyze_bounds()) {
+    CHECK(instance_.track_accesses())
+        << "Bounds analysis requires access tracking";
+    bound_regressions_.clear();
+    bound_regressions_.resize(args_set_.args().size());
+  }
+
   // run experiment for all dynamic params, record the results
   for (int i = 0; i < instance_.dynamic_params_size(); ++i) {
     auto run = RunDynamicParams(instance_.dynamic_params(i), logger, inputs);
     if (run.ok()) {
       *kernel_instance_->add_run() = run.ValueOrDie();
     } else {
+      // The inputs are unusable, so the remaining dynamic params cannot run.
+      LOG(WARNING) << "Stopping kernel '" << name_
+                   << "': " << run.status().error_message();
       kernel_instance_->clear_run();
       kernel_instance_->set_outcome(
           ClmemKernelInstance::UNSUPPORTED_ARGUMENTS);
+      logger.RecordLog(&instance_, kernel_instance_, /*run=*/nullptr,
+                       /*log=*/nullptr);
+      break;
+    }
+
+    if (instance_.analyze_bounds() && run.ok() &&
+        UpdateArgBounds(instance_.dynamic_params(i), run.ValueOrDie()) &&
+        i + 1 >= kMinMemAnalysisRuns) {
+      LOG(INFO) << "Bounds of kernel '" << name_ << "' are exact after "
+                << i + 1 << " runs";
+      break;
     }
   }
 }
@@ -89,18 +145,211 @@ labm8::StatusOr<ClmemKernelRun> KernelDriver::RunDynamicParams(
     const DynamicParams& dynamic_params, Logger& logger, KernelArgValuesSet& inputs) {
   ClmemKernelRun run;
 
+  for (;;) {
+    bool out_of_range = false;
+    bool may_grow = true;
+    try {
+      out_of_range = RunDynamicParams(dynamic_params, logger, &run, inputs)
+                         .code() == labm8::error::Code::OUT_OF_RANGE;
+      if (!out_of_range) {
+        break;
+      }
+      LOG(WARNING) << "Kernel '" << name_
+                   << "' accessed beyond the end of its arguments";
+    } catch (cl::Error error) {
+      LOG(WARNING) << "Error code " << error.err() << " ("
+                   << labm8::gpu::clinfo::OpenClErrorString(error.err())
+                   << ") raised by " << error.what()
+                   << "() while driving kernel: '" << name_ << "'";
+      may_grow = IsBufferError(error.err());
+    }
+
+    // An access beyond the end of a buffer surfaces as an error from the
+    // kernel or the transfers which follow it, or is caught by access
+    // tracking. Retry with larger buffers until they reach the device limit.
+    bool grown = false;
+    if (may_grow) {
+      labm8::Status grow_status = GrowInputs(&inputs);
+      if (grow_status.code() == labm8::error::Code::INTERNAL) {
+        logger.ClearBuffer();
+        return grow_status;
+      }
+      grown = grow_status.ok();
+    }
+    if (!grown && out_of_range) {
+      // The recorded ranges are still correct, so keep the run.
+      logger.PrintAndClearBuffer();
+      break;
+    }
+    logger.ClearBuffer();
+    run.Clear();
+    if (!grown) {
+      run.set_outcome(ClmemKernelRun::CL_ERROR);
+      logger.RecordLog(&instance_, kernel_instance_, &run, /*log=*/nullptr);
+      break;
+    }
+  }
+
+  return run;
+}
+
+void KernelDriver::InitArgArrayBounds() {
+  long long max_size = 0;
+  for (const auto& dynamic_params : instance_.dynamic_params()) {
+    max_size = std::max(max_size,
+                        static_cast<long long>(std::max(
+                            dynamic_params.global_size_x(),
+                            dynamic_params.local_size_x())));
+  }
+  const long long buffer_size = std::max(
+      static_cast<long long>(max_size * instance_.buffer_size_factor()), 1LL);
+  const cl_ulong max_alloc_size =
+      device_.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+
+  args_array_bound_.clear();
+  kernel_instance_->clear_arg_array_bounds();
+  for (const auto& arg : args_set_.args()) {
+    long long bound = max_size;
+    if (arg.IsPointer() && arg.IsGlobal()) {
+      bound = std::min(
+          buffer_size,
+          static_cast<long long>(max_alloc_size / arg.ElementSizeInBytes()));
+    }
+    args_array_bound_.push_back(bound);
+    kernel_instance_->add_arg_array_bounds(bound);
+  }
+}
+
+labm8::Status KernelDriver::AllocateInputs(KernelArgValuesSet* inputs) {
   try {
-    RunDynamicParams(dynamic_params, logger, &run, inputs);
+    return args_set_.SetRandom(context_, args_array_bound_, inputs);
   } catch (cl::Error error) {
     LOG(WARNING) << "Error code " << error.err() << " ("
                  << labm8::gpu::clinfo::OpenClErrorString(error.err()) << ") "
-                 << "raised by " << error.what() << "() while driving kernel: '"
-                 << name_ << "'";
-    run.set_outcome(ClmemKernelRun::CL_ERROR);
-    logger.RecordLog(&instance_, kernel_instance_, &run, /*log=*/nullptr);
+                 << "raised by " << error.what()
+                 << "() while allocating arguments for kernel: '" << name_
+                 << "'";
+    return labm8::Status(labm8::error::Code::RESOURCE_EXHAUSTED,
+                         "Unable to allocate arguments");
   }
+}
 
-  return run;
+labm8::Status KernelDriver::GrowInputs(KernelArgValuesSet* inputs) {
+  const cl_ulong max_alloc_size =
+      device_.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+
+  if (num_buffer_growths_ >= instance_.max_buffer_growths()) {
+    return labm8::Status(labm8::error::Code::OUT_OF_RANGE,
+                         "Arguments have grown max_buffer_growths times");
+  }
+
+  const std::vector<long long> previous_bounds = args_array_bound_;
+  bool grown = false;
+  for (size_t i = 0; i < args_set_.args().size(); ++i) {
+    const auto& arg = args_set_.args()[i];
+    if (!arg.IsPointer() || !arg.IsGlobal()) {
+      continue;
+    }
+    const long long max_bound =
+        static_cast<long long>(max_alloc_size / arg.ElementSizeInBytes());
+    const long long bound = std::min(args_array_bound_[i] * 2, max_bound);
+    if (bound > args_array_bound_[i]) {
+      args_array_bound_[i] = bound;
+      grown = true;
+    }
+  }
+  if (!grown) {
+    return labm8::Status(labm8::error::Code::OUT_OF_RANGE,
+                         "Arguments are at the device limit");
+  }
+
+  ++num_buffer_growths_;
+  LOG(INFO) << "Growing argument buffers of kernel '" << name_ << "'";
+  if (!AllocateInputs(inputs).ok()) {
+    // Re-create the inputs at their previous size, so that the remaining
+    // dynamic params may run.
+    LOG(WARNING) << "Unable to grow arguments for kernel: '" << name_ << "'";
+    args_array_bound_ = previous_bounds;
+    if (!AllocateInputs(inputs).ok()) {
+      return labm8::Status(labm8::error::Code::INTERNAL,
+                           "Unable to re-create arguments");
+    }
+    return labm8::Status(labm8::error::Code::RESOURCE_EXHAUSTED,
+                         "Unable to grow arguments");
+  }
+
+  kernel_instance_->clear_arg_array_bounds();
+  for (auto bound : args_array_bound_) {
+    kernel_instance_->add_arg_array_bounds(bound);
+  }
+  return labm8::Status::OK;
+}
+
+void KernelDriver::ResetAccessRanges() {
+  std::vector<cl_int> ranges(2 * args_set_.args().size());
+  for (size_t i = 0; i < ranges.size(); i += 2) {
+    ranges[i] = INT_MAX;
+    ranges[i + 1] = INT_MIN;
+  }
+  queue_.enqueueWriteBuffer(access_ranges_, /*blocking=*/CL_TRUE,
+                            /*offset=*/0, sizeof(cl_int) * ranges.size(),
+                            ranges.data());
+}
+
+bool KernelDriver::ReadAccessRanges(ClmemKernelRun* run) {
+  std::vector<cl_int> ranges(2 * args_set_.args().size());
+  queue_.enqueueReadBuffer(access_ranges_, /*blocking=*/CL_TRUE,
+                           /*offset=*/0, sizeof(cl_int) * ranges.size(),
+                           ranges.data());
+
+  bool in_range = true;
+  for (size_t i = 0; i < args_set_.args().size(); ++i) {
+    const cl_int min_index = ranges[2 * i];
+    const cl_int max_index = ranges[2 * i + 1];
+    if (max_index < min_index) {
+      continue;  // Not accessed.
+    }
+    ArgAccessRange* range = run->add_access_range();
+    range->set_arg_index(i);
+    range->set_min_index(min_index);
+    range->set_max_index(max_index);
+    if (max_index >= args_array_bound_[i]) {
+      in_range = false;
+    }
+  }
+  return in_range;
+}
+
+bool KernelDriver::UpdateArgBounds(const DynamicParams& dynamic_params,
+                                   const ClmemKernelRun& run) {
+  if (run.outcome() != ClmemKernelRun::PASS) {
+    return false;
+  }
+  for (const auto& range : run.access_range()) {
+    bound_regressions_[range.arg_index()].AddSample(
+        dynamic_params.global_size_x(), dynamic_params.local_size_x(),
+        range.max_index());
+  }
+
+  bool exact = true;
+  kernel_instance_->clear_arg_bound();
+  for (size_t i = 0; i < bound_regressions_.size(); ++i) {
+    auto& regression = bound_regressions_[i];
+    if (!regression.num_samples()) {
+      continue;
+    }
+    const bool determined = regression.Fit();
+    ArgBound* bound = kernel_instance_->add_arg_bound();
+    bound->set_arg_index(i);
+    bound->set_arg_name(util::GetKernelArgName(kernel_, i));
+    bound->set_gsize_coef(regression.gsize_coef());
+    bound->set_lsize_coef(regression.lsize_coef());
+    bound->set_intercept(regression.intercept());
+    bound->set_num_samples(regression.num_samples());
+    bound->set_exact(regression.IsExact());
+    exact &= determined && bound->exact();
+  }
+  return exact && kernel_instance_->arg_bound_size();
 }
 
 namespace {
@@ -139,10 +388,22 @@ labm8::Status KernelDriver::RunDynamicParams(
                          "Unsupported dynamic params");
   }
   KernelArgValuesSet output_b;
+  CHECK(args_set_.SetDynamicParams(context_, dynamic_params, &inputs).ok());
   inputs.SetAsArgs(&kernel_);
+  if (instance_.track_accesses()) {
+    ResetAccessRanges();
+  }
   *run->add_log() = RunOnceOrDie(dynamic_params, inputs, &output_b, run, logger,
                                  /*flush=*/false);
 
+  // Leave the logs buffered if the kernel overran its buffers, so that the
+  // caller may discard the run and retry with larger buffers.
+  if (instance_.track_accesses() && !ReadAccessRanges(run)) {
+    run->set_outcome(ClmemKernelRun::PASS);
+    return labm8::Status(labm8::error::Code::OUT_OF_RANGE,
+                         "Access beyond the end of an argument");
+  }
+
   // We've passed the point of rejecting the kernel. Flush the buffered logs
   // from the preliminary runs.
   logger.PrintAndClearBuffer();
@@ -17,11 +17,14 @@
 
 #include "gpu/clmem/kernel_arg_set.h"
 #include "gpu/clmem/logger.h"
+#include "gpu/clmem/mem_analysis.h"
 #include "gpu/clmem/proto/clmem.pb.h"
 #include "labm8/cpp/statusor.h"
 #include "labm8/cpp/string.h"
 #include "third_party/opencl/cl.hpp"
 
+#include <vector>
+
 namespace gpu {
 namespace clmem {
 
@@ -52,6 +55,39 @@ class KernelDriver {
                                  Logger& logger, ClmemKernelRun* run, 
                                  KernelArgValuesSet &inputs);
 
+  // Set args_array_bound_ to the initial number of elements of each argument.
+  // Global memory arguments are sized for the largest dynamic params, scaled
+  // by the instance's buffer size factor, and capped to the largest buffer
+  // the device can allocate.
+  void InitArgArrayBounds();
+
+  // Create the inputs with the sizes in args_array_bound_. OpenCL errors are
+  // returned as RESOURCE_EXHAUSTED. On error, the inputs must not be used.
+  labm8::Status AllocateInputs(KernelArgValuesSet* inputs);
+
+  // Double the size of every global memory buffer which is below the device
+  // limit, and re-create the inputs. Returns OUT_OF_RANGE if no buffer can
+  // grow, or the buffers have already grown max_buffer_growths times, leaving
+  // the inputs unchanged. If the larger buffers cannot be allocated, the
+  // inputs are re-created at their previous size and RESOURCE_EXHAUSTED is
+  // returned. Returns INTERNAL if the inputs cannot be re-created either, in
+  // which case they must not be used.
+  labm8::Status GrowInputs(KernelArgValuesSet* inputs);
+
+  // Reset the access ranges buffer before a run of an instrumented kernel.
+  void ResetAccessRanges();
+
+  // Read the access ranges buffer after a run of an instrumented kernel and
+  // add the ranges to the run. Returns false if any argument was accessed
+  // beyond the end of its buffer.
+  bool ReadAccessRanges(ClmemKernelRun* run);
+
+  // Add the access ranges of a run to the bound regressions and record the
+  // refitted bounds in the kernel instance. Returns true if every bound is
+  // determined and exact, so that no more dynamic params need be run.
+  bool UpdateArgBounds(const DynamicParams& dynamic_params,
+                       const ClmemKernelRun& run);
+
   cl::Context context_;
   cl::CommandQueue queue_;
   cl::Device device_;
@@ -61,6 +97,14 @@ class KernelDriver {
   ClmemKernelInstance* kernel_instance_;
   string name_;
   KernelArgSet args_set_;
+  // The number of elements allocated for each argument.
+  std::vector<long long> args_array_bound_;
+  int num_buffer_growths_;
+  // If the instance tracks accesses, the {min, max} index of each argument
+  // recorded by the instrumented kernel.
+  cl::Buffer access_ranges_;
+  // If the instance analyzes bounds, a regression for each argument.
+  std::vector<util::BoundRegression> bound_regressions_;
 };
 
 }  // namespace clmem
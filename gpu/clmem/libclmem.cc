@@ -15,6 +15,7 @@
 // along with clmem.  If not, see <https://www.gnu.org/licenses/>.
 #include "gpu/clmem/libclmem.h"
 
+#include "gpu/clmem/access_tracking.h"
 #include "gpu/clmem/kernel_arg_value.h"
 #include "gpu/clmem/kernel_driver.h"
 #include "gpu/clinfo/libclinfo.h"
@@ -92,8 +93,12 @@ void Clmem::DoRunOrDie(Logger& logger) {
                          /*properties=*/CL_QUEUE_PROFILING_ENABLE);
 
   // Compile program or fail.
-  labm8::StatusOr<cl::Program> program_or = BuildOpenClProgram(
-      string(instance_->opencl_src()), context, instance_->build_opts());
+  string opencl_src = instance_->opencl_src();
+  if (instance_->track_accesses()) {
+    opencl_src = util::InstrumentAccesses(opencl_src);
+  }
+  labm8::StatusOr<cl::Program> program_or =
+      BuildOpenClProgram(opencl_src, context, instance_->build_opts());
   if (!program_or.ok()) {
     LOG(ERROR) << "OpenCL program compilation failed!";
     instance_->set_outcome(ClmemInstance::PROGRAM_COMPILATION_FAILURE);
@@ -0,0 +1,162 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/mem_analysis.h"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace gpu {
+namespace clmem {
+namespace util {
+
+BoundRegression::BoundRegression() : coef_{0, 0, 0} {}
+
+void BoundRegression::AddSample(long long global_size, long long local_size,
+                                long long max_index) {
+  samples_.push_back({static_cast<double>(global_size),
+                      static_cast<double>(local_size),
+                      static_cast<double>(max_index)});
+}
+
+int BoundRegression::num_samples() const { return samples_.size(); }
+
+bool BoundRegression::Fit() {
+  // Solve the normal equations (X^T X) coef = X^T y, where the rows of X are
+  // {gsize, lsize, 1}, by Gaussian elimination with partial pivoting.
+  double a[3][4] = {};
+  for (const auto& sample : samples_) {
+    const double x[3] = {sample.global_size, sample.local_size, 1};
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        a[i][j] += x[i] * x[j];
+      }
+      a[i][3] += x[i] * sample.max_index;
+    }
+  }
+
+  double max_diagonal = 0;
+  for (int i = 0; i < 3; ++i) {
+    max_diagonal = std::max(max_diagonal, a[i][i]);
+  }
+  const double tolerance = max_diagonal * 1e-12;
+
+  bool determined = true;
+  int pivot_column[3] = {-1, -1, -1};
+  int row = 0;
+  for (int col = 0; col < 3 && row < 3; ++col) {
+    int pivot = row;
+    for (int i = row + 1; i < 3; ++i) {
+      if (std::abs(a[i][col]) > std::abs(a[pivot][col])) {
+        pivot = i;
+      }
+    }
+    if (std::abs(a[pivot][col]) <= tolerance) {
+      // The column is dependent on the previous ones.
+      determined = false;
+      continue;
+    }
+    std::swap(a[row], a[pivot]);
+    for (int i = 0; i < 3; ++i) {
+      if (i == row) {
+        continue;
+      }
+      const double factor = a[i][col] / a[row][col];
+      for (int j = col; j < 4; ++j) {
+        a[i][j] -= factor * a[row][j];
+      }
+    }
+    pivot_column[row++] = col;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    coef_[i] = 0;
+  }
+  for (int i = 0; i < row; ++i) {
+    coef_[pivot_column[i]] = a[i][3] / a[i][pivot_column[i]];
+  }
+  return determined;
+}
+
+bool BoundRegression::IsExact() const {
+  for (const auto& sample : samples_) {
+    const double prediction = coef_[0] * sample.global_size +
+                              coef_[1] * sample.local_size + coef_[2];
+    if (std::round(prediction) != sample.max_index) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double BoundRegression::gsize_coef() const { return coef_[0]; }
+
+double BoundRegression::lsize_coef() const { return coef_[1]; }
+
+double BoundRegression::intercept() const { return coef_[2]; }
+
+std::vector<DynamicParams> SampleMemAnalysisDynamicParams(unsigned int seed) {
+  const std::vector<int> local_sizes = {4, 16, 24, 32};
+  const int num_work_group_sizes = 50;
+  const int max_work_group_size = 80;
+  const int max_global_size = 99999;
+
+  std::mt19937 rng(seed);
+  std::vector<int> work_group_sizes;
+  for (int i = 1; i < max_work_group_size; ++i) {
+    work_group_sizes.push_back(i);
+  }
+  std::shuffle(work_group_sizes.begin(), work_group_sizes.end(), rng);
+  work_group_sizes.resize(num_work_group_sizes);
+
+  std::vector<DynamicParams> dynamic_params;
+  for (auto local_size : local_sizes) {
+    for (auto work_group_size : work_group_sizes) {
+      int global_size = local_size * work_group_size;
+      if (global_size > max_global_size) {
+        global_size = local_size * (max_global_size / local_size);
+      }
+      DynamicParams params;
+      params.set_global_size_x(global_size);
+      params.set_local_size_x(local_size);
+      dynamic_params.push_back(params);
+    }
+  }
+  std::shuffle(dynamic_params.begin(), dynamic_params.end(), rng);
+
+  return dynamic_params;
+}
+
+string ArgBoundsToJson(const ClmemKernelInstance& kernel_instance) {
+  Json::Value root(Json::objectValue);
+  for (const auto& bound : kernel_instance.arg_bound()) {
+    Json::Value& arg = root[bound.arg_name()];
+    arg["coef"].append(bound.gsize_coef());
+    arg["coef"].append(bound.lsize_coef());
+    arg["coef"].append(bound.intercept());
+    arg["arg_id"] = bound.arg_index();
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, root);
+}
+
+}  // namespace util
+}  // namespace clmem
+}  // namespace gpu
@@ -0,0 +1,81 @@
+// Memory analysis: fitting the array bounds of kernel arguments to the launch
+// configuration.
+//
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+#include "gpu/clmem/proto/clmem.pb.h"
+
+#include "labm8/cpp/string.h"
+
+#include <vector>
+
+namespace gpu {
+namespace clmem {
+namespace util {
+
+// Fit the largest index used to access an argument as a linear function of
+// the launch configuration:
+//     max_index = gsize_coef * gsize + lsize_coef * lsize + intercept
+// by least squares.
+class BoundRegression {
+ public:
+  BoundRegression();
+
+  void AddSample(long long global_size, long long local_size,
+                 long long max_index);
+
+  int num_samples() const;
+
+  // Fit the model to the samples. Returns false if the samples do not
+  // determine the model, i.e. there are fewer than three, or the global and
+  // local sizes of the samples are linearly dependent. The coefficients of
+  // an underdetermined model are still set, with the undetermined ones zero.
+  bool Fit();
+
+  // Return true if the fitted model predicts every sample, after rounding.
+  bool IsExact() const;
+
+  double gsize_coef() const;
+  double lsize_coef() const;
+  double intercept() const;
+
+ private:
+  struct Sample {
+    double global_size;
+    double local_size;
+    double max_index;
+  };
+  std::vector<Sample> samples_;
+  double coef_[3];
+};
+
+// Sample the sweep of launch configurations used for memory analysis. This
+// mirrors run_mem_analysis.py: 4 local sizes and 50 work group counts in
+// [1, 80), in a random order, so that a prefix of the sweep varies both
+// sizes.
+std::vector<DynamicParams> SampleMemAnalysisDynamicParams(
+    unsigned int seed = 2610);
+
+// Serialize the fitted bounds of a kernel to the JSON format read by
+// cldrive's --mem_analysis_dir:
+//     {"<arg_name>": {"coef": [gsize, lsize, intercept], "arg_id": <index>}}
+string ArgBoundsToJson(const ClmemKernelInstance& kernel_instance);
+
+}  // namespace util
+}  // namespace clmem
+}  // namespace gpu
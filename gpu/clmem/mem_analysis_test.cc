@@ -0,0 +1,108 @@
+// Copyright (c) 2016-2020 Chris Cummins.
+// This file is part of clmem.
+//
+// clmem is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// clmem is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with clmem.  If not, see <https://www.gnu.org/licenses/>.
+#include "gpu/clmem/mem_analysis.h"
+
+#include "labm8/cpp/test.h"
+
+#include <set>
+#include <utility>
+
+namespace gpu {
+namespace clmem {
+namespace util {
+namespace {
+
+TEST(BoundRegression, ExactLinearFit) {
+  BoundRegression regression;
+  regression.AddSample(128, 16, 2 * 128 + 3 * 16 - 1);
+  regression.AddSample(256, 16, 2 * 256 + 3 * 16 - 1);
+  regression.AddSample(256, 32, 2 * 256 + 3 * 32 - 1);
+  regression.AddSample(1024, 4, 2 * 1024 + 3 * 4 - 1);
+  EXPECT_TRUE(regression.Fit());
+  EXPECT_NEAR(regression.gsize_coef(), 2, 1e-6);
+  EXPECT_NEAR(regression.lsize_coef(), 3, 1e-6);
+  EXPECT_NEAR(regression.intercept(), -1, 1e-6);
+  EXPECT_TRUE(regression.IsExact());
+}
+
+TEST(BoundRegression, InexactFit) {
+  BoundRegression regression;
+  regression.AddSample(128, 16, 127);
+  regression.AddSample(256, 16, 255);
+  regression.AddSample(256, 32, 255);
+  regression.AddSample(1024, 4, 0);
+  EXPECT_TRUE(regression.Fit());
+  EXPECT_FALSE(regression.IsExact());
+}
+
+TEST(BoundRegression, TooFewSamplesIsUnderdetermined) {
+  BoundRegression regression;
+  regression.AddSample(128, 16, 127);
+  regression.AddSample(256, 16, 255);
+  EXPECT_FALSE(regression.Fit());
+  EXPECT_TRUE(regression.IsExact());
+}
+
+TEST(BoundRegression, ConstantLocalSizeIsUnderdetermined) {
+  BoundRegression regression;
+  regression.AddSample(128, 16, 127);
+  regression.AddSample(256, 16, 255);
+  regression.AddSample(512, 16, 511);
+  EXPECT_FALSE(regression.Fit());
+  EXPECT_NEAR(regression.gsize_coef(), 1, 1e-6);
+  EXPECT_TRUE(regression.IsExact());
+}
+
+TEST(SampleMemAnalysisDynamicParams, NumberOfSamples) {
+  auto dynamic_params = SampleMemAnalysisDynamicParams();
+  EXPECT_EQ(dynamic_params.size(), 200);
+  std::set<std::pair<int, int>> distinct;
+  for (const auto& params : dynamic_params) {
+    EXPECT_EQ(params.global_size_x() % params.local_size_x(), 0);
+    distinct.insert({params.global_size_x(), params.local_size_x()});
+  }
+  EXPECT_EQ(distinct.size(), 200);
+}
+
+TEST(SampleMemAnalysisDynamicParams, PrefixDeterminesFit) {
+  auto dynamic_params = SampleMemAnalysisDynamicParams();
+  BoundRegression regression;
+  for (int i = 0; i < 8; ++i) {
+    regression.AddSample(dynamic_params[i].global_size_x(),
+                         dynamic_params[i].local_size_x(),
+                         dynamic_params[i].global_size_x() - 1);
+  }
+  EXPECT_TRUE(regression.Fit());
+}
+
+TEST(ArgBoundsToJson, Format) {
+  ClmemKernelInstance kernel_instance;
+  ArgBound* bound = kernel_instance.add_arg_bound();
+  bound->set_arg_index(1);
+  bound->set_arg_name("a");
+  bound->set_gsize_coef(1);
+  bound->set_lsize_coef(0);
+  bound->set_intercept(-1);
+  EXPECT_EQ(ArgBoundsToJson(kernel_instance),
+            "{\"a\":{\"arg_id\":1,\"coef\":[1.0,0.0,-1.0]}}");
+}
+
+}  // anonymous namespace
+}  // namespace util
+}  // namespace clmem
+}  // namespace gpu
+
+TEST_MAIN();
@@ -68,7 +68,10 @@ string GetOpenClKernelName(const cl::Kernel& kernel) {
   return name;
 }
 
-string GetKernelArgTypeName(const cl::Kernel& kernel, size_t arg_index) {
+namespace {
+
+string GetKernelArgInfoString(const cl::Kernel& kernel, size_t arg_index,
+                              cl_kernel_arg_info param_name) {
   // Rather than determine the size of the character array needed to store the
   // string, allocate a buffer that *should be* large enough. This is a
   // workaround for a bug in an OpenCL implementation.
@@ -76,12 +79,12 @@ string GetKernelArgTypeName(const cl::Kernel& kernel, size_t arg_index) {
   char* chars = new char[buffer_size];
 
   size_t actual_size;
-  CHECK(clGetKernelArgInfo(
-            kernel(), arg_index, CL_KERNEL_ARG_TYPE_NAME, buffer_size, chars,
-            /*param_value_size_ret=*/&actual_size) == CL_SUCCESS);
+  CHECK(clGetKernelArgInfo(kernel(), arg_index, param_name, buffer_size, chars,
+                           /*param_value_size_ret=*/&actual_size) ==
+        CL_SUCCESS);
 
   CHECK(actual_size <= buffer_size)
-      << "OpenCL kernel name exceeds " << buffer_size << " characters";
+      << "OpenCL kernel arg info exceeds " << buffer_size << " characters";
 
   // Construct a string from the buffer.
   string name(chars);
@@ -92,6 +95,16 @@ string GetKernelArgTypeName(const cl::Kernel& kernel, size_t arg_index) {
   return name;
 }
 
+}  // anonymous namespace
+
+string GetKernelArgTypeName(const cl::Kernel& kernel, size_t arg_index) {
+  return GetKernelArgInfoString(kernel, arg_index, CL_KERNEL_ARG_TYPE_NAME);
+}
+
+string GetKernelArgName(const cl::Kernel& kernel, size_t arg_index) {
+  return GetKernelArgInfoString(kernel, arg_index, CL_KERNEL_ARG_NAME);
+}
+
 }  // namespace util
 }  // namespace clmem
 }  // namespace gpu
@@ -41,6 +41,9 @@ string GetOpenClKernelName(const cl::Kernel &kernel);
 // Get the type name of a kernel argument.
 string GetKernelArgTypeName(const cl::Kernel &kernel, size_t arg_index);
 
+// Get the name of a kernel argument.
+string GetKernelArgName(const cl::Kernel &kernel, size_t arg_index);
+
 }  // namespace util
 }  // namespace clmem
 }  // namespace gpu